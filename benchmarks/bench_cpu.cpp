@@ -0,0 +1,95 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "cpu.h"
+
+namespace
+{
+uint16_t const program_start{0x0600};
+// A block core step() runs many ops, so every core is timed over the same
+// number of emulated cycles rather than steps
+uint64_t const cycles_per_run{60000000};
+
+// Tight loop mixing immediate, zero page, absolute indexed, implied,
+// relative and absolute modes
+std::vector<uint8_t> const program{
+    0xA2, 0x00,       // LDX #$00
+    0xBD, 0x00, 0x02, // LDA $0200,X  <- loop
+    0x65, 0x10,       // ADC $10
+    0x85, 0x10,       // STA $10
+    0xE8,             // INX
+    0xE0, 0xFF,       // CPX #$FF
+    0xD0, 0xF4,       // BNE loop
+    0x4C, 0x00, 0x06  // JMP $0600
+};
+
+double cycles_per_second(emulator::CPUCore core, bool lazy_flags)
+{
+    emulator::PPU ppu;
+    emulator::CPU cpu(&ppu);
+
+    for (auto i = 0u; i < program.size(); i++)
+    {
+        cpu.write8(program_start + i, program[i]);
+    }
+
+    cpu.set_core(core);
+    cpu.set_lazy_flags(lazy_flags);
+    cpu.set_program_counter(program_start);
+
+    auto start = std::chrono::steady_clock::now();
+
+    cpu.run_until(cycles_per_run);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return cycles_per_run / elapsed.count();
+}
+}
+
+int main()
+{
+    auto table    = cycles_per_second(emulator::CPUCore::function_table, false);
+    auto switched = cycles_per_second(emulator::CPUCore::switch_dispatch, false);
+    auto lazy     = cycles_per_second(emulator::CPUCore::switch_dispatch, true);
+    auto blocks   = cycles_per_second(emulator::CPUCore::cached_blocks, true);
+    auto jit      = cycles_per_second(emulator::CPUCore::jit, true);
+
+    std::cout << "function table:  " << static_cast<uint64_t>(table)    << " cycles/s" << std::endl
+              << "switch dispatch: " << static_cast<uint64_t>(switched) << " cycles/s "
+              << "(" << switched / table << "x)" << std::endl
+              << "+ lazy flags:    " << static_cast<uint64_t>(lazy)     << " cycles/s "
+              << "(" << lazy / table << "x)" << std::endl
+              << "+ block cache:   " << static_cast<uint64_t>(blocks)   << " cycles/s "
+              << "(" << blocks / table << "x)" << std::endl
+              << "+ jit:           " << static_cast<uint64_t>(jit)      << " cycles/s "
+              << "(" << jit / table << "x)" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "pixel_kernels.h"
+
+namespace
+{
+size_t const tiles_per_run{1 << 22};
+size_t const lines_per_run{1 << 18};
+size_t const line_width{256};
+
+struct Timing
+{
+    double tiles_per_second;
+    double lines_per_second;
+
+    // Sum of the results, printed so the work can't be optimised away. Every
+    // SIMD level should come out the same.
+    uint32_t checksum;
+};
+
+Timing time_kernels(emulator::SimdLevel level)
+{
+    auto const& kernels = emulator::pixel_kernels(level);
+
+    std::mt19937 random{1234};
+
+    // Spread over a whole pattern table so it isn't one tile in L1
+    std::array<uint8_t, 0x1000> planes;
+    std::array<uint8_t, 64> pixels;
+    for (auto& plane : planes)
+    {
+        plane = random();
+    }
+
+    std::array<uint8_t, line_width> background;
+    std::array<uint8_t, line_width> sprites;
+    for (size_t x = 0; x < line_width; x++)
+    {
+        background[x] = random() & 0x0F;
+        sprites[x]    = x % 8 ? 0 : random() & (0x0F | emulator::sprite_behind);
+    }
+
+    std::array<uint8_t, 32> palette;
+    std::array<uint32_t, 64> colors;
+    for (uint32_t i = 0; i < palette.size(); i++)
+    {
+        palette[i] = i;
+    }
+    for (uint32_t i = 0; i < colors.size(); i++)
+    {
+        colors[i] = i * 0x01010100 | 0xFF;
+    }
+
+    std::array<uint8_t, line_width> out;
+    std::array<uint32_t, line_width> rgba;
+
+    uint32_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t tile = 0; tile < tiles_per_run; tile++)
+    {
+        kernels.decode_tile(planes.data() + (tile & 0xFF) * 16, pixels.data());
+        sink += pixels[tile & 0x3F];
+    }
+
+    auto middle = std::chrono::steady_clock::now();
+
+    for (size_t line = 0; line < lines_per_run; line++)
+    {
+        sink += kernels.compose_line(background.data(), sprites.data(), palette.data(),
+                                     colors.data(), out.data(), rgba.data(), line_width);
+        sink += rgba[line & 0xFF];
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> decode  = middle - start;
+    std::chrono::duration<double> compose = end - middle;
+
+    return {tiles_per_run / decode.count(), lines_per_run / compose.count(), sink};
+}
+
+void report(char const* name, emulator::SimdLevel level, Timing const& scalar)
+{
+    if (!emulator::is_supported(level))
+    {
+        std::cout << name << "not supported" << std::endl;
+        return;
+    }
+
+    auto timing = time_kernels(level);
+
+    std::cout << name
+              << static_cast<uint64_t>(timing.tiles_per_second) << " tiles/s "
+              << "(" << timing.tiles_per_second / scalar.tiles_per_second << "x), "
+              << static_cast<uint64_t>(timing.lines_per_second) << " lines/s "
+              << "(" << timing.lines_per_second / scalar.lines_per_second << "x), "
+              << "checksum " << std::hex << timing.checksum << std::dec << std::endl;
+}
+}
+
+int main()
+{
+    auto scalar = time_kernels(emulator::SimdLevel::scalar);
+
+    report("scalar: ", emulator::SimdLevel::scalar, scalar);
+    report("sse2:   ", emulator::SimdLevel::sse2, scalar);
+    report("avx2:   ", emulator::SimdLevel::avx2, scalar);
+
+    return 0;
+}
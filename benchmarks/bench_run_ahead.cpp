@@ -0,0 +1,156 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "console.h"
+#include "run_ahead.h"
+
+namespace
+{
+int const frames_per_run{600};
+uint8_t const max_frames_ahead{3};
+uint8_t const red{0x16};
+
+// Same as the run-ahead test: shows A held by turning the backdrop red, a
+// frame after the NMI that read it
+std::vector<uint8_t> const program{
+    0xA9, 0x01, 0x8D, 0x15, 0x40, // LDA #$01, STA $4015
+    0xA9, 0xBF, 0x8D, 0x00, 0x40, // LDA #$BF, STA $4000
+    0xA9, 0xFD, 0x8D, 0x02, 0x40, // LDA #$FD, STA $4002
+    0xA9, 0x00, 0x8D, 0x03, 0x40, // LDA #$00, STA $4003
+    0xA9, 0x80, 0x8D, 0x00, 0x20, // LDA #$80, STA $2000
+    0x4C, 0x19, 0x80,             // JMP $8019
+    0xEA, 0xEA, 0xEA, 0xEA,       // NOPs up to 0x8020
+    0xA9, 0x3F, 0x8D, 0x06, 0x20, // LDA #$3F, STA $2006
+    0xA9, 0x00, 0x8D, 0x06, 0x20, // LDA #$00, STA $2006
+    0xA5, 0x00,                   // LDA $00
+    0x8D, 0x07, 0x20,             // STA $2007
+    0xA9, 0x01, 0x8D, 0x16, 0x40, // LDA #$01, STA $4016
+    0xA9, 0x00, 0x8D, 0x16, 0x40, // LDA #$00, STA $4016
+    0xAD, 0x16, 0x40,             // LDA $4016
+    0x29, 0x01,                   // AND #$01
+    0xF0, 0x04,                   // BEQ $8044
+    0xA9, red,                    // LDA #red
+    0x85, 0x00,                   // STA $00
+    0xE6, 0x01,                   // INC $01
+    0x40                          // RTI
+};
+
+std::unique_ptr<emulator::ConsoleBase> make_console()
+{
+    std::vector<uint8_t> image{'N', 'E', 'S', 0x1A, 1, 1, 0, 0,
+                               0, 0, 0, 0, 0, 0, 0, 0};
+
+    std::vector<uint8_t> prg(0x4000);
+    std::copy(program.begin(), program.end(), prg.begin());
+    prg[0x3FFA] = 0x20;
+    prg[0x3FFB] = 0x80;
+    prg[0x3FFC] = 0x00;
+    prg[0x3FFD] = 0x80;
+
+    image.insert(image.end(), prg.begin(), prg.end());
+    image.resize(image.size() + 0x2000);
+
+    auto console = emulator::make_console(emulator::Rom(image));
+    console->reset();
+
+    return console;
+}
+
+struct Timing
+{
+    int latency_frames;
+    double save_us;
+    double load_us;
+    double frame_us;
+    size_t state_size;
+};
+
+Timing time_run_ahead(uint8_t frames_ahead)
+{
+    auto console = make_console();
+    emulator::RunAhead run_ahead(console.get(), frames_ahead);
+    run_ahead.set_audio_handler([] (emulator::APU& apu) {
+        int16_t samples[2048];
+        apu.read_samples(samples, std::min(apu.samples_available(), sizeof(samples) / sizeof(samples[0])));
+    });
+
+    Timing timing{-1, 0, 0, 0, 0};
+    std::chrono::nanoseconds saving{0};
+    std::chrono::nanoseconds loading{0};
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < frames_per_run; frame++)
+    {
+        // Pressed half way, the latency is frames until it shows
+        if (frame == frames_per_run / 2)
+        {
+            console->controller(0).press(emulator::button_a);
+        }
+
+        run_ahead.run_frame();
+
+        saving  += run_ahead.save_time();
+        loading += run_ahead.load_time();
+
+        if (timing.latency_frames < 0 && frame >= frames_per_run / 2 &&
+            console->ppu().framebuffer()[0] == red)
+        {
+            timing.latency_frames = frame - frames_per_run / 2 + 1;
+        }
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    timing.save_us    = std::chrono::duration<double, std::micro>(saving).count() / frames_per_run;
+    timing.load_us    = std::chrono::duration<double, std::micro>(loading).count() / frames_per_run;
+    timing.frame_us   = elapsed.count() / frames_per_run;
+    timing.state_size = run_ahead.state_size();
+
+    return timing;
+}
+}
+
+int main()
+{
+    for (uint8_t frames_ahead = 0; frames_ahead <= max_frames_ahead; frames_ahead++)
+    {
+        auto timing = time_run_ahead(frames_ahead);
+
+        std::cout << static_cast<int>(frames_ahead) << " frames ahead: "
+                  << timing.latency_frames << " frames latency, "
+                  << timing.frame_us << "us a frame, save "
+                  << timing.save_us << "us, load "
+                  << timing.load_us << "us, "
+                  << timing.state_size << " byte state" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,1191 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "apu.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+std::array<uint8_t, 32> const length_table{{
+    10, 254, 20,  2, 40,  4, 80,  6, 160,  8, 60, 10, 14, 12, 26, 14,
+    12,  16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30
+}};
+
+std::array<std::array<uint8_t, 8>, 4> const duty_table{{
+    {{0, 1, 0, 0, 0, 0, 0, 0}},
+    {{0, 1, 1, 0, 0, 0, 0, 0}},
+    {{0, 1, 1, 1, 1, 0, 0, 0}},
+    {{1, 0, 0, 1, 1, 1, 1, 1}}
+}};
+
+// In CPU cycles
+std::array<uint16_t, 16> const noise_periods{{
+    4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068
+}};
+
+std::array<uint16_t, 16> const dmc_rates{{
+    428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54
+}};
+
+// Frame counter steps in CPU cycles from when the sequence started, the last
+// step is where it starts over
+std::array<uint32_t, 4> const four_step_sequence{{7457, 14913, 22371, 29829}};
+std::array<uint32_t, 5> const five_step_sequence{{7457, 14913, 22371, 29829, 37281}};
+
+uint32_t const four_step_period{29830};
+uint32_t const five_step_period{37282};
+
+// Linear mixer weights per output level, scaled to 16 bit samples
+int32_t const pulse_weight{246};
+int32_t const triangle_weight{279};
+int32_t const noise_weight{162};
+int32_t const dmc_weight{110};
+
+// Sample headroom for a few frames that haven't been read yet
+size_t const buffered_frames{8};
+uint32_t const frames_per_second{60};
+
+uint16_t const dmc_control_register{0x4010};
+uint16_t const status_register{0x4015};
+uint16_t const frame_counter_register{0x4017};
+
+// These change when the next IRQ is due, so can't wait in the queue
+bool is_deferred(uint16_t address)
+{
+    return address != dmc_control_register &&
+           address != status_register &&
+           address != frame_counter_register;
+}
+
+void set_amplitude(emulator::BlipBuffer& out, uint32_t time, int32_t& amplitude, int32_t level)
+{
+    if (level != amplitude)
+    {
+        out.add_delta(time, level - amplitude);
+        amplitude = level;
+    }
+}
+
+// Moves time past end in whole periods, for timers that run without the
+// output changing
+uint32_t skip_periods(uint32_t time, uint32_t end, uint32_t period, uint32_t& count)
+{
+    count = 0;
+
+    if (time < end)
+    {
+        count = (end - time + period - 1) / period;
+        time += count * period;
+    }
+
+    return time;
+}
+}
+
+/*
+ * Envelope
+ */
+void emulator::APU::Envelope::write(uint8_t value)
+{
+    loop     = value & 0x20;
+    constant = value & 0x10;
+    volume   = value & 0x0F;
+}
+
+void emulator::APU::Envelope::clock()
+{
+    if (start)
+    {
+        start   = false;
+        decay   = 15;
+        divider = volume;
+    }
+    else if (divider == 0)
+    {
+        divider = volume;
+
+        if (decay > 0)
+        {
+            decay--;
+        }
+        else if (loop)
+        {
+            decay = 15;
+        }
+    }
+    else
+    {
+        divider--;
+    }
+}
+
+uint8_t emulator::APU::Envelope::output() const
+{
+    return constant ? volume : decay;
+}
+
+void emulator::APU::Envelope::save(SaveState& state) const
+{
+    state.write(volume);
+    state.write(constant);
+    state.write(loop);
+    state.write(start);
+    state.write(divider);
+    state.write(decay);
+}
+
+void emulator::APU::Envelope::load(SaveState& state)
+{
+    state.read(volume);
+    state.read(constant);
+    state.read(loop);
+    state.read(start);
+    state.read(divider);
+    state.read(decay);
+}
+
+/*
+ * Pulse
+ */
+emulator::APU::Pulse::Pulse(bool ones_complement) :
+    ones_complement(ones_complement)
+{
+}
+
+void emulator::APU::Pulse::write(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+        case 0:
+            duty = value >> 6;
+            envelope.write(value);
+            break;
+        case 1:
+            sweep_enabled = value & 0x80;
+            sweep_period  = value >> 4 & 0x07;
+            sweep_negate  = value & 0x08;
+            sweep_shift   = value & 0x07;
+            sweep_reload  = true;
+            break;
+        case 2:
+            period = (period & 0x0700) | value;
+            break;
+        case 3:
+            period = (period & 0x00FF) | (value & 0x07) << 8;
+
+            if (enabled)
+            {
+                length = length_table[value >> 3];
+            }
+
+            phase          = 0;
+            envelope.start = true;
+            break;
+    }
+}
+
+void emulator::APU::Pulse::clock_quarter()
+{
+    envelope.clock();
+}
+
+void emulator::APU::Pulse::clock_half()
+{
+    if (length && !envelope.loop)
+    {
+        length--;
+    }
+
+    if (sweep_divider == 0 && sweep_enabled && sweep_shift && !muted())
+    {
+        period = sweep_target();
+    }
+
+    if (sweep_divider == 0 || sweep_reload)
+    {
+        sweep_divider = sweep_period;
+        sweep_reload  = false;
+    }
+    else
+    {
+        sweep_divider--;
+    }
+}
+
+uint16_t emulator::APU::Pulse::sweep_target() const
+{
+    uint16_t change = period >> sweep_shift;
+
+    if (!sweep_negate)
+    {
+        return period + change;
+    }
+
+    // Pulse 1 negates with ones' complement, so it goes one lower
+    return period - change - (ones_complement ? 1 : 0);
+}
+
+bool emulator::APU::Pulse::muted() const
+{
+    return period < 8 || (!sweep_negate && sweep_target() > 0x07FF);
+}
+
+void emulator::APU::Pulse::run(uint32_t start, uint32_t end, BlipBuffer& out)
+{
+    // The sequencer steps every other CPU cycle
+    uint32_t timer_period = (period + 1) * 2;
+    int32_t volume        = length && !muted() ? envelope.output() * pulse_weight : 0;
+    uint32_t time         = start + delay;
+
+    set_amplitude(out, start, amplitude, duty_table[duty][phase] * volume);
+
+    if (!volume)
+    {
+        uint32_t steps = 0;
+        time  = skip_periods(time, end, timer_period, steps);
+        phase = (phase + steps) & 0x07;
+    }
+    else
+    {
+        auto const& sequence = duty_table[duty];
+
+        for (; time < end; time += timer_period)
+        {
+            phase = (phase + 1) & 0x07;
+            set_amplitude(out, time, amplitude, sequence[phase] * volume);
+        }
+    }
+
+    delay = time - end;
+}
+
+void emulator::APU::Pulse::save(SaveState& state) const
+{
+    envelope.save(state);
+
+    state.write(duty);
+    state.write(phase);
+    state.write(period);
+    state.write(delay);
+    state.write(enabled);
+    state.write(length);
+    state.write(sweep_enabled);
+    state.write(sweep_period);
+    state.write(sweep_negate);
+    state.write(sweep_shift);
+    state.write(sweep_divider);
+    state.write(sweep_reload);
+    state.write(amplitude);
+}
+
+void emulator::APU::Pulse::load(SaveState& state)
+{
+    envelope.load(state);
+
+    state.read(duty);
+    state.read(phase);
+    state.read(period);
+    state.read(delay);
+    state.read(enabled);
+    state.read(length);
+    state.read(sweep_enabled);
+    state.read(sweep_period);
+    state.read(sweep_negate);
+    state.read(sweep_shift);
+    state.read(sweep_divider);
+    state.read(sweep_reload);
+    state.read(amplitude);
+}
+
+/*
+ * Triangle
+ */
+void emulator::APU::Triangle::write(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+        case 0:
+            control       = value & 0x80;
+            linear_reload = value & 0x7F;
+            break;
+        case 2:
+            period = (period & 0x0700) | value;
+            break;
+        case 3:
+            period = (period & 0x00FF) | (value & 0x07) << 8;
+
+            if (enabled)
+            {
+                length = length_table[value >> 3];
+            }
+
+            linear_reload_flag = true;
+            break;
+    }
+}
+
+void emulator::APU::Triangle::clock_quarter()
+{
+    if (linear_reload_flag)
+    {
+        linear_counter = linear_reload;
+    }
+    else if (linear_counter)
+    {
+        linear_counter--;
+    }
+
+    if (!control)
+    {
+        linear_reload_flag = false;
+    }
+}
+
+void emulator::APU::Triangle::clock_half()
+{
+    if (length && !control)
+    {
+        length--;
+    }
+}
+
+uint8_t emulator::APU::Triangle::level() const
+{
+    return phase < 16 ? 15 - phase : phase - 16;
+}
+
+void emulator::APU::Triangle::run(uint32_t start, uint32_t end, BlipBuffer& out)
+{
+    uint32_t timer_period = period + 1;
+    uint32_t time         = start + delay;
+
+    set_amplitude(out, start, amplitude, level() * triangle_weight);
+
+    // Halted where it is rather than stepping, periods under 2 are far above
+    // hearing and would only alias
+    if (!length || !linear_counter || period < 2)
+    {
+        uint32_t steps = 0;
+        time = skip_periods(time, end, timer_period, steps);
+    }
+    else
+    {
+        for (; time < end; time += timer_period)
+        {
+            phase = (phase + 1) & 0x1F;
+            set_amplitude(out, time, amplitude, level() * triangle_weight);
+        }
+    }
+
+    delay = time - end;
+}
+
+void emulator::APU::Triangle::save(SaveState& state) const
+{
+    state.write(phase);
+    state.write(period);
+    state.write(delay);
+    state.write(enabled);
+    state.write(length);
+    state.write(control);
+    state.write(linear_reload);
+    state.write(linear_counter);
+    state.write(linear_reload_flag);
+    state.write(amplitude);
+}
+
+void emulator::APU::Triangle::load(SaveState& state)
+{
+    state.read(phase);
+    state.read(period);
+    state.read(delay);
+    state.read(enabled);
+    state.read(length);
+    state.read(control);
+    state.read(linear_reload);
+    state.read(linear_counter);
+    state.read(linear_reload_flag);
+    state.read(amplitude);
+}
+
+/*
+ * Noise
+ */
+void emulator::APU::Noise::write(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+        case 0:
+            envelope.write(value);
+            break;
+        case 2:
+            mode         = value & 0x80;
+            period_index = value & 0x0F;
+            break;
+        case 3:
+            if (enabled)
+            {
+                length = length_table[value >> 3];
+            }
+
+            envelope.start = true;
+            break;
+    }
+}
+
+void emulator::APU::Noise::clock_quarter()
+{
+    envelope.clock();
+}
+
+void emulator::APU::Noise::clock_half()
+{
+    if (length && !envelope.loop)
+    {
+        length--;
+    }
+}
+
+void emulator::APU::Noise::run(uint32_t start, uint32_t end, BlipBuffer& out)
+{
+    uint32_t timer_period = noise_periods[period_index];
+    int32_t volume        = length ? envelope.output() * noise_weight : 0;
+    uint32_t time         = start + delay;
+    int tap               = mode ? 6 : 1;
+
+    set_amplitude(out, start, amplitude, shift & 0x01 ? 0 : volume);
+
+    // The shift register keeps running when silent so it picks up where real
+    // hardware would
+    for (; time < end; time += timer_period)
+    {
+        uint16_t feedback = (shift ^ shift >> tap) & 0x01;
+        shift = shift >> 1 | feedback << 14;
+
+        set_amplitude(out, time, amplitude, shift & 0x01 ? 0 : volume);
+    }
+
+    delay = time - end;
+}
+
+void emulator::APU::Noise::save(SaveState& state) const
+{
+    envelope.save(state);
+
+    state.write(mode);
+    state.write(period_index);
+    state.write(shift);
+    state.write(delay);
+    state.write(enabled);
+    state.write(length);
+    state.write(amplitude);
+}
+
+void emulator::APU::Noise::load(SaveState& state)
+{
+    envelope.load(state);
+
+    state.read(mode);
+    state.read(period_index);
+    state.read(shift);
+    state.read(delay);
+    state.read(enabled);
+    state.read(length);
+    state.read(amplitude);
+}
+
+/*
+ * DMC
+ */
+void emulator::APU::DMC::write(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+        case 0:
+            irq_enabled = value & 0x80;
+            loop        = value & 0x40;
+            rate_index  = value & 0x0F;
+
+            if (!irq_enabled)
+            {
+                irq_flag = false;
+            }
+            break;
+        case 1:
+            output_level = value & 0x7F;
+            break;
+        case 2:
+            sample_address = 0xC000 + value * 64;
+            break;
+        case 3:
+            sample_length = value * 16 + 1;
+            break;
+    }
+}
+
+void emulator::APU::DMC::restart()
+{
+    address         = sample_address;
+    bytes_remaining = sample_length;
+}
+
+void emulator::APU::DMC::fill()
+{
+    if (buffer_full || !bytes_remaining)
+    {
+        return;
+    }
+
+    buffer      = reader ? reader(address) : 0;
+    buffer_full = true;
+
+    // Wraps to 0x8000, not 0x0000
+    address = address == 0xFFFF ? 0x8000 : address + 1;
+
+    if (--bytes_remaining == 0)
+    {
+        if (loop)
+        {
+            restart();
+        }
+        else if (irq_enabled)
+        {
+            irq_flag = true;
+        }
+    }
+}
+
+bool emulator::APU::DMC::irq_due(uint32_t& cycles) const
+{
+    if (!irq_enabled || loop || !bytes_remaining)
+    {
+        return false;
+    }
+
+    // The buffer is full whenever bytes remain, the next fetch is when the
+    // shift register next empties and every 8 bits after that
+    uint32_t ticks = bits_remaining + (bytes_remaining - 1) * 8u;
+    cycles = delay + (ticks - 1) * dmc_rates[rate_index];
+
+    return true;
+}
+
+void emulator::APU::DMC::run(uint32_t start, uint32_t end, BlipBuffer& out)
+{
+    uint32_t timer_period = dmc_rates[rate_index];
+    uint32_t time         = start + delay;
+
+    set_amplitude(out, start, amplitude, output_level * dmc_weight);
+
+    // Nothing playing or about to, count the output cycles off in one go
+    if (silence && !buffer_full)
+    {
+        uint32_t ticks = 0;
+        time = skip_periods(time, end, timer_period, ticks);
+        bits_remaining = (bits_remaining + 7 - ticks % 8) % 8 + 1;
+    }
+    else
+    {
+        for (; time < end; time += timer_period)
+        {
+            if (!silence)
+            {
+                if (shift & 0x01)
+                {
+                    if (output_level <= 125)
+                    {
+                        output_level += 2;
+                    }
+                }
+                else if (output_level >= 2)
+                {
+                    output_level -= 2;
+                }
+
+                set_amplitude(out, time, amplitude, output_level * dmc_weight);
+            }
+
+            shift >>= 1;
+
+            if (--bits_remaining == 0)
+            {
+                bits_remaining = 8;
+
+                if (buffer_full)
+                {
+                    shift       = buffer;
+                    buffer_full = false;
+                    silence     = false;
+                    fill();
+                }
+                else
+                {
+                    silence = true;
+                }
+            }
+        }
+    }
+
+    delay = time - end;
+}
+
+void emulator::APU::DMC::save(SaveState& state) const
+{
+    state.write(irq_enabled);
+    state.write(irq_flag);
+    state.write(loop);
+    state.write(rate_index);
+    state.write(delay);
+    state.write(output_level);
+    state.write(sample_address);
+    state.write(sample_length);
+    state.write(address);
+    state.write(bytes_remaining);
+    state.write(shift);
+    state.write(bits_remaining);
+    state.write(silence);
+    state.write(buffer);
+    state.write(buffer_full);
+    state.write(amplitude);
+}
+
+void emulator::APU::DMC::load(SaveState& state)
+{
+    state.read(irq_enabled);
+    state.read(irq_flag);
+    state.read(loop);
+    state.read(rate_index);
+    state.read(delay);
+    state.read(output_level);
+    state.read(sample_address);
+    state.read(sample_length);
+    state.read(address);
+    state.read(bytes_remaining);
+    state.read(shift);
+    state.read(bits_remaining);
+    state.read(silence);
+    state.read(buffer);
+    state.read(buffer_full);
+    state.read(amplitude);
+}
+
+/*
+ * APU
+ */
+emulator::APU::APU(uint32_t sample_rate) :
+    output(cpu_clock_rate, sample_rate, sample_rate / frames_per_second * buffered_frames)
+{
+    reset();
+}
+
+void emulator::APU::reset()
+{
+    pulse_1  = Pulse{true};
+    pulse_2  = Pulse{false};
+    triangle = Triangle{};
+    noise    = Noise{};
+
+    auto reader = dmc.reader;
+    dmc         = DMC{};
+    dmc.reader  = reader;
+
+    five_step_mode       = false;
+    irq_inhibit          = false;
+    frame_irq            = false;
+    queued               = 0;
+    frame_step           = 0;
+    frame_sequence_start = timestamp_;
+
+    // Lets go of the line if it was holding it
+    if (irq_raised && interrupt_request_handler)
+    {
+        interrupt_request_handler(false);
+    }
+    irq_raised = false;
+
+    if (scheduler)
+    {
+        scheduler->cancel(Event::apu_frame_counter);
+        schedule_irq();
+    }
+}
+
+void emulator::APU::set_interrupt_request_handler(std::function<void(bool asserted)> const& irq_handler)
+{
+    interrupt_request_handler = irq_handler;
+}
+
+void emulator::APU::set_scheduler(Scheduler* scheduler)
+{
+    this->scheduler = scheduler;
+
+    scheduler->set_handler(Event::apu_frame_counter, [this] (uint64_t when) {
+        catch_up(when);
+        update_irq();
+    });
+
+    schedule_irq();
+}
+
+void emulator::APU::set_clock(std::function<uint64_t()> const& clock)
+{
+    this->clock = clock;
+}
+
+void emulator::APU::set_memory_reader(std::function<uint8_t(uint16_t address)> const& reader)
+{
+    dmc.reader = reader;
+}
+
+uint64_t emulator::APU::now() const
+{
+    return clock ? clock() : timestamp_;
+}
+
+uint64_t emulator::APU::timestamp() const
+{
+    return timestamp_;
+}
+
+uint32_t emulator::APU::frame_time(uint64_t cycle) const
+{
+    return static_cast<uint32_t>(cycle - frame_start);
+}
+
+void emulator::APU::write_register(uint16_t address, uint8_t value)
+{
+    auto cycle = now();
+
+    if (is_deferred(address))
+    {
+        if (queued == write_queue.size())
+        {
+            catch_up(cycle);
+        }
+
+        write_queue[queued++] = {cycle, address, value};
+        return;
+    }
+
+    catch_up(cycle);
+    apply_write(address, value);
+    update_irq();
+}
+
+size_t emulator::APU::queued_writes() const
+{
+    return queued;
+}
+
+bool emulator::APU::fetching_samples() const
+{
+    if (dmc.bytes_remaining)
+    {
+        return true;
+    }
+
+    return std::any_of(write_queue.begin(), write_queue.begin() + queued, [] (RegisterWrite const& write) {
+        return write.address == 0x4015;
+    });
+}
+
+void emulator::APU::apply_write(uint16_t address, uint8_t value)
+{
+    if (address < 0x4004)
+    {
+        pulse_1.write(address & 0x03, value);
+    }
+    else if (address < 0x4008)
+    {
+        pulse_2.write(address & 0x03, value);
+    }
+    else if (address < 0x400C)
+    {
+        triangle.write(address & 0x03, value);
+    }
+    else if (address < 0x4010)
+    {
+        noise.write(address & 0x03, value);
+    }
+    else if (address < 0x4014)
+    {
+        dmc.write(address & 0x03, value);
+    }
+    else if (address == status_register)
+    {
+        write_status(value);
+    }
+    else if (address == frame_counter_register)
+    {
+        write_frame_counter(value);
+    }
+}
+
+uint8_t emulator::APU::read_status()
+{
+    catch_up(now());
+
+    uint8_t status = (pulse_1.length  ? 0x01 : 0) |
+                     (pulse_2.length  ? 0x02 : 0) |
+                     (triangle.length ? 0x04 : 0) |
+                     (noise.length    ? 0x08 : 0) |
+                     (dmc.bytes_remaining ? 0x10 : 0) |
+                     (frame_irq    ? 0x40 : 0) |
+                     (dmc.irq_flag ? 0x80 : 0);
+
+    frame_irq = false;
+    update_irq();
+
+    return status;
+}
+
+void emulator::APU::write_status(uint8_t value)
+{
+    pulse_1.enabled  = value & 0x01;
+    pulse_2.enabled  = value & 0x02;
+    triangle.enabled = value & 0x04;
+    noise.enabled    = value & 0x08;
+
+    if (!pulse_1.enabled)
+    {
+        pulse_1.length = 0;
+    }
+    if (!pulse_2.enabled)
+    {
+        pulse_2.length = 0;
+    }
+    if (!triangle.enabled)
+    {
+        triangle.length = 0;
+    }
+    if (!noise.enabled)
+    {
+        noise.length = 0;
+    }
+
+    dmc.irq_flag = false;
+
+    if (!(value & 0x10))
+    {
+        dmc.bytes_remaining = 0;
+    }
+    else if (!dmc.bytes_remaining)
+    {
+        dmc.restart();
+        dmc.fill();
+    }
+}
+
+void emulator::APU::write_frame_counter(uint8_t value)
+{
+    five_step_mode = value & 0x80;
+    irq_inhibit    = value & 0x40;
+
+    if (irq_inhibit)
+    {
+        frame_irq = false;
+    }
+
+    // The sequence restarts from here, a 5 step sequence clocks everything
+    // straight away
+    frame_step           = 0;
+    frame_sequence_start = timestamp_;
+
+    if (five_step_mode)
+    {
+        clock_quarter_frame();
+        clock_half_frame();
+    }
+}
+
+void emulator::APU::catch_up(uint64_t cycle)
+{
+    size_t applied = 0;
+
+    for (; applied < queued && write_queue[applied].cycle <= cycle; applied++)
+    {
+        auto const& write = write_queue[applied];
+
+        run_until(write.cycle);
+        apply_write(write.address, write.value);
+    }
+
+    if (applied)
+    {
+        std::copy(write_queue.begin() + applied, write_queue.begin() + queued, write_queue.begin());
+        queued -= applied;
+    }
+
+    run_until(cycle);
+}
+
+void emulator::APU::run_until(uint64_t cycle)
+{
+    if (cycle <= timestamp_)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        auto sequence   = five_step_mode ? five_step_sequence.data() : four_step_sequence.data();
+        auto step_cycle = frame_sequence_start + sequence[frame_step];
+
+        if (step_cycle > cycle)
+        {
+            break;
+        }
+
+        run_channels(step_cycle);
+        clock_frame_step();
+    }
+
+    run_channels(cycle);
+}
+
+void emulator::APU::run_channels(uint64_t cycle)
+{
+    if (cycle <= timestamp_)
+    {
+        return;
+    }
+
+    auto start = frame_time(timestamp_);
+    auto end   = frame_time(cycle);
+
+    pulse_1.run(start, end, output);
+    pulse_2.run(start, end, output);
+    triangle.run(start, end, output);
+    noise.run(start, end, output);
+    dmc.run(start, end, output);
+
+    timestamp_ = cycle;
+}
+
+/*
+ * Frame counter
+ *
+ * 4 step : Q  QH Q  QH+IRQ
+ * 5 step : Q  QH Q  -  QH
+ */
+void emulator::APU::clock_frame_step()
+{
+    if (!five_step_mode)
+    {
+        clock_quarter_frame();
+
+        if (frame_step & 0x01)
+        {
+            clock_half_frame();
+        }
+
+        if (frame_step == 3)
+        {
+            if (!irq_inhibit)
+            {
+                frame_irq = true;
+            }
+
+            frame_step            = 0;
+            frame_sequence_start += four_step_period;
+            return;
+        }
+    }
+    else
+    {
+        if (frame_step != 3)
+        {
+            clock_quarter_frame();
+        }
+
+        if (frame_step == 1 || frame_step == 4)
+        {
+            clock_half_frame();
+        }
+
+        if (frame_step == 4)
+        {
+            frame_step            = 0;
+            frame_sequence_start += five_step_period;
+            return;
+        }
+    }
+
+    frame_step++;
+}
+
+void emulator::APU::clock_quarter_frame()
+{
+    pulse_1.clock_quarter();
+    pulse_2.clock_quarter();
+    triangle.clock_quarter();
+    noise.clock_quarter();
+}
+
+void emulator::APU::clock_half_frame()
+{
+    pulse_1.clock_half();
+    pulse_2.clock_half();
+    triangle.clock_half();
+    noise.clock_half();
+}
+
+void emulator::APU::update_irq()
+{
+    bool asserted = frame_irq || dmc.irq_flag;
+
+    if (asserted != irq_raised && interrupt_request_handler)
+    {
+        interrupt_request_handler(asserted);
+    }
+
+    irq_raised = asserted;
+
+    schedule_irq();
+}
+
+void emulator::APU::schedule_irq()
+{
+    if (!scheduler)
+    {
+        return;
+    }
+
+    // Already raised, the next one only matters once it is acknowledged
+    uint64_t when = Scheduler::never;
+
+    if (!irq_raised)
+    {
+        if (!five_step_mode && !irq_inhibit)
+        {
+            when = frame_sequence_start + four_step_sequence[3];
+        }
+
+        // A DMC tick at cycle T is only run by catching up past it
+        uint32_t dmc_cycles = 0;
+        if (dmc.irq_due(dmc_cycles))
+        {
+            when = std::min(when, timestamp_ + dmc_cycles + 1);
+        }
+    }
+
+    if (when == Scheduler::never)
+    {
+        scheduler->cancel(Event::apu_frame_counter);
+    }
+    else
+    {
+        scheduler->schedule(Event::apu_frame_counter, when);
+    }
+}
+
+void emulator::APU::end_frame(uint64_t cycle)
+{
+    catch_up(cycle);
+
+    output.end_frame(frame_time(cycle));
+    frame_start = cycle;
+}
+
+size_t emulator::APU::samples_available() const
+{
+    return output.samples_available();
+}
+
+size_t emulator::APU::read_samples(int16_t* out, size_t count)
+{
+    return output.read_samples(out, count);
+}
+
+void emulator::APU::set_rate_adjustment(double ratio)
+{
+    output.set_clock_rate(cpu_clock_rate / ratio);
+}
+
+void emulator::APU::save(SaveState& state) const
+{
+    output.save(state);
+
+    pulse_1.save(state);
+    pulse_2.save(state);
+    triangle.save(state);
+    noise.save(state);
+    dmc.save(state);
+
+    state.write(five_step_mode);
+    state.write(irq_inhibit);
+    state.write(frame_irq);
+    state.write(frame_step);
+    state.write(frame_sequence_start);
+    state.write(irq_raised);
+
+    state.write(queued);
+    for (size_t i = 0; i < queued; i++)
+    {
+        state.write(write_queue[i].cycle);
+        state.write(write_queue[i].address);
+        state.write(write_queue[i].value);
+    }
+
+    state.write(timestamp_);
+    state.write(frame_start);
+}
+
+void emulator::APU::load(SaveState& state)
+{
+    output.load(state);
+
+    pulse_1.load(state);
+    pulse_2.load(state);
+    triangle.load(state);
+    noise.load(state);
+    dmc.load(state);
+
+    state.read(five_step_mode);
+    state.read(irq_inhibit);
+    state.read(frame_irq);
+    state.read(frame_step);
+    state.read(frame_sequence_start);
+    state.read(irq_raised);
+
+    state.read(queued);
+
+    if (queued > write_queue.size())
+    {
+        throw std::runtime_error("Save state has more APU writes queued than fit");
+    }
+
+    for (size_t i = 0; i < queued; i++)
+    {
+        state.read(write_queue[i].cycle);
+        state.read(write_queue[i].address);
+        state.read(write_queue[i].value);
+    }
+
+    state.read(timestamp_);
+    state.read(frame_start);
+}
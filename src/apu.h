@@ -0,0 +1,360 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+2A03 APU, NTSC.
+
+    Address   Channel    Bits
+    ------------------------------------
+    0x4000  : Pulse 1  : DDLC VVVV  Duty, length halt / envelope loop, constant volume, volume
+    0x4001  :          : EPPP NSSS  Sweep enable, period, negate, shift
+    0x4002  :          : TTTT TTTT  Timer low
+    0x4003  :          : LLLL LTTT  Length index, timer high
+    0x4004 - 0x4007    : Pulse 2, same as pulse 1
+    0x4008  : Triangle : CRRR RRRR  Length halt / linear control, linear reload
+    0x400A  :          : TTTT TTTT  Timer low
+    0x400B  :          : LLLL LTTT  Length index, timer high
+    0x400C  : Noise    : --LC VVVV  Length halt / envelope loop, constant volume, volume
+    0x400E  :          : M--- PPPP  Mode, period index
+    0x400F  :          : LLLL L---  Length index
+    0x4010  : DMC      : IL-- RRRR  IRQ enable, loop, rate index
+    0x4011  :          : -DDD DDDD  Output level
+    0x4012  :          : AAAA AAAA  Sample address, 0xC000 + A * 64
+    0x4013  :          : LLLL LLLL  Sample length, L * 16 + 1 bytes
+    0x4015  : Status   : ---D NT21  Write enables channels
+                       : IF-D NT21  Read: DMC IRQ, frame IRQ, channels still playing
+    0x4017  : Frame    : MI-- ----  5 step mode, IRQ inhibit
+
+Channels are not clocked a CPU cycle at a time. Each one runs from timer
+expiry to timer expiry, and only when its output level changes is the
+change handed to a BlipBuffer at that cycle. Output is mixed with the usual
+linear approximation of the 2A03's mixer, so each channel's deltas can go in
+on their own.
+
+The frame counter's quarter and half frame clocks split the runs, and its
+IRQ, along with the DMC's, is posted as Event::apu_frame_counter for the
+cycle it is due.
+
+The APU is not run as register writes come in. Channel register writes are
+queued with the cycle they happened on, and only replayed in order when
+something needs the APU's state: a read of 0x4015, an IRQ deadline, or the
+end of the audio frame. Writes that move the IRQ deadline, 0x4010, 0x4015 and
+0x4017, catch up and apply straight away so the deadline stays right.
+
+*/
+
+#ifndef NES_EMULATOR_APU_H_
+#define NES_EMULATOR_APU_H_
+
+#include "blip_buffer.h"
+#include "save_state.h"
+#include "scheduler.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+namespace emulator
+{
+
+// NTSC CPU clock, the APU runs off the same one
+uint32_t const cpu_clock_rate{1789773};
+uint32_t const default_sample_rate{48000};
+
+class APU
+{
+public:
+    explicit APU(uint32_t sample_rate = default_sample_rate);
+
+    // Channels point into the blip buffer
+    APU(APU const&) = delete;
+    APU& operator=(APU const&) = delete;
+
+    void reset();
+
+    // 0x4000 - 0x4013, 0x4015 and 0x4017, timed on the clock
+    void write_register(uint16_t address, uint8_t value);
+
+    // 0x4015, clears the frame IRQ
+    uint8_t read_status();
+
+    // Called with true when the frame or DMC IRQ goes up, and false once
+    // both have been acknowledged
+    void set_interrupt_request_handler(std::function<void(bool asserted)> const& irq_handler);
+
+    // Posts the frame counter and DMC IRQs
+    void set_scheduler(Scheduler* scheduler);
+
+    // Where register accesses get the current master clock cycle from
+    void set_clock(std::function<uint64_t()> const& clock);
+
+    // DMC sample fetches read through this
+    void set_memory_reader(std::function<uint8_t(uint16_t address)> const& reader);
+
+    // Runs every channel up to cycle, applying the writes queued before it
+    void catch_up(uint64_t cycle);
+
+    // Writes waiting for the next catch up
+    size_t queued_writes() const;
+
+    // True while the DMC has sample bytes left to fetch, or a queued write
+    // may start some. Whoever changes what those addresses read has to
+    // catch the APU up first.
+    bool fetching_samples() const;
+
+    // Master clock cycle the APU has been emulated up to
+    uint64_t timestamp() const;
+
+    // Catches up to cycle and finishes the audio frame there, its samples
+    // can be read after this
+    void end_frame(uint64_t cycle);
+
+    size_t samples_available() const;
+    size_t read_samples(int16_t* out, size_t count);
+
+    // Makes ratio times as many samples from the next audio frame on, for
+    // keeping up with a sound card whose clock doesn't quite match ours
+    void set_rate_adjustment(double ratio);
+
+    // Channels, frame counter, queued writes and the samples not yet read
+    void save(SaveState& state) const;
+    void load(SaveState& state);
+
+private:
+    struct Envelope
+    {
+        void write(uint8_t value);
+        void clock();
+        uint8_t output() const;
+
+        void save(SaveState& state) const;
+        void load(SaveState& state);
+
+        uint8_t volume{0};
+        bool constant{false};
+        bool loop{false};
+        bool start{false};
+        uint8_t divider{0};
+        uint8_t decay{0};
+    };
+
+    struct Pulse
+    {
+        explicit Pulse(bool ones_complement);
+
+        void write(uint8_t reg, uint8_t value);
+        void clock_quarter();
+        void clock_half();
+
+        uint16_t sweep_target() const;
+        bool muted() const;
+
+        void run(uint32_t start, uint32_t end, BlipBuffer& out);
+
+        void save(SaveState& state) const;
+        void load(SaveState& state);
+
+        bool ones_complement;
+
+        Envelope envelope;
+        uint8_t duty{0};
+        uint8_t phase{0};
+        uint16_t period{0};
+        uint32_t delay{0};
+
+        bool enabled{false};
+        uint8_t length{0};
+
+        bool sweep_enabled{false};
+        uint8_t sweep_period{0};
+        bool sweep_negate{false};
+        uint8_t sweep_shift{0};
+        uint8_t sweep_divider{0};
+        bool sweep_reload{false};
+
+        int32_t amplitude{0};
+    };
+
+    struct Triangle
+    {
+        void write(uint8_t reg, uint8_t value);
+        void clock_quarter();
+        void clock_half();
+
+        uint8_t level() const;
+
+        void run(uint32_t start, uint32_t end, BlipBuffer& out);
+
+        void save(SaveState& state) const;
+        void load(SaveState& state);
+
+        uint8_t phase{0};
+        uint16_t period{0};
+        uint32_t delay{0};
+
+        bool enabled{false};
+        uint8_t length{0};
+
+        bool control{false};
+        uint8_t linear_reload{0};
+        uint8_t linear_counter{0};
+        bool linear_reload_flag{false};
+
+        int32_t amplitude{0};
+    };
+
+    struct Noise
+    {
+        void write(uint8_t reg, uint8_t value);
+        void clock_quarter();
+        void clock_half();
+
+        void run(uint32_t start, uint32_t end, BlipBuffer& out);
+
+        void save(SaveState& state) const;
+        void load(SaveState& state);
+
+        Envelope envelope;
+        bool mode{false};
+        uint8_t period_index{0};
+        uint16_t shift{1};
+        uint32_t delay{0};
+
+        bool enabled{false};
+        uint8_t length{0};
+
+        int32_t amplitude{0};
+    };
+
+    struct DMC
+    {
+        void write(uint8_t reg, uint8_t value);
+
+        // Starts the sample over from its address
+        void restart();
+
+        // Fetches the next sample byte if the buffer is empty
+        void fill();
+
+        // Cycles from the end of the last run to the last fetch of the sample,
+        // which is when the IRQ is raised. Only when one is coming.
+        bool irq_due(uint32_t& cycles) const;
+
+        void run(uint32_t start, uint32_t end, BlipBuffer& out);
+
+        // Everything but the reader
+        void save(SaveState& state) const;
+        void load(SaveState& state);
+
+        std::function<uint8_t(uint16_t address)> reader;
+
+        bool irq_enabled{false};
+        bool irq_flag{false};
+        bool loop{false};
+        uint8_t rate_index{0};
+        uint32_t delay{0};
+
+        uint8_t output_level{0};
+
+        uint16_t sample_address{0xC000};
+        uint16_t sample_length{1};
+        uint16_t address{0xC000};
+        uint16_t bytes_remaining{0};
+
+        uint8_t shift{0};
+        uint8_t bits_remaining{8};
+        bool silence{true};
+
+        uint8_t buffer{0};
+        bool buffer_full{false};
+
+        int32_t amplitude{0};
+    };
+
+    struct RegisterWrite
+    {
+        uint64_t cycle;
+        uint16_t address;
+        uint8_t value;
+    };
+
+    uint64_t now() const;
+
+    void apply_write(uint16_t address, uint8_t value);
+
+    // Frame counter steps and channels, without looking at the queue
+    void run_until(uint64_t cycle);
+
+    // Cycles since the audio frame started, which is what the blip buffer
+    // times deltas in
+    uint32_t frame_time(uint64_t cycle) const;
+
+    void run_channels(uint64_t cycle);
+
+    void clock_frame_step();
+    void clock_quarter_frame();
+    void clock_half_frame();
+
+    void write_frame_counter(uint8_t value);
+    void write_status(uint8_t value);
+
+    // Raises the IRQ line if a flag went up, and posts when the next one
+    // will
+    void update_irq();
+    void schedule_irq();
+
+    BlipBuffer output;
+
+    Pulse pulse_1{true};
+    Pulse pulse_2{false};
+    Triangle triangle;
+    Noise noise;
+    DMC dmc;
+
+    bool five_step_mode{false};
+    bool irq_inhibit{false};
+    bool frame_irq{false};
+    uint8_t frame_step{0};
+    uint64_t frame_sequence_start{0};
+
+    // IRQ line raised and not yet acknowledged
+    bool irq_raised{false};
+
+    // Oldest first, a full queue is caught up on the next write
+    std::array<RegisterWrite, 256> write_queue;
+    size_t queued{0};
+
+    std::function<void(bool asserted)> interrupt_request_handler;
+    std::function<uint64_t()> clock;
+    Scheduler* scheduler{nullptr};
+
+    uint64_t timestamp_{0};
+    uint64_t frame_start{0};
+};
+
+}
+
+#endif /* NES_EMULATOR_APU_H_ */
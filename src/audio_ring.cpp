@@ -0,0 +1,100 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "audio_ring.h"
+
+#include <algorithm>
+
+namespace
+{
+size_t round_up_power_of_two(size_t value)
+{
+    size_t power = 1;
+    while (power < value)
+    {
+        power <<= 1;
+    }
+
+    return power;
+}
+}
+
+emulator::AudioRing::AudioRing(size_t capacity) :
+    samples(round_up_power_of_two(capacity)),
+    mask(samples.size() - 1)
+{
+}
+
+size_t emulator::AudioRing::push(int16_t const* in, size_t count)
+{
+    auto write = write_index.load(std::memory_order_relaxed);
+    auto read  = read_index.load(std::memory_order_acquire);
+
+    count = std::min(count, samples.size() - (write - read));
+
+    // In up to two pieces, around the end of the buffer
+    auto start = write & mask;
+    auto first = std::min(count, samples.size() - start);
+
+    std::copy(in, in + first, samples.begin() + start);
+    std::copy(in + first, in + count, samples.begin());
+
+    write_index.store(write + count, std::memory_order_release);
+
+    return count;
+}
+
+size_t emulator::AudioRing::pop(int16_t* out, size_t count)
+{
+    auto read  = read_index.load(std::memory_order_relaxed);
+    auto write = write_index.load(std::memory_order_acquire);
+
+    count = std::min(count, write - read);
+
+    auto start = read & mask;
+    auto first = std::min(count, samples.size() - start);
+
+    std::copy(samples.begin() + start, samples.begin() + start + first, out);
+    std::copy(samples.begin(), samples.begin() + (count - first), out + first);
+
+    read_index.store(read + count, std::memory_order_release);
+
+    return count;
+}
+
+size_t emulator::AudioRing::size() const
+{
+    // Read index first so the write index can't be behind it. The producer
+    // can run on in between, so the difference is capped at capacity.
+    auto read  = read_index.load(std::memory_order_acquire);
+    auto write = write_index.load(std::memory_order_acquire);
+
+    return std::min(write - read, samples.size());
+}
+
+size_t emulator::AudioRing::capacity() const
+{
+    return samples.size();
+}
@@ -0,0 +1,81 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Single producer, single consumer ring of audio samples.
+
+The emulation thread pushes each frame's samples, the audio callback pops
+them. Neither side ever waits or takes a lock: each only stores its own
+index, with release ordering so the other side sees the samples before it
+sees the index move. Indices count up forever and are masked into the
+buffer, so full and empty are never confused.
+
+*/
+
+#ifndef NES_EMULATOR_AUDIO_RING_H_
+#define NES_EMULATOR_AUDIO_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emulator
+{
+
+class AudioRing
+{
+public:
+    // Rounded up to a power of two
+    explicit AudioRing(size_t capacity);
+
+    AudioRing(AudioRing const&) = delete;
+    AudioRing& operator=(AudioRing const&) = delete;
+
+    // Producer only. Returns how many fit, the rest are dropped.
+    size_t push(int16_t const* samples, size_t count);
+
+    // Consumer only. Returns how many there were, up to count.
+    size_t pop(int16_t* out, size_t count);
+
+    // From either side, the other may move it straight after
+    size_t size() const;
+    size_t capacity() const;
+
+private:
+    // Keeps the two indices off each other's cache line
+    static constexpr size_t cache_line{64};
+
+    std::vector<int16_t> samples;
+    size_t mask;
+
+    alignas(cache_line) std::atomic<size_t> write_index{0};
+    alignas(cache_line) std::atomic<size_t> read_index{0};
+};
+
+}
+
+#endif /* NES_EMULATOR_AUDIO_RING_H_ */
@@ -0,0 +1,209 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "blip_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+uint64_t samples_per_clock(double clock_rate, uint32_t sample_rate)
+{
+    return static_cast<uint64_t>(std::ceil(sample_rate / clock_rate * 4294967296.0));
+}
+
+// Kernel taps add up to 1 << kernel_bits
+int const kernel_bits{15};
+
+// Leak on the integrator, about 15Hz of high pass at 48kHz
+int const bass_shift{9};
+
+// Just under Nyquist so the window has room to roll off
+double const cutoff{0.9};
+
+double const pi{3.14159265358979323846};
+
+template <size_t Taps, size_t Phases>
+std::array<std::array<int32_t, Taps>, Phases> make_kernel()
+{
+    std::array<std::array<int32_t, Taps>, Phases> kernel{};
+
+    for (size_t phase = 0; phase < Phases; phase++)
+    {
+        // Centre of the step, between taps Taps / 2 - 1 and Taps / 2
+        double centre = Taps / 2.0 - 1.0 + static_cast<double>(phase) / Phases;
+
+        std::array<double, Taps> taps{};
+        double sum = 0.0;
+
+        for (size_t i = 0; i < Taps; i++)
+        {
+            double x    = i - centre;
+            double sinc = x == 0.0 ? 1.0 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+
+            // Blackman window over the kernel's width
+            double w      = 2.0 * pi * (x + Taps / 2.0) / Taps;
+            double window = 0.42 - 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+
+            taps[i] = sinc * std::max(window, 0.0);
+            sum    += taps[i];
+        }
+
+        // Scale each phase to exactly 1 << kernel_bits so a step always
+        // settles at its full height, whatever rounding did
+        int32_t total   = 0;
+        size_t  biggest = 0;
+
+        for (size_t i = 0; i < Taps; i++)
+        {
+            kernel[phase][i] = static_cast<int32_t>(std::lround(taps[i] / sum * (1 << kernel_bits)));
+            total += kernel[phase][i];
+
+            if (kernel[phase][i] > kernel[phase][biggest])
+            {
+                biggest = i;
+            }
+        }
+
+        kernel[phase][biggest] += (1 << kernel_bits) - total;
+    }
+
+    return kernel;
+}
+}
+
+emulator::BlipBuffer::Kernel const emulator::BlipBuffer::kernel{make_kernel<kernel_taps, kernel_phases>()};
+
+emulator::BlipBuffer::BlipBuffer(double clock_rate, uint32_t sample_rate, size_t max_samples) :
+    sample_rate_(sample_rate),
+    factor(samples_per_clock(clock_rate, sample_rate)),
+    next_factor(factor),
+    buffer(max_samples + kernel_taps)
+{
+}
+
+void emulator::BlipBuffer::end_frame(uint32_t time)
+{
+    offset += time * factor;
+    factor  = next_factor;
+
+    // Nobody is reading, keep the newest frame's timing and lose the rest
+    auto capacity = buffer.size() - kernel_taps;
+    if ((offset >> 32) > capacity)
+    {
+        offset = (offset & 0xFFFFFFFF) | static_cast<uint64_t>(capacity) << 32;
+    }
+
+    available = offset >> 32;
+}
+
+void emulator::BlipBuffer::set_clock_rate(double clock_rate)
+{
+    next_factor = samples_per_clock(clock_rate, sample_rate_);
+}
+
+size_t emulator::BlipBuffer::samples_available() const
+{
+    return available;
+}
+
+size_t emulator::BlipBuffer::read_samples(int16_t* out, size_t count)
+{
+    count = std::min(count, available);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        integrator += buffer[i];
+
+        auto sample = integrator >> kernel_bits;
+        integrator -= sample * (1 << (kernel_bits - bass_shift));
+
+        out[i] = static_cast<int16_t>(std::clamp<int64_t>(sample,
+                                                          std::numeric_limits<int16_t>::min(),
+                                                          std::numeric_limits<int16_t>::max()));
+    }
+
+    // Move what is left, including steps still spreading into later samples,
+    // to the front
+    auto left = buffer.size() - count;
+    std::memmove(buffer.data(), buffer.data() + count, left * sizeof(buffer[0]));
+    std::fill(buffer.begin() + left, buffer.end(), 0);
+
+    available -= count;
+    offset    -= static_cast<uint64_t>(count) << 32;
+
+    return count;
+}
+
+void emulator::BlipBuffer::clear()
+{
+    std::fill(buffer.begin(), buffer.end(), 0);
+    offset     = 0;
+    available  = 0;
+    integrator = 0;
+}
+
+void emulator::BlipBuffer::save(SaveState& state) const
+{
+    state.write(factor);
+    state.write(next_factor);
+    state.write(offset);
+    state.write(available);
+    state.write(integrator);
+
+    // Nothing has been added past here yet
+    auto used = std::min<size_t>((offset >> 32) + kernel_taps + 1, buffer.size());
+    state.write(used);
+    state.write(buffer.data(), used * sizeof(buffer[0]));
+}
+
+void emulator::BlipBuffer::load(SaveState& state)
+{
+    state.read(factor);
+    state.read(next_factor);
+    state.read(offset);
+    state.read(available);
+    state.read(integrator);
+
+    size_t used;
+    state.read(used);
+
+    if (used > buffer.size())
+    {
+        throw std::runtime_error("Save state is for a bigger audio buffer");
+    }
+
+    state.read(buffer.data(), used * sizeof(buffer[0]));
+    std::fill(buffer.begin() + used, buffer.end(), 0);
+}
+
+uint32_t emulator::BlipBuffer::sample_rate() const
+{
+    return sample_rate_;
+}
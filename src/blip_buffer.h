@@ -0,0 +1,138 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Band limited step synthesis.
+
+Sound channels only report when their output changes, as an amplitude delta
+at a clock time. Each delta is added into the output buffer as a band
+limited step, a windowed sinc picked from a table by where the step falls
+between two output samples, so nothing is ever sampled at the input clock
+rate. Reading integrates the deltas back into samples, with a little high
+pass to drop the DC offset.
+
+    add_delta(time, delta)  time in input clocks since the frame started
+    end_frame(time)         the frame is time clocks long, its samples can
+                            now be read
+
+Time is tracked as 32.32 fixed point output samples so frames don't have to
+be a whole number of samples long.
+
+*/
+
+#ifndef NES_EMULATOR_BLIP_BUFFER_H_
+#define NES_EMULATOR_BLIP_BUFFER_H_
+
+#include "save_state.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emulator
+{
+
+class BlipBuffer
+{
+public:
+    // Holds up to max_samples finished samples that have not been read
+    BlipBuffer(double clock_rate, uint32_t sample_rate, size_t max_samples);
+
+    void add_delta(uint32_t time, int32_t delta);
+    void end_frame(uint32_t time);
+
+    // Changes how many samples a clock is worth, from the next frame on so
+    // deltas already in this one stay where they are. Small changes to it
+    // resample the output with no extra work.
+    void set_clock_rate(double clock_rate);
+
+    size_t samples_available() const;
+
+    // Returns how many were read, up to count
+    size_t read_samples(int16_t* out, size_t count);
+
+    void clear();
+
+    uint32_t sample_rate() const;
+
+    // Timing and the samples not yet read, up to where the last frame's
+    // steps still spread into
+    void save(SaveState& state) const;
+    void load(SaveState& state);
+
+    static constexpr size_t kernel_taps{16};
+
+    // Steps land this many samples late, half the kernel
+    static constexpr size_t latency{kernel_taps / 2};
+
+private:
+    static constexpr size_t phase_bits{6};
+    static constexpr size_t kernel_phases{1 << phase_bits};
+
+    using Kernel = std::array<std::array<int32_t, kernel_taps>, kernel_phases>;
+    static Kernel const kernel;
+
+    uint32_t sample_rate_;
+
+    // Output samples per input clock, 32.32
+    uint64_t factor;
+    uint64_t next_factor;
+
+    // Where the current frame starts, 32.32 samples from the first unread one
+    uint64_t offset{0};
+
+    size_t available{0};
+    int64_t integrator{0};
+
+    std::vector<int64_t> buffer;
+};
+
+inline void BlipBuffer::add_delta(uint32_t time, int32_t delta)
+{
+    auto position = offset + time * factor;
+    auto index    = static_cast<size_t>(position >> 32);
+    auto phase    = static_cast<size_t>(position >> (32 - phase_bits)) & (kernel_phases - 1);
+
+    // A frame longer than the buffer, drop what doesn't fit rather than
+    // writing past it
+    if (index + kernel_taps > buffer.size())
+    {
+        return;
+    }
+
+    auto const& taps = kernel[phase];
+    auto* out        = buffer.data() + index;
+
+    for (size_t i = 0; i < kernel_taps; i++)
+    {
+        out[i] += static_cast<int64_t>(taps[i]) * delta;
+    }
+}
+
+}
+
+#endif /* NES_EMULATOR_BLIP_BUFFER_H_ */
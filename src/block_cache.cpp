@@ -0,0 +1,250 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "block_cache.h"
+#include "cpu_instructions.h"
+
+namespace
+{
+// Keeps the cycles of a whole block well inside what step() can return
+size_t const max_block_length{16};
+
+// Anything that can move the program counter somewhere other than the next op
+bool ends_block(uint8_t op)
+{
+    switch (op)
+    {
+        case 0x00: // BRK
+        case 0x20: // JSR
+        case 0x40: // RTI
+        case 0x4C: // JMP
+        case 0x60: // RTS
+        case 0x6C: // JMP
+            return true;
+        default:
+            return emulator::instruction[op].mode == emulator::relative;
+    }
+}
+}
+
+emulator::BlockCache::BlockCache(Bus* bus) :
+    bus(bus)
+{
+}
+
+emulator::BlockCache::Block* emulator::BlockCache::find(uint16_t address)
+{
+    collect_stale_blocks();
+
+    uint8_t page = address >> 8;
+    auto data    = bus->read_page(page);
+
+    if (!data)
+    {
+        return nullptr;
+    }
+
+    auto key = data + (address & 0xFF);
+    auto it  = blocks.find(key);
+
+    if (it != blocks.end())
+    {
+        return &it->second;
+    }
+
+    auto block = decode(address, data);
+
+    if (block.ops.empty())
+    {
+        return nullptr;
+    }
+
+    if (is_writable(page, data))
+    {
+        protect(data);
+    }
+
+    blocks_in_page[data].push_back(key);
+    return &blocks.emplace(key, std::move(block)).first->second;
+}
+
+emulator::BlockCache::Block emulator::BlockCache::decode(uint16_t address, uint8_t const* page) const
+{
+    Block block;
+    block.address = address;
+
+    auto offset = address & 0xFF;
+
+    while (block.ops.size() < max_block_length)
+    {
+        auto op          = page[offset];
+        auto const& info = instruction[op];
+
+        // KIL and the unfinished unoffical ops never move on, leave them to the interpreter.
+        // Ops running into the next page may see a different bank there.
+        if (info.number_bytes == 0 || offset + info.number_bytes > page_size)
+        {
+            break;
+        }
+
+        uint16_t operand = 0;
+
+        switch (operand_size(info.mode))
+        {
+            case 2:
+                operand = page[offset + 1] | page[offset + 2] << 8;
+                break;
+            case 1:
+                operand = page[offset + 1];
+                break;
+        }
+
+        block.ops.push_back({specialized_handler[op], operand, info.number_bytes, info.number_cycles});
+        offset += info.number_bytes;
+
+        if (ends_block(op))
+        {
+            break;
+        }
+    }
+
+    return block;
+}
+
+uint64_t emulator::BlockCache::generation() const
+{
+    return generation_;
+}
+
+void emulator::BlockCache::flush()
+{
+    invalidate_writable();
+
+    blocks.clear();
+    blocks_in_page.clear();
+    stale_pages.clear();
+    generation_++;
+}
+
+void emulator::BlockCache::invalidate_writable()
+{
+    for (auto page = 0u; page < number_of_pages; page++)
+    {
+        if (protected_write[page])
+        {
+            invalidate(protected_write[page]);
+        }
+    }
+}
+
+size_t emulator::BlockCache::size() const
+{
+    return blocks.size();
+}
+
+uint8_t emulator::BlockCache::read(uint16_t address)
+{
+    auto data = protected_write[address >> 8];
+    return data ? data[address & 0xFF] : 0;
+}
+
+void emulator::BlockCache::write(uint16_t address, uint8_t value)
+{
+    auto data = protected_write[address >> 8];
+
+    if (data)
+    {
+        data[address & 0xFF] = value;
+        invalidate(data);
+    }
+}
+
+bool emulator::BlockCache::is_writable(uint8_t page, uint8_t const* data) const
+{
+    return bus->write_page(page) == data || protected_write[page] == data;
+}
+
+void emulator::BlockCache::protect(uint8_t const* data)
+{
+    // Every mirror of the page has to be protected, not just the one we decoded from
+    for (auto page = 0u; page < number_of_pages; page++)
+    {
+        auto write = bus->write_page(page);
+
+        if (write && write == data)
+        {
+            protected_write[page]  = write;
+            protected_device[page] = bus->device(page);
+            bus->set_write_page(page, nullptr, this);
+        }
+    }
+}
+
+void emulator::BlockCache::invalidate(uint8_t const* data)
+{
+    for (auto page = 0u; page < number_of_pages; page++)
+    {
+        if (protected_write[page] != data)
+        {
+            continue;
+        }
+
+        // Leave the page alone if it has been remapped since
+        if (bus->device(page) == this && !bus->write_page(page))
+        {
+            bus->set_write_page(page, protected_write[page], protected_device[page]);
+        }
+
+        protected_write[page]  = nullptr;
+        protected_device[page] = nullptr;
+    }
+
+    // The block running right now may be one of these, so they are only
+    // dropped on the next find()
+    stale_pages.push_back(data);
+    generation_++;
+}
+
+void emulator::BlockCache::collect_stale_blocks()
+{
+    for (auto data : stale_pages)
+    {
+        auto it = blocks_in_page.find(data);
+
+        if (it == blocks_in_page.end())
+        {
+            continue;
+        }
+
+        for (auto key : it->second)
+        {
+            blocks.erase(key);
+        }
+
+        blocks_in_page.erase(it);
+    }
+
+    stale_pages.clear();
+}
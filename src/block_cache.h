@@ -0,0 +1,127 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Predecoded basic blocks for the interpreter.
+
+A block is a straight line run of ops up to the next branch, jump, call or
+return, decoded once into {handler, operand, bytes, cycles} so running it
+skips the op code fetch, the dispatch switch and the operand reads.
+
+Blocks are keyed on the host address of their first op code byte rather than
+the program counter. Mirrors of the same memory share blocks, and switching
+a PRG bank changes the host address so blocks from the old bank are never
+found for the new one.
+
+Pages of RAM holding a cached block are write protected on the bus, writes to
+them go through this cache which drops every block on that page before
+letting the write through.
+
+*/
+
+#ifndef NES_EMULATOR_BLOCK_CACHE_H_
+#define NES_EMULATOR_BLOCK_CACHE_H_
+
+#include "bus.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace emulator
+{
+class CPU;
+
+class BlockCache : public BusDevice
+{
+public:
+    struct DecodedOp
+    {
+        void (*handler)(CPU* cpu);
+        uint16_t operand;
+        uint8_t number_bytes;
+        uint8_t number_cycles;
+    };
+
+    struct Block
+    {
+        std::vector<DecodedOp> ops;
+        uint16_t address{0};
+
+        // Filled in by the JIT once the block has run often enough
+        uint32_t runs{0};
+        void (*native)(CPU* cpu){nullptr};
+    };
+
+    explicit BlockCache(Bus* bus);
+
+    // The block starting at address, decoded on first use. nullptr when the
+    // address is not backed by host memory or its first op can't be cached.
+    Block* find(uint16_t address);
+
+    // Bumped each time cached code is written over, a running block has to
+    // stop once this changes as it may have just modified itself
+    uint64_t generation() const;
+
+    void flush();
+
+    // Drops the blocks on write protected pages, for when their memory has
+    // been overwritten without going through the bus. Blocks in ROM stay.
+    void invalidate_writable();
+
+    size_t size() const;
+
+    uint8_t read(uint16_t address) override;
+    void write(uint16_t address, uint8_t value) override;
+
+private:
+    friend class JIT;
+
+    Block decode(uint16_t address, uint8_t const* page) const;
+
+    bool is_writable(uint8_t page, uint8_t const* data) const;
+    void protect(uint8_t const* data);
+    void invalidate(uint8_t const* data);
+    void collect_stale_blocks();
+
+    Bus* bus;
+
+    std::unordered_map<uint8_t const*, Block> blocks;
+    std::unordered_map<uint8_t const*, std::vector<uint8_t const*>> blocks_in_page;
+    std::vector<uint8_t const*> stale_pages;
+
+    // Where writes went before a page was protected
+    std::array<uint8_t*, number_of_pages> protected_write{};
+    std::array<BusDevice*, number_of_pages> protected_device{};
+
+    uint64_t generation_{0};
+};
+
+}
+
+#endif /* NES_EMULATOR_BLOCK_CACHE_H_ */
@@ -0,0 +1,121 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "bus.h"
+
+#include <stdexcept>
+
+namespace
+{
+void check_pages(uint8_t first_page, uint16_t page_count)
+{
+    if (first_page + page_count > emulator::number_of_pages)
+    {
+        throw std::runtime_error("Mapping runs past the end of the address space");
+    }
+}
+
+void check_size(uint32_t size)
+{
+    if (size == 0 || size % emulator::page_size != 0)
+    {
+        throw std::runtime_error("Mapped memory must be a whole number of pages");
+    }
+}
+}
+
+uint8_t emulator::OpenBus::read(uint16_t /*address*/)
+{
+    return 0;
+}
+
+void emulator::OpenBus::write(uint16_t /*address*/, uint8_t /*value*/)
+{
+}
+
+emulator::Bus::Bus()
+{
+    pages.fill({nullptr, nullptr, &open_bus});
+}
+
+void emulator::Bus::map_memory(uint8_t first_page, uint16_t page_count, uint8_t* data, uint32_t size)
+{
+    check_pages(first_page, page_count);
+    check_size(size);
+
+    for (auto i = 0u; i < page_count; i++)
+    {
+        auto& page = pages[first_page + i];
+        page.read  = data + (i * page_size) % size;
+        page.write = data + (i * page_size) % size;
+    }
+}
+
+void emulator::Bus::map_read_only(uint8_t first_page, uint16_t page_count, uint8_t const* data, uint32_t size)
+{
+    check_pages(first_page, page_count);
+    check_size(size);
+
+    for (auto i = 0u; i < page_count; i++)
+    {
+        auto& page = pages[first_page + i];
+        page.read  = data + (i * page_size) % size;
+        page.write = nullptr;
+    }
+}
+
+void emulator::Bus::map_device(uint8_t first_page, uint16_t page_count, BusDevice* device)
+{
+    check_pages(first_page, page_count);
+
+    for (auto i = 0u; i < page_count; i++)
+    {
+        auto& page = pages[first_page + i];
+        page.read   = nullptr;
+        page.write  = nullptr;
+        page.device = device ? device : &open_bus;
+    }
+}
+
+void emulator::Bus::set_write_page(uint8_t page, uint8_t* data, BusDevice* device)
+{
+    pages[page].write  = data;
+    pages[page].device = device ? device : &open_bus;
+}
+
+uint8_t const* emulator::Bus::read_page(uint8_t page) const
+{
+    return pages[page].read;
+}
+
+uint8_t* emulator::Bus::write_page(uint8_t page) const
+{
+    return pages[page].write;
+}
+
+emulator::BusDevice* emulator::Bus::device(uint8_t page) const
+{
+    return pages[page].device;
+}
@@ -0,0 +1,134 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+CPU address space as 256 pages of 256 bytes each.
+
+Every page either points straight at host memory (internal RAM and its
+mirrors, PRG ROM banks) or hands the access to a BusDevice (PPU, APU and
+mapper registers). Reads and writes are mapped separately, so a ROM page can
+read from host memory while writes go to the mapper that owns it.
+
+A RAM or ROM access is one page table load plus an index.
+
+*/
+
+#ifndef NES_EMULATOR_BUS_H_
+#define NES_EMULATOR_BUS_H_
+
+#include <array>
+#include <cstdint>
+
+namespace emulator
+{
+
+uint16_t const page_size{0x100};
+uint16_t const number_of_pages{0x100};
+
+class BusDevice
+{
+public:
+    virtual ~BusDevice() = default;
+
+    virtual uint8_t read(uint16_t address) = 0;
+    virtual void write(uint16_t address, uint8_t value) = 0;
+};
+
+// Nothing is connected, reads return 0 and writes are dropped
+class OpenBus : public BusDevice
+{
+public:
+    uint8_t read(uint16_t address) override;
+    void write(uint16_t address, uint8_t value) override;
+};
+
+class Bus
+{
+public:
+    Bus();
+
+    // data is repeated across the pages if it is smaller than them, size has
+    // to be a multiple of page_size
+    void map_memory(uint8_t first_page, uint16_t page_count, uint8_t* data, uint32_t size);
+
+    // Reads come from data, writes still go to whatever device owns the pages
+    void map_read_only(uint8_t first_page, uint16_t page_count, uint8_t const* data, uint32_t size);
+
+    void map_device(uint8_t first_page, uint16_t page_count, BusDevice* device);
+
+    // Swap where writes to a single page go, reads are left alone
+    void set_write_page(uint8_t page, uint8_t* data, BusDevice* device);
+
+    uint8_t read8(uint16_t address) const;
+    void write8(uint16_t address, uint8_t value);
+
+    uint8_t const* read_page(uint8_t page) const;
+    uint8_t* write_page(uint8_t page) const;
+    BusDevice* device(uint8_t page) const;
+
+private:
+    friend class JIT;
+
+    struct Page
+    {
+        uint8_t const* read;
+        uint8_t* write;
+        BusDevice* device;
+    };
+
+    std::array<Page, number_of_pages> pages;
+
+    OpenBus open_bus;
+};
+
+inline uint8_t Bus::read8(uint16_t address) const
+{
+    auto const& page = pages[address >> 8];
+
+    if (page.read)
+    {
+        return page.read[address & 0xFF];
+    }
+
+    return page.device->read(address);
+}
+
+inline void Bus::write8(uint16_t address, uint8_t value)
+{
+    auto const& page = pages[address >> 8];
+
+    if (page.write)
+    {
+        page.write[address & 0xFF] = value;
+        return;
+    }
+
+    page.device->write(address, value);
+}
+
+}
+
+#endif /* NES_EMULATOR_BUS_H_ */
@@ -0,0 +1,193 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "console.h"
+#include "mappers.h"
+
+#include <utility>
+
+emulator::ConsoleBase::ConsoleBase(Rom rom) :
+    rom_(std::move(rom))
+{
+    cpu_.set_lazy_flags(true);
+
+    ppu_.set_non_maskable_interrupt_handler([this] {
+        cpu_.handle_non_maskable_interrupt();
+    });
+    ppu_.set_scheduler(&cpu_.scheduler);
+    ppu_.set_clock([this] {
+        return cpu_.cycles();
+    });
+
+    apu_.set_interrupt_request_handler([this] (bool asserted) {
+        cpu_.set_interrupt_request(irq_apu, asserted);
+    });
+    apu_.set_scheduler(&cpu_.scheduler);
+    apu_.set_clock([this] {
+        return cpu_.cycles();
+    });
+    apu_.set_memory_reader([this] (uint16_t address) {
+        return cpu_.read8(address);
+    });
+    cpu_.set_apu(&apu_);
+
+    cpu_.set_controller(0, &controllers_[0]);
+    cpu_.set_controller(1, &controllers_[1]);
+}
+
+emulator::CPU& emulator::ConsoleBase::cpu()
+{
+    return cpu_;
+}
+
+emulator::PPU& emulator::ConsoleBase::ppu()
+{
+    return ppu_;
+}
+
+emulator::APU& emulator::ConsoleBase::apu()
+{
+    return apu_;
+}
+
+emulator::Rom const& emulator::ConsoleBase::rom() const
+{
+    return rom_;
+}
+
+emulator::Controller& emulator::ConsoleBase::controller(uint8_t port)
+{
+    return controllers_[port];
+}
+
+template <typename MapperT>
+emulator::Console<MapperT>::Console(Rom rom) :
+    ConsoleBase(std::move(rom)),
+    mapper_(&rom_, &cpu_.bus, &ppu_)
+{
+    auto& mapper = mapper_.get();
+
+    mapper.set_scheduler(&cpu_.scheduler);
+    mapper.set_clock([this] {
+        return cpu_.cycles();
+    });
+    mapper.set_interrupt_request_handler([this] (bool asserted) {
+        cpu_.set_interrupt_request(irq_mapper, asserted);
+    });
+    mapper.set_apu(&apu_);
+
+    ppu_.set_rendering_handler([this] (bool rendering) {
+        mapper_.get().rendering_changed(rendering);
+    });
+
+    mapper.reset();
+}
+
+template <typename MapperT>
+void emulator::Console<MapperT>::reset()
+{
+    mapper_.get().reset();
+    apu_.reset();
+    cpu_.reset();
+}
+
+template <typename MapperT>
+uint64_t emulator::Console<MapperT>::run_frame()
+{
+    NoTrace trace;
+    return run_frame_with(trace);
+}
+
+template <typename MapperT>
+uint64_t emulator::Console<MapperT>::run_frame(TraceBuffer& trace)
+{
+    return run_frame_with(trace);
+}
+
+template <typename MapperT>
+template <typename Trace>
+uint64_t emulator::Console<MapperT>::run_frame_with(Trace& trace)
+{
+    auto ran = cpu_.run_frame(trace);
+    ppu_.catch_up(cpu_.cycles());
+    apu_.end_frame(cpu_.cycles());
+
+    return ran;
+}
+
+// The PPU goes last so it decodes CHR RAM tiles from what the mapper put back
+template <typename MapperT>
+void emulator::Console<MapperT>::save_state(SaveState& state) const
+{
+    state.clear();
+
+    cpu_.save(state);
+    apu_.save(state);
+    mapper_.get().save(state);
+    ppu_.save(state);
+}
+
+template <typename MapperT>
+void emulator::Console<MapperT>::load_state(SaveState& state)
+{
+    state.rewind();
+
+    cpu_.load(state);
+    apu_.load(state);
+    mapper_.get().load(state);
+    ppu_.load(state);
+}
+
+template <typename MapperT>
+MapperT& emulator::Console<MapperT>::mapper()
+{
+    return mapper_.get();
+}
+
+template class emulator::Console<emulator::NROM>;
+template class emulator::Console<emulator::MMC1>;
+template class emulator::Console<emulator::UxROM>;
+template class emulator::Console<emulator::CNROM>;
+template class emulator::Console<emulator::MMC3>;
+template class emulator::Console<emulator::Mapper>;
+
+std::unique_ptr<emulator::ConsoleBase> emulator::make_console(Rom rom)
+{
+    switch (rom.mapper())
+    {
+        case 0:
+            return std::make_unique<Console<NROM>>(std::move(rom));
+        case 1:
+            return std::make_unique<Console<MMC1>>(std::move(rom));
+        case 2:
+            return std::make_unique<Console<UxROM>>(std::move(rom));
+        case 3:
+            return std::make_unique<Console<CNROM>>(std::move(rom));
+        case 4:
+            return std::make_unique<Console<MMC3>>(std::move(rom));
+        default:
+            return std::make_unique<Console<Mapper>>(std::move(rom));
+    }
+}
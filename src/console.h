@@ -0,0 +1,185 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+The whole console, built around one cartridge.
+
+Console<MapperT> holds its mapper by value. With MapperT a final mapper class
+every call the console makes into it is a direct call the compiler can
+inline, no vtable involved. make_console picks the instantiation from the
+ROM header, so the common mappers each get their own copy of the frame loop.
+
+Console<Mapper> is the fallback for everything else. It holds whatever
+make_mapper built and calls through the vtable, so a rare mapper only needs
+adding to make_mapper.
+
+Cartridge reads never reach the mapper in either case, PRG is mapped on the
+bus as pointers into the ROM image.
+
+*/
+
+#ifndef NES_EMULATOR_CONSOLE_H_
+#define NES_EMULATOR_CONSOLE_H_
+
+#include "apu.h"
+#include "controller.h"
+#include "cpu.h"
+#include "mapper.h"
+#include "ppu.h"
+#include "rom.h"
+#include "save_state.h"
+#include "trace.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace emulator
+{
+
+class ConsoleBase
+{
+public:
+    virtual ~ConsoleBase() = default;
+
+    // The CPU and mapper point into the PPU and bus
+    ConsoleBase(ConsoleBase const&) = delete;
+    ConsoleBase& operator=(ConsoleBase const&) = delete;
+
+    // Power on banks, then the CPU reset vector
+    virtual void reset() = 0;
+
+    // Runs the CPU up to the start of the next frame and brings the PPU and
+    // APU up to the same cycle, returns the cycles run. The frame's audio can
+    // be read from the APU after.
+    virtual uint64_t run_frame() = 0;
+    virtual uint64_t run_frame(TraceBuffer& trace) = 0;
+
+    // Everything that changes while running, overwriting what state held.
+    // Loading puts the console back exactly as it was at the save, it must
+    // come from a console with the same ROM. Samples the APU had not handed
+    // out at the save come back, the rendered frame does not.
+    virtual void save_state(SaveState& state) const = 0;
+    virtual void load_state(SaveState& state) = 0;
+
+    virtual Mapper& mapper() = 0;
+
+    CPU& cpu();
+    PPU& ppu();
+    APU& apu();
+    Rom const& rom() const;
+
+    // Port 0 or 1, safe to press buttons on from another thread
+    Controller& controller(uint8_t port);
+
+protected:
+    explicit ConsoleBase(Rom rom);
+
+    Rom rom_;
+    PPU ppu_;
+    APU apu_;
+    CPU cpu_{&ppu_};
+
+    std::array<Controller, 2> controllers_;
+};
+
+namespace detail
+{
+// Where a console keeps its mapper, by value when the type is known
+template <typename MapperT>
+struct MapperSlot
+{
+    MapperSlot(Rom const* rom, Bus* bus, PPU* ppu) :
+        mapper(rom, bus, ppu)
+    {
+    }
+
+    MapperT& get()
+    {
+        return mapper;
+    }
+
+    MapperT const& get() const
+    {
+        return mapper;
+    }
+
+    MapperT mapper;
+};
+
+template <>
+struct MapperSlot<Mapper>
+{
+    MapperSlot(Rom const* rom, Bus* bus, PPU* ppu) :
+        mapper(make_mapper(rom, bus, ppu))
+    {
+    }
+
+    Mapper& get()
+    {
+        return *mapper;
+    }
+
+    Mapper const& get() const
+    {
+        return *mapper;
+    }
+
+    std::unique_ptr<Mapper> mapper;
+};
+}
+
+template <typename MapperT>
+class Console : public ConsoleBase
+{
+public:
+    // Throws if MapperT is Mapper and the ROM's mapper isn't supported
+    explicit Console(Rom rom);
+
+    void reset() override;
+
+    uint64_t run_frame() override;
+    uint64_t run_frame(TraceBuffer& trace) override;
+
+    void save_state(SaveState& state) const override;
+    void load_state(SaveState& state) override;
+
+    MapperT& mapper() override;
+
+private:
+    template <typename Trace>
+    uint64_t run_frame_with(Trace& trace);
+
+    detail::MapperSlot<MapperT> mapper_;
+};
+
+// A Console over the ROM's mapper, the fallback for mappers without their own
+// instantiation. Throws if the mapper isn't supported at all.
+std::unique_ptr<ConsoleBase> make_console(Rom rom);
+
+}
+
+#endif /* NES_EMULATOR_CONSOLE_H_ */
@@ -0,0 +1,81 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "controller.h"
+
+void emulator::Controller::press(Button button)
+{
+    buttons_.fetch_or(button, std::memory_order_relaxed);
+}
+
+void emulator::Controller::release(Button button)
+{
+    buttons_.fetch_and(static_cast<uint8_t>(~button), std::memory_order_relaxed);
+}
+
+void emulator::Controller::set_buttons(uint8_t buttons)
+{
+    buttons_.store(buttons, std::memory_order_relaxed);
+}
+
+uint8_t emulator::Controller::buttons() const
+{
+    return buttons_.load(std::memory_order_relaxed);
+}
+
+void emulator::Controller::write_strobe(uint8_t value)
+{
+    strobe = value & 0x01;
+
+    // Latched on the falling edge too, the last reload while it was high
+    shift = buttons();
+}
+
+uint8_t emulator::Controller::read()
+{
+    if (strobe)
+    {
+        return buttons() & 0x01;
+    }
+
+    uint8_t value = shift & 0x01;
+
+    // Official controllers shift in 1s
+    shift = shift >> 1 | 0x80;
+
+    return value;
+}
+
+void emulator::Controller::save(SaveState& state) const
+{
+    state.write(shift);
+    state.write(strobe);
+}
+
+void emulator::Controller::load(SaveState& state)
+{
+    state.read(shift);
+    state.read(strobe);
+}
@@ -0,0 +1,94 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+
+Standard controller.
+
+Writing 1 to bit 0 of 0x4016 holds the strobe, which keeps reloading the
+shift register from the buttons. Writing 0 latches them, then each read of
+0x4016 (port 1) or 0x4017 (port 2) shifts out one button in the order A, B,
+Select, Start, Up, Down, Left, Right. Reads past the eighth return 1.
+
+The frontend sets the buttons from its own thread, they are an atomic the
+emulation thread only loads when the shift register is reloaded.
+
+*/
+
+#ifndef NES_EMULATOR_CONTROLLER_H_
+#define NES_EMULATOR_CONTROLLER_H_
+
+#include "save_state.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace emulator
+{
+
+// Bit order is the order they are read out
+enum Button : uint8_t
+{
+    button_a      = 1 << 0,
+    button_b      = 1 << 1,
+    button_select = 1 << 2,
+    button_start  = 1 << 3,
+    button_up     = 1 << 4,
+    button_down   = 1 << 5,
+    button_left   = 1 << 6,
+    button_right  = 1 << 7
+};
+
+class Controller
+{
+public:
+    // From any thread
+    void press(Button button);
+    void release(Button button);
+    void set_buttons(uint8_t buttons);
+    uint8_t buttons() const;
+
+    // 0x4016 writes, only bit 0 matters
+    void write_strobe(uint8_t value);
+
+    // Next button in bit 0
+    uint8_t read();
+
+    // The shift register and strobe, the buttons are live input and are
+    // left alone
+    void save(SaveState& state) const;
+    void load(SaveState& state);
+
+private:
+    std::atomic<uint8_t> buttons_{0};
+
+    uint8_t shift{0};
+    bool strobe{false};
+};
+
+}
+
+#endif /* NES_EMULATOR_CONTROLLER_H_ */
@@ -33,40 +33,8 @@
 
 namespace
 {
-std::string mode_name(emulator::OpMode mode)
-{
-    switch (mode)
-    {
-        case emulator::zero_page_x:
-            return "zpx";
-        case emulator::zero_page_y:
-            return "zpy";
-        case emulator::absolute_x:
-            return "abx";
-        case emulator::absolute_y:
-            return "aby";
-        case emulator::indexed_x:
-            return "izx";
-        case emulator::indexed_y:
-            return "izy";
-        case emulator::implicit:
-            return "imp";
-        case emulator::accumulator:
-            return "acc";
-        case emulator::immediate:
-            return "imm";
-        case emulator::zero_page:
-            return "zp ";
-        case emulator::absolute:
-            return "ab ";
-        case emulator::relative:
-            return "rel";
-        case emulator::indirect:
-            return "ind";
-    }
-
-    throw std::runtime_error("Unkown OpMode");
-}
+// One wait cycle then 256 alternating reads and writes
+uint64_t const oam_dma_cycles{513};
 
 // Is page crossed means we need to incremement the cycle amount
 bool is_page_crossed(uint16_t a, uint16_t b)
@@ -77,9 +45,45 @@ bool is_page_crossed(uint16_t a, uint16_t b)
 
 }
 
-emulator::CPU::CPU(emulator::PPU const* ppu) :
+/*
+    http://wiki.nesdev.com/w/index.php/CPU_memory_map
+
+    0xFFFF cpu addressable space
+
+    Address range     Size     Device
+    ------------------------------------
+    0x0000 - 0x07FF : 0x0800 :  2KB internal ram
+    0x0800 - 0x0FFF : 0x0800 :  Mirrors of 0x0000 - 0x07FF
+    0x1000 - 0x17FF : 0x0800 :      ^           ^
+    0x1800 - 0x1FFF : 0x0800 :      ^           ^
+    0x2000 - 0x2007 : 0x0008 : NES PPU Registers
+    0x2008 - 0x3FFF : 0x1FF8 : Mirros of 0x2000 - 0x2007 (repeats every 8 bytes)
+    0x4000 - 0x4017 : 0x0018 : NES APU and I/O Registers
+    0x4018 - 0x401F : 0x0008 : APU and I/O Functionality that is normally disabled
+    0x4020 - 0xFFFF : 0xBFE0 : Catridge space: PRG ROM, PRG RAM, and mapper registers
+*/
+
+emulator::CPU::CPU(emulator::PPU* ppu) :
     ppu(ppu)
 {
+    // 2KB of internal ram mirrored up to 0x2000
+    bus.map_memory(0x00, 0x20, memory.data(), 0x0800);
+
+    // The PPU works out which of its 8 registers from the low bits
+    bus.map_device(0x20, 0x20, ppu);
+
+    bus.map_device(0x40, 0x01, &io_registers);
+
+    io_registers.set_oam_dma_handler([this] (uint8_t page) {
+        oam_dma(page);
+    });
+
+    // Cartridge space stays open bus until a cartridge maps itself in
+
+    scheduler.set_handler(Event::interrupt, [this] (uint64_t /*when*/) {
+        check_for_interrupt();
+    });
+
     reset();
 
     // TESTING
@@ -128,7 +132,7 @@ void emulator::CPU::reset()
 {
     program_counter_ = read16(0xFFFC);
     stack_  = 0xFD;
-    status_ = 0x24;
+    load_status(0x24);
 }
 
 uint16_t emulator::CPU::program_counter() const
@@ -158,7 +162,7 @@ uint8_t emulator::CPU::stack() const
 
 uint16_t emulator::CPU::zero_page_get_address(uint8_t cpu_register)
 {
-    auto address = read8(program_counter_ + 1) + cpu_register;
+    auto address = (operand_ & 0xFF) + cpu_register;
 
     if (is_page_crossed(address - cpu_register, address))
     {
@@ -170,7 +174,7 @@ uint16_t emulator::CPU::zero_page_get_address(uint8_t cpu_register)
 
 uint16_t emulator::CPU::absolute_get_address(uint8_t cpu_register)
 {
-    auto address = read16(program_counter_ + 1) + cpu_register;
+    auto address = operand_ + cpu_register;
 
     if (is_page_crossed(address - cpu_register, address))
     {
@@ -180,73 +184,52 @@ uint16_t emulator::CPU::absolute_get_address(uint8_t cpu_register)
     return address;
 }
 
+void emulator::CPU::decode_operand(OpMode mode)
+{
+    switch (operand_size(mode))
+    {
+        case 2:
+            operand_ = read16(program_counter_ + 1);
+            break;
+        case 1:
+            operand_ = read8(program_counter_ + 1);
+            break;
+    }
+}
+
 uint16_t emulator::CPU::address_to_arguemnts()
 {
-    auto op   = read8(program_counter_);
-    auto info = instruction[op];
+    auto mode = current_mode();
+    decode_operand(mode);
 
-    switch (info.mode)
+    switch (mode)
     {
         case OpMode::zero_page_x:
-        {
-            return zero_page_get_address(x_register_);
-        }
+            return address_to_arguemnts<OpMode::zero_page_x>();
         case OpMode::zero_page_y:
-        {
-            return zero_page_get_address(y_register_);
-        }
+            return address_to_arguemnts<OpMode::zero_page_y>();
         case OpMode::absolute_x:
-        {
-            return absolute_get_address(x_register_);
-        }
+            return address_to_arguemnts<OpMode::absolute_x>();
         case OpMode::absolute_y:
-        {
-            return absolute_get_address(y_register_);
-        }
+            return address_to_arguemnts<OpMode::absolute_y>();
         case OpMode::indexed_x:
-        {
-            return read16(read8(program_counter_ + 1) + x_register_);
-        }
+            return address_to_arguemnts<OpMode::indexed_x>();
         case OpMode::indexed_y:
-        {
-            return read16(read8(program_counter_ + 1) + y_register_);
-        }
+            return address_to_arguemnts<OpMode::indexed_y>();
         case OpMode::implicit:
-        {
-            return 0;
-        }
+            return address_to_arguemnts<OpMode::implicit>();
         case OpMode::accumulator:
-        {
-            return 0;
-        }
+            return address_to_arguemnts<OpMode::accumulator>();
         case OpMode::immediate:
-        {
-            return program_counter_ + 1;
-        }
+            return address_to_arguemnts<OpMode::immediate>();
         case OpMode::zero_page:
-        {
-            return read8(program_counter_ + 1);
-        }
+            return address_to_arguemnts<OpMode::zero_page>();
         case OpMode::absolute:
-        {
-            return read16(program_counter_ + 1);
-        }
+            return address_to_arguemnts<OpMode::absolute>();
         case OpMode::relative:
-        {
-            uint16_t offset = read8(program_counter_ + 1);
-
-            // Negative
-            if (offset & 0x80)
-            {
-                return program_counter_ + 2 + offset - 0x100;
-            }
-            else
-            {
-                return program_counter_ + 2 + offset;
-            }
-        }
+            return address_to_arguemnts<OpMode::relative>();
         case OpMode::indirect:
-            return read16(read8(program_counter_ + 1));
+            return address_to_arguemnts<OpMode::indirect>();
     }
 
     throw std::runtime_error("Invalid mode for op code");
@@ -255,6 +238,7 @@ uint16_t emulator::CPU::address_to_arguemnts()
 void emulator::CPU::set_program_counter(uint16_t address)
 {
     program_counter_ = address;
+    jumped_          = true;
 }
 
 void emulator::CPU::set_accumulator(uint8_t a)
@@ -279,7 +263,66 @@ void emulator::CPU::set_stack(uint8_t sp)
 
 uint8_t emulator::CPU::status() const
 {
-    return status_;
+    if (!lazy_flags_)
+    {
+        return status_;
+    }
+
+    uint8_t status = status_ & ~(emulator::zero | emulator::sign | emulator::carry | emulator::overflow);
+
+    if (zero())
+    {
+        status |= emulator::zero;
+    }
+
+    if (sign())
+    {
+        status |= emulator::sign;
+    }
+
+    if (carry())
+    {
+        status |= emulator::carry;
+    }
+
+    if (overflow())
+    {
+        status |= emulator::overflow;
+    }
+
+    return status;
+}
+
+void emulator::CPU::set_status(uint8_t status)
+{
+    load_status(status);
+}
+
+void emulator::CPU::load_status(uint8_t status)
+{
+    // An IRQ held off by I is taken once I clears
+    if (irq_line && (status_ & emulator::interrupt) && !(status & emulator::interrupt))
+    {
+        scheduler.schedule(Event::interrupt, cycles_);
+    }
+
+    status_ = status;
+
+    // Pick results that reproduce each flag when worked out lazily
+    zero_result_  = status & emulator::zero ? 0 : 1;
+    sign_result_  = status & emulator::sign;
+    carry_result_ = status & emulator::carry;
+
+    overflow_acc_    = 0;
+    overflow_mem_    = 0;
+    overflow_result_ = status & emulator::overflow ? 0x80 : 0;
+}
+
+void emulator::CPU::set_lazy_flags(bool lazy)
+{
+    auto current_status = status();
+    lazy_flags_ = lazy;
+    load_status(current_status);
 }
 
 void emulator::CPU::update_flags(std::function<bool()> const& f, uint8_t flags)
@@ -296,21 +339,31 @@ void emulator::CPU::update_flags(std::function<bool()> const& f, uint8_t flags)
 
 void emulator::CPU::add_flags(uint8_t flags)
 {
-    status_ |= flags;
+    load_status(status() | flags);
 }
 
 void emulator::CPU::remove_flags(uint8_t flags)
 {
-    status_ &= ~flags;
+    load_status(status() & ~flags);
 }
 
 bool emulator::CPU::carry() const
 {
+    if (lazy_flags_)
+    {
+        return carry_result_;
+    }
+
     return status_ & emulator::carry;
 }
 
 bool emulator::CPU::zero() const
 {
+    if (lazy_flags_)
+    {
+        return zero_result_ == 0;
+    }
+
     return status_ & emulator::zero;
 }
 
@@ -331,87 +384,42 @@ bool emulator::CPU::break_interrupt() const
 
 bool emulator::CPU::overflow() const
 {
+    if (lazy_flags_)
+    {
+        return !((overflow_acc_ ^ overflow_mem_) & 0x80) &&
+                ((overflow_acc_ ^ overflow_result_) & 0x80);
+    }
+
     return status_ & emulator::overflow;
 }
 
 bool emulator::CPU::sign() const
 {
+    if (lazy_flags_)
+    {
+        return sign_result_ & 0x80;
+    }
+
     return status_ & emulator::sign;
 }
 
 emulator::OpMode emulator::CPU::current_mode() const
 {
     auto op = read8(program_counter_);
-    auto info = instruction[op];
+    auto const& info = instruction[op];
 
     return info.mode;
 }
 
-/*
-    http://wiki.nesdev.com/w/index.php/CPU_memory_map
-
-    0xFFFF cpu addressable space
-
-    Address range     Size     Device
-    ------------------------------------
-    0x0000 - 0x07FF : 0x0800 :  2KB internal ram
-    0x0800 - 0x0FFF : 0x0800 :  Mirrors of 0x0000 - 0x07FF
-    0x1000 - 0x17FF : 0x0800 :      ^           ^
-    0x1800 - 0x1FFF : 0x0800 :      ^           ^
-    0x2000 - 0x2007 : 0x0008 : NES PPU Registers
-    0x2008 - 0x3FFF : 0x1FF8 : Mirros of 0x2000 - 0x2007 (repeats every 8 bytes)
-    0x4000 - 0x4017 : 0x0018 : NES APU and I/O Registers
-    0x4018 - 0x401F : 0x0008 : APU and I/O Functionality that is normally disabled
-    0x4020 - 0xFFFF : 0xBFE0 : Catridge space: PRG ROM, PRG RAM, and mapper registers
-*/
-uint8_t emulator::CPU::read8(uint16_t address) const
-{
-    if (address < 0x2000)
-    {
-        return memory.read8(address % 0x0800);
-    }
-    else if (address < 0x4000)
-    {
-        // Since the memory repeats every 8 bytes lets just use the same 8 byte location
-        return memory.read8(0x2000 + address % 8);
-    }
-
-    return memory.read8(address);
-}
-
-uint16_t emulator::CPU::read16(uint16_t address) const
-{
-    // TODO handle other type of memory... ram/ppu/apu?
-    auto low  = read8(address);
-    auto high = read8(address + 1);
-
-    return low | high << 8;
-}
-
-void emulator::CPU::write8(uint16_t address, uint8_t value)
-{
-    if (address < 0x2000)
-    {
-        memory.write8(address % 0x0800, value);
-    }
-    else if (address < 0x4000)
-    {
-        // TODO Figure out how to best get the ppu registers from the ppu memory
-        //uint8_t ppu_address = 0x2000 + address % 8;
-        //ppu_registers[ppu_address] = value;
-    }
-
-    memory.write8(address, value);
-}
-
+// The stack lives in page one
 void emulator::CPU::push(uint8_t byte)
 {
-    write8(stack_--, byte);
+    write8(0x100 | stack_--, byte);
 }
 
 uint8_t emulator::CPU::pop()
 {
-    return read8(++stack_);
+    return read8(0x100 | ++stack_);
 }
 
 void emulator::CPU::add_branch_cycle(uint16_t address)
@@ -423,17 +431,34 @@ void emulator::CPU::add_branch_cycle(uint16_t address)
     }
 }
 
+// Raising a line posts an event rather than being polled each step, so it is
+// serviced before the next instruction
 void emulator::CPU::handle_non_maskable_interrupt()
 {
     nmi_interrupt = true;
+    scheduler.schedule(Event::interrupt, cycles_);
 }
 
-void emulator::CPU::handle_interrupt_request()
+void emulator::CPU::set_interrupt_request(IRQSource source, bool asserted)
 {
-    if (nmi_interrupt == false)
+    if (asserted)
+    {
+        irq_line |= source;
+    }
+    else
     {
-        irq_interrupt = true;
+        irq_line &= ~source;
     }
+
+    if (irq_line && !interrupt())
+    {
+        scheduler.schedule(Event::interrupt, cycles_);
+    }
+}
+
+bool emulator::CPU::interrupt_request() const
+{
+    return irq_line;
 }
 
 void emulator::CPU::check_for_interrupt()
@@ -444,42 +469,293 @@ void emulator::CPU::check_for_interrupt()
         nmi_interrupt = false;
         cycles_ += 7;
     }
-    else if (irq_interrupt)
+    else if (irq_line && !interrupt())
     {
+        // Stays asserted until the device is acknowledged, I being set
+        // here is what stops it being taken again straight away
         irq(this);
-        irq_interrupt = false;
         cycles_ += 7;
     }
 }
 
-uint8_t emulator::CPU::step()
+void emulator::CPU::oam_dma(uint8_t page)
+{
+    std::array<uint8_t, page_size> copy;
+
+    // RAM and ROM are copied straight from host memory, anything else has
+    // to be read through its device
+    auto const* data = bus.read_page(page);
+    if (!data)
+    {
+        for (uint16_t i = 0; i < page_size; i++)
+        {
+            copy[i] = bus.read8(page << 8 | i);
+        }
+        data = copy.data();
+    }
+
+    ppu->oam_dma(data);
+
+    // An extra cycle to line up with a read cycle when starting on an odd one
+    cycles_ += oam_dma_cycles + (cycles_ & 1);
+}
+
+void emulator::CPU::set_core(CPUCore core)
+{
+    // Memory may have been written around the bus while another core ran
+    block_cache.flush();
+    core_ = core;
+}
+
+emulator::CPUCore emulator::CPU::core() const
+{
+    return core_;
+}
+
+emulator::JIT const& emulator::CPU::jit() const
+{
+    return jit_;
+}
+
+void emulator::CPU::set_apu(APU* apu)
+{
+    io_registers.set_apu(apu);
+}
+
+void emulator::CPU::set_controller(uint8_t port, Controller* controller)
+{
+    io_registers.set_controller(port, controller);
+}
+
+void emulator::CPU::save(SaveState& state) const
+{
+    state.write(cycles_);
+    state.write(program_counter_);
+    state.write(operand_);
+    state.write(accumulator_);
+    state.write(x_register_);
+    state.write(y_register_);
+    state.write(stack_);
+    state.write(status_);
+
+    state.write(zero_result_);
+    state.write(sign_result_);
+    state.write(carry_result_);
+    state.write(overflow_acc_);
+    state.write(overflow_mem_);
+    state.write(overflow_result_);
+
+    state.write(nmi_interrupt);
+    state.write(irq_line);
+
+    state.write(memory);
+
+    io_registers.save(state);
+    scheduler.save(state);
+}
+
+void emulator::CPU::load(SaveState& state)
+{
+    state.read(cycles_);
+    state.read(program_counter_);
+    state.read(operand_);
+    state.read(accumulator_);
+    state.read(x_register_);
+    state.read(y_register_);
+    state.read(stack_);
+    state.read(status_);
+
+    state.read(zero_result_);
+    state.read(sign_result_);
+    state.read(carry_result_);
+    state.read(overflow_acc_);
+    state.read(overflow_mem_);
+    state.read(overflow_result_);
+
+    state.read(nmi_interrupt);
+    state.read(irq_line);
+
+    state.read(memory);
+
+    io_registers.load(state);
+    scheduler.load(state);
+
+    // RAM was written behind the block cache's back
+    block_cache.invalidate_writable();
+}
+
+uint16_t emulator::CPU::step()
+{
+    NoTrace trace;
+    return step(trace);
+}
+
+template <typename Trace>
+uint16_t emulator::CPU::step(Trace& trace)
 {
     auto cycles_before_step = cycles_;
 
-    check_for_interrupt();
+    if (scheduler.next() <= cycles_)
+    {
+        scheduler.run_due(cycles_);
+    }
 
-    auto pc = program_counter_;
-    auto op = instruction[read8(pc)];
+    execute_next(trace);
+    return static_cast<uint16_t>(cycles_ - cycles_before_step);
+}
 
-    print_instruction();
+template uint16_t emulator::CPU::step(NoTrace& trace);
+template uint16_t emulator::CPU::step(TraceBuffer& trace);
 
-    op.func(this);
+template <typename Trace>
+void emulator::CPU::execute_next(Trace& trace)
+{
+    if (!Trace::enabled && (core_ == CPUCore::cached_blocks || core_ == CPUCore::jit))
+    {
+        if (core_ == CPUCore::jit)
+        {
+            jit_.reclaim();
+        }
+
+        auto block = block_cache.find(program_counter_);
+
+        if (block)
+        {
+            if (core_ == CPUCore::jit && jit_.translate(*block))
+            {
+                block->native(this);
+            }
+            else
+            {
+                run_block(*block);
+            }
+
+            return;
+        }
+    }
+
+    auto pc     = program_counter_;
+    auto opcode = read8(pc);
+    auto const& op = instruction[opcode];
+
+    if constexpr (Trace::enabled)
+    {
+        trace.record({cycles_, pc, opcode, accumulator_, x_register_, y_register_, status(), stack_});
+    }
+
+    jumped_ = false;
+
+    if (core_ == CPUCore::function_table)
+    {
+        decode_operand(op.mode);
+        op.func(this);
+    }
+    else
+    {
+        execute(this, opcode);
+    }
 
     // No op moved the pc, so lets move up ourselfs
-    if (pc == program_counter_)
+    if (!jumped_)
     {
         program_counter_ += op.number_bytes;
     }
 
     cycles_ += op.number_cycles;
-    return cycles_ - cycles_before_step;
+}
+
+uint64_t emulator::CPU::cycles() const
+{
+    return cycles_;
+}
+
+uint64_t emulator::CPU::run_until(uint64_t cycle)
+{
+    NoTrace trace;
+    return run_until(cycle, trace);
+}
+
+template <typename Trace>
+uint64_t emulator::CPU::run_until(uint64_t cycle, Trace& trace)
+{
+    auto start = cycles_;
+
+    while (cycles_ < cycle)
+    {
+        scheduler.run_due(cycles_);
+
+        // Nothing needs the CPU's attention before the next event
+        while (cycles_ < cycle && cycles_ < scheduler.next())
+        {
+            execute_next(trace);
+        }
+    }
+
+    return cycles_ - start;
+}
+
+template uint64_t emulator::CPU::run_until(uint64_t cycle, NoTrace& trace);
+template uint64_t emulator::CPU::run_until(uint64_t cycle, TraceBuffer& trace);
+
+uint64_t emulator::CPU::run_for(uint64_t cycles)
+{
+    return run_until(cycles_ + cycles);
+}
+
+// Frames are 341 * 262 dots, a third of which is not a whole number of CPU
+// cycles. Working the boundary out from the frame number keeps the
+// remainder from drifting.
+uint64_t emulator::CPU::run_frame()
+{
+    NoTrace trace;
+    return run_frame(trace);
+}
+
+template <typename Trace>
+uint64_t emulator::CPU::run_frame(Trace& trace)
+{
+    uint64_t next_frame = cycles_ * ppu_dots_per_cpu_cycle / ppu_dots_per_frame + 1;
+    uint64_t frame_dots = next_frame * ppu_dots_per_frame;
+
+    return run_until((frame_dots + ppu_dots_per_cpu_cycle - 1) / ppu_dots_per_cpu_cycle, trace);
+}
+
+template uint64_t emulator::CPU::run_frame(NoTrace& trace);
+template uint64_t emulator::CPU::run_frame(TraceBuffer& trace);
+
+// Interrupts are only looked at between blocks, a block is short enough
+// that this only delays them by a few ops
+void emulator::CPU::run_block(BlockCache::Block const& block)
+{
+    auto generation = block_cache.generation();
+
+    for (auto const& op : block.ops)
+    {
+        operand_ = op.operand;
+        jumped_  = false;
+
+        op.handler(this);
+
+        if (!jumped_)
+        {
+            program_counter_ += op.number_bytes;
+        }
+
+        cycles_ += op.number_cycles;
+
+        // The op wrote over cached code, which may be the rest of this block
+        if (generation != block_cache.generation())
+        {
+            break;
+        }
+    }
 }
 
 void emulator::CPU::print_instruction() const
 {
     auto op = read8(program_counter_);
-    auto info = instruction[op];
-    std::string mode_str = mode_name(static_cast<OpMode>(info.mode));
+    auto const& info = instruction[op];
+    std::string mode_str = emulator::mode_name(static_cast<OpMode>(info.mode));
 
     std::cout << "PC: " << std::hex << "0x" << program_counter_ << " "
               << "A: 0x" << (int)accumulator_ << " "
@@ -521,7 +797,7 @@ void emulator::CPU::print_instruction() const
 void emulator::CPU::dump_ram() const
 {
 
-    for (auto i = 0u; i < 0x1000; i++)
+    for (auto i = 0u; i < 0x0800; i++)
     {
         if (memory.read8(i) <= 0xF)
         {
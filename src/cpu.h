@@ -79,9 +79,16 @@ Relative
 #include <cstdint>
 #include <functional>
 
+#include "block_cache.h"
+#include "bus.h"
 #include "cpu_instructions.h"
+#include "io_registers.h"
+#include "jit.h"
 #include "memory.h"
 #include "ppu.h"
+#include "save_state.h"
+#include "scheduler.h"
+#include "trace.h"
 
 namespace emulator
 {
@@ -98,10 +105,35 @@ enum CPUFlag : uint8_t
     sign      = 1 << 7  // N
 };
 
+// Devices that can hold the IRQ line down, it stays asserted while any of
+// them does
+enum IRQSource : uint8_t
+{
+    irq_apu    = 1 << 0,
+    irq_mapper = 1 << 1
+};
+
+// Which interpreter core step() runs. The function table core calls through
+// OpInfo::func, the switch core jumps straight to the inlined handlers and the
+// cached block core runs a whole predecoded basic block per step. The JIT core
+// runs hot blocks as native code, falling back to cached blocks where the JIT
+// is unavailable.
+enum class CPUCore : uint8_t
+{
+    function_table,
+    switch_dispatch,
+    cached_blocks,
+    jit
+};
+
 class CPU
 {
 public:
-    explicit CPU(PPU const* ppu);
+    explicit CPU(PPU* ppu);
+
+    // The bus points into this CPU's memory
+    CPU(CPU const&) = delete;
+    CPU& operator=(CPU const&) = delete;
 
     void reset();
 
@@ -113,6 +145,18 @@ public:
     // TODO Maybe btter name here or think of their relationship
     uint16_t address_to_arguemnts();
 
+    template <OpMode Mode>
+    uint16_t address_to_arguemnts();
+
+    // The bytes after the op code, handlers work out their address from this
+    // rather than reading past the program counter themselves
+    template <OpMode Mode>
+    void decode_operand();
+    void decode_operand(OpMode mode);
+
+    uint16_t operand() const;
+    void set_operand(uint16_t operand);
+
     uint16_t program_counter() const;
     uint8_t  accumulator() const;
     uint8_t  x_register() const;
@@ -130,6 +174,18 @@ public:
     void add_flags(uint8_t flags);
     void remove_flags(uint8_t flags);
 
+    // In lazy flag mode Z, N, C and V are not written into the status
+    // register as each op runs. The last result and operands are recorded
+    // instead, and the flags are only worked out from them once status() or
+    // one of the flag getters asks for them.
+    void set_lazy_flags(bool lazy);
+    bool lazy_flags() const;
+
+    void set_zero_result(uint8_t value);
+    void set_sign_result(uint8_t value);
+    void set_carry_result(bool carry);
+    void set_overflow_result(uint8_t acc, uint8_t mem, uint8_t new_value);
+
     bool carry() const;
     bool zero() const;
     bool interrupt() const;
@@ -145,37 +201,260 @@ public:
 
     virtual void add_branch_cycle(uint16_t address);
 
+    // NMI is an edge, each call is taken once
     void handle_non_maskable_interrupt();
-    void handle_interrupt_request();
 
-    uint8_t step();
+    // IRQ is a level, taken before the next instruction whenever a source
+    // holds it and I is clear. Clearing I with CLI, PLP or RTI looks again.
+    void set_interrupt_request(IRQSource source, bool asserted);
+    bool interrupt_request() const;
+
+    // The whole status register, as PLP and RTI pull it
+    void set_status(uint8_t status);
+
+    void set_core(CPUCore core);
+    CPUCore core() const;
+
+    JIT const& jit() const;
+
+    // APU registers go to apu once set
+    void set_apu(APU* apu);
+
+    // Read through 0x4016 and 0x4017, port 0 or 1
+    void set_controller(uint8_t port, Controller* controller);
+
+    // Registers, RAM, the I/O registers and the scheduler's events. Loading
+    // drops any blocks cached from RAM.
+    void save(SaveState& state) const;
+    void load(SaveState& state);
+
+    // Runs one instruction, or one block on the block and JIT cores, and
+    // returns the cycles it took including any DMA stall
+    uint16_t step();
+
+    // Trace is NoTrace or TraceBuffer, tracing runs one instruction a step
+    // whatever the core so every instruction gets a record
+    template <typename Trace>
+    uint16_t step(Trace& trace);
+
+    uint64_t cycles() const;
+
+    // Run until the master clock reaches cycle, finishing the instruction
+    // that crosses it. These return the cycles actually run.
+    uint64_t run_until(uint64_t cycle);
+    uint64_t run_for(uint64_t cycles);
+
+    // Up to the start of the next frame
+    uint64_t run_frame();
+
+    template <typename Trace>
+    uint64_t run_until(uint64_t cycle, Trace& trace);
+
+    template <typename Trace>
+    uint64_t run_frame(Trace& trace);
 
     void print_instruction() const;
 
     // DEBUG ONLY
     void dump_ram() const;
 
-    Memory<65535> memory;
+    // The 2KB of internal RAM, everything else on the bus belongs to a device
+    // or the cartridge
+    Memory<0x0800> memory;
+    Bus bus;
+
+    // Devices post their next event here, timed on this CPU's cycles
+    Scheduler scheduler;
+
 private:
+    // Generated code reads and writes the registers directly
+    friend class JIT;
+
     uint16_t zero_page_get_address(uint8_t cpu_register);
     uint16_t absolute_get_address(uint8_t cpu_register);
 
     void check_for_interrupt();
 
+    // Copies a page into OAM and stalls for it in one go
+    void oam_dma(uint8_t page);
+
+    void run_block(BlockCache::Block const& block);
+
+    // One instruction or block without looking at the scheduler
+    template <typename Trace>
+    void execute_next(Trace& trace);
+
+    void load_status(uint8_t status);
+
+    // Master clock, CPU cycles since power on
+    uint64_t cycles_{0};
+
     uint16_t program_counter_{0};
+    uint16_t operand_{0};
+    // Set when an op jumps, so a jump to itself is not taken as falling through
+    bool jumped_{false};
     uint8_t accumulator_{0};
     uint8_t x_register_{0};
     uint8_t y_register_{0};
     uint8_t stack_{0};
     uint8_t status_{0};
-    uint8_t cycles_{0};
+
+    bool lazy_flags_{false};
+    uint8_t zero_result_{0};
+    uint8_t sign_result_{0};
+    bool carry_result_{false};
+    uint8_t overflow_acc_{0};
+    uint8_t overflow_mem_{0};
+    uint8_t overflow_result_{0};
+
+    IORegisters io_registers;
 
     bool nmi_interrupt{false};
-    bool irq_interrupt{false};
 
-    PPU const* ppu;
+    // IRQSource bits of everything holding the line
+    uint8_t irq_line{0};
+
+    CPUCore core_{CPUCore::switch_dispatch};
+
+    // Needs to come after the bus it protects
+    BlockCache block_cache{&bus};
+    JIT jit_{this, &block_cache};
+
+    PPU* ppu;
 };
 
+inline uint8_t CPU::read8(uint16_t address) const
+{
+    return bus.read8(address);
+}
+
+inline uint16_t CPU::read16(uint16_t address) const
+{
+    auto low  = read8(address);
+    auto high = read8(address + 1);
+
+    return low | high << 8;
+}
+
+inline void CPU::write8(uint16_t address, uint8_t value)
+{
+    bus.write8(address, value);
+}
+
+inline bool CPU::lazy_flags() const
+{
+    return lazy_flags_;
+}
+
+inline void CPU::set_zero_result(uint8_t value)
+{
+    zero_result_ = value;
+}
+
+inline void CPU::set_sign_result(uint8_t value)
+{
+    sign_result_ = value;
+}
+
+inline void CPU::set_carry_result(bool carry)
+{
+    carry_result_ = carry;
+}
+
+inline void CPU::set_overflow_result(uint8_t acc, uint8_t mem, uint8_t new_value)
+{
+    overflow_acc_    = acc;
+    overflow_mem_    = mem;
+    overflow_result_ = new_value;
+}
+
+inline uint16_t CPU::operand() const
+{
+    return operand_;
+}
+
+inline void CPU::set_operand(uint16_t operand)
+{
+    operand_ = operand;
+}
+
+template <OpMode Mode>
+void CPU::decode_operand()
+{
+    if constexpr (operand_size(Mode) == 2)
+    {
+        operand_ = read16(program_counter_ + 1);
+    }
+    else if constexpr (operand_size(Mode) == 1)
+    {
+        operand_ = read8(program_counter_ + 1);
+    }
+}
+
+template <OpMode Mode>
+uint16_t CPU::address_to_arguemnts()
+{
+    if constexpr (Mode == OpMode::zero_page_x)
+    {
+        return zero_page_get_address(x_register_);
+    }
+    else if constexpr (Mode == OpMode::zero_page_y)
+    {
+        return zero_page_get_address(y_register_);
+    }
+    else if constexpr (Mode == OpMode::absolute_x)
+    {
+        return absolute_get_address(x_register_);
+    }
+    else if constexpr (Mode == OpMode::absolute_y)
+    {
+        return absolute_get_address(y_register_);
+    }
+    else if constexpr (Mode == OpMode::indexed_x)
+    {
+        return read16((operand_ & 0xFF) + x_register_);
+    }
+    else if constexpr (Mode == OpMode::indexed_y)
+    {
+        return read16((operand_ & 0xFF) + y_register_);
+    }
+    else if constexpr (Mode == OpMode::implicit || Mode == OpMode::accumulator)
+    {
+        return 0;
+    }
+    else if constexpr (Mode == OpMode::immediate)
+    {
+        return program_counter_ + 1;
+    }
+    else if constexpr (Mode == OpMode::zero_page)
+    {
+        return operand_ & 0xFF;
+    }
+    else if constexpr (Mode == OpMode::absolute)
+    {
+        return operand_;
+    }
+    else if constexpr (Mode == OpMode::relative)
+    {
+        uint16_t offset = operand_ & 0xFF;
+
+        // Negative
+        if (offset & 0x80)
+        {
+            return program_counter_ + 2 + offset - 0x100;
+        }
+        else
+        {
+            return program_counter_ + 2 + offset;
+        }
+    }
+    else
+    {
+        static_assert(Mode == OpMode::indirect, "Invalid mode for op code");
+        return read16(operand_ & 0xFF);
+    }
+}
+
 }
 
 #endif /* NES_EMULATOR_CPU_H_ */
@@ -29,6 +29,7 @@
 #include <array>
 #include <cstdint>
 #include <functional>
+#include <string>
 
 namespace emulator
 {
@@ -58,6 +59,27 @@ enum OpMode : uint8_t
     indirect
 };
 
+// Bytes of operand following the op code
+constexpr uint8_t operand_size(OpMode mode)
+{
+    switch (mode)
+    {
+        case implicit:
+        case accumulator:
+            return 0;
+        case absolute:
+        case absolute_x:
+        case absolute_y:
+        case indirect:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+// Three letter name for the mode, as shown in traces
+std::string mode_name(OpMode mode);
+
 struct OpInfo
 {
     std::string name;
@@ -149,267 +171,279 @@ extern void txs(CPU* cpu);
 extern void tya(CPU* cpu);
 extern void xaa(CPU* cpu);
 
+// Runs the handler for op without going through OpInfo::func
+extern void execute(CPU* cpu, uint8_t op);
+
 // http://www.oxyron.de/html/opcodes02.html
-static std::array<OpInfo, 256> const instruction{{
-/*         | name |  mode   | number of| number of |add cycle if  |     Function
-           |      |         |  bytes   |  cycles   | page crossed |              */
-/* 0x00 */ {"BRK", implicit,     1,         7,       zero_page_cycles,    brk},
-/* 0x01 */ {"ORA", indexed_x,    2,         6,       zero_page_cycles,    ora},
-/* 0x02 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0x03 */ {"SLO", indexed_x,    0,         8,       zero_page_cycles,    slo},
-/* 0x04 */ {"NOP", zero_page,    2,         3,       zero_page_cycles,    nop},
-/* 0x05 */ {"ORA", zero_page,    2,         3,       zero_page_cycles,    ora},
-/* 0x06 */ {"ASL", zero_page,    2,         5,       zero_page_cycles,    asl},
-/* 0x07 */ {"SLO", zero_page,    0,         5,       zero_page_cycles,    slo},
-/* 0x08 */ {"PHP", implicit,     1,         3,       zero_page_cycles,    php},
-/* 0x09 */ {"ORA", immediate,    2,         2,       zero_page_cycles,    ora},
-/* 0x0A */ {"ASL", accumulator,  1,         2,       zero_page_cycles,    asl},
-/* 0x0B */ {"ANC", immediate,    0,         2,       zero_page_cycles,    anc},
-/* 0x0C */ {"NOP", absolute,     3,         4,       zero_page_cycles,    nop},
-/* 0x0D */ {"ORA", absolute,     3,         4,       zero_page_cycles,    ora},
-/* 0x0E */ {"ASL", absolute,     3,         6,       zero_page_cycles,    asl},
-/* 0x0F */ {"SLO", absolute,     0,         6,       zero_page_cycles,    slo},
-/* 0x10 */ {"BPL", relative,     2,         2,       one_page_cylce,      bpl},
-/* 0x11 */ {"ORA", indexed_y,    2,         5,       one_page_cylce,      ora},
-/* 0x12 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0x13 */ {"SLO", indexed_y,    0,         8,       zero_page_cycles,    slo},
-/* 0x14 */ {"NOP", zero_page_x,  2,         4,       zero_page_cycles,    nop},
-/* 0x15 */ {"ORA", zero_page_x,  2,         4,       zero_page_cycles,    ora},
-/* 0x16 */ {"ASL", zero_page_x,  2,         6,       zero_page_cycles,    asl},
-/* 0x17 */ {"SLO", zero_page_x,  0,         6,       zero_page_cycles,    slo},
-/* 0x18 */ {"CLC", implicit,     1,         2,       zero_page_cycles,    clc},
-/* 0x19 */ {"ORA", absolute_y,   3,         4,       one_page_cylce,      ora},
-/* 0x1A */ {"NOP", implicit,     1,         2,       zero_page_cycles,    nop},
-/* 0x1B */ {"SLO", absolute_y,   0,         7,       zero_page_cycles,    slo},
-/* 0x1C */ {"NOP", absolute_x,   3,         4,       one_page_cylce,      nop},
-/* 0x1D */ {"ORA", absolute_x,   3,         4,       one_page_cylce,      ora},
-/* 0x1E */ {"ASL", absolute_x,   3,         7,       zero_page_cycles,    asl},
-/* 0x1F */ {"SLO", absolute_x,   0,         7,       zero_page_cycles,    slo},
-/* 0x20 */ {"JSR", absolute,     3,         6,       zero_page_cycles,    jsr},
-/* 0x21 */ {"AND", indexed_x,    2,         6,       zero_page_cycles,    nd},
-/* 0x22 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0x23 */ {"RLA", indexed_x,    0,         8,       zero_page_cycles,    rla},
-/* 0x24 */ {"BIT", zero_page,    2,         3,       zero_page_cycles,    bit},
-/* 0x25 */ {"AND", zero_page,    2,         3,       zero_page_cycles,    nd},
-/* 0x26 */ {"ROL", zero_page,    2,         5,       zero_page_cycles,    rol},
-/* 0x27 */ {"RLA", zero_page,    0,         5,       zero_page_cycles,    rla},
-/* 0x28 */ {"PLP", implicit,     1,         4,       zero_page_cycles,    plp},
-/* 0x29 */ {"AND", immediate,    2,         2,       zero_page_cycles,    nd},
-/* 0x2A */ {"ROL", accumulator,  1,         2,       zero_page_cycles,    rol},
-/* 0x2B */ {"ANC", immediate,    0,         2,       zero_page_cycles,    anc},
-/* 0x2C */ {"BIT", absolute,     3,         4,       zero_page_cycles,    bit},
-/* 0x2D */ {"AND", absolute,     3,         4,       zero_page_cycles,    nd},
-/* 0x2E */ {"ROL", absolute,     3,         6,       zero_page_cycles,    rol},
-/* 0x2F */ {"RLA", absolute,     0,         6,       zero_page_cycles,    rla},
-/* 0x30 */ {"BMI", relative,     2,         2,       one_page_cylce,      bmi},
-/* 0x31 */ {"AND", indexed_y,    2,         5,       one_page_cylce,      nd},
-/* 0x32 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0x33 */ {"RLA", indexed_y,    0,         8,       zero_page_cycles,    rla},
-/* 0x34 */ {"NOP", zero_page_x,  2,         4,       zero_page_cycles,    nop},
-/* 0x35 */ {"AND", zero_page_x,  2,         4,       zero_page_cycles,    nd},
-/* 0x36 */ {"ROL", zero_page_x,  2,         6,       zero_page_cycles,    rol},
-/* 0x37 */ {"RLA", zero_page_x,  0,         6,       zero_page_cycles,    rla},
-/* 0x38 */ {"SEC", implicit,     1,         2,       zero_page_cycles,    sec},
-/* 0x39 */ {"AND", absolute_y,   3,         4,       one_page_cylce,      nd},
-/* 0x3A */ {"NOP", implicit,     1,         2,       zero_page_cycles,    nop},
-/* 0x3B */ {"RLA", absolute_y,   0,         7,       zero_page_cycles,    rla},
-/* 0x3C */ {"NOP", absolute_x,   3,         4,       one_page_cylce,      nop},
-/* 0x3D */ {"AND", absolute_x,   3,         4,       one_page_cylce,      nd},
-/* 0x3E */ {"ROL", absolute_x,   3,         7,       zero_page_cycles,    rol},
-/* 0x3F */ {"RLA", absolute_x,   0,         7,       zero_page_cycles,    rla},
-/* 0x40 */ {"RTI", implicit,     1,         6,       zero_page_cycles,    rti},
-/* 0x41 */ {"EOR", indexed_x,    2,         6,       zero_page_cycles,    eor},
-/* 0x42 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0x43 */ {"SRE", indexed_x,    0,         8,       zero_page_cycles,    sre},
-/* 0x44 */ {"NOP", zero_page,    2,         3,       zero_page_cycles,    nop},
-/* 0x45 */ {"EOR", zero_page,    2,         3,       zero_page_cycles,    nop},
-/* 0x46 */ {"LSR", zero_page,    2,         5,       zero_page_cycles,    lsr},
-/* 0x47 */ {"SRE", zero_page,    0,         5,       zero_page_cycles,    sre},
-/* 0x48 */ {"PHA", implicit,     1,         3,       zero_page_cycles,    pha},
-/* 0x49 */ {"EOR", immediate,    2,         2,       zero_page_cycles,    eor},
-/* 0x4A */ {"LSR", accumulator,  1,         2,       zero_page_cycles,    lsr},
-/* 0x4B */ {"ALR", immediate,    0,         2,       zero_page_cycles,    alr},
-/* 0x4C */ {"JMP", absolute,     3,         3,       zero_page_cycles,    jmp},
-/* 0x4D */ {"EOR", absolute,     3,         4,       zero_page_cycles,    eor},
-/* 0x4E */ {"LSR", absolute,     3,         6,       zero_page_cycles,    lsr},
-/* 0x4F */ {"SRE", absolute,     0,         6,       zero_page_cycles,    sre},
-/* 0x50 */ {"BVC", relative,     2,         2,       one_page_cylce,      bvc},
-/* 0x51 */ {"EOR", indexed_y,    2,         5,       one_page_cylce,      eor},
-/* 0x52 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0x53 */ {"SRE", indexed_y,    0,         8,       zero_page_cycles,    sre},
-/* 0x54 */ {"NOP", zero_page_x,  2,         4,       zero_page_cycles,    nop},
-/* 0x55 */ {"EOR", zero_page_x,  2,         4,       zero_page_cycles,    eor},
-/* 0x56 */ {"LSR", zero_page_x,  2,         6,       zero_page_cycles,    lsr},
-/* 0x57 */ {"SRE", zero_page_x,  0,         6,       zero_page_cycles,    sre},
-/* 0x58 */ {"CLI", implicit,     1,         2,       zero_page_cycles,    cli},
-/* 0x59 */ {"EOR", absolute_y,   3,         4,       one_page_cylce,      eor},
-/* 0x5A */ {"NOP", implicit,     1,         2,       zero_page_cycles,    nop},
-/* 0x5B */ {"SRE", absolute_y,   0,         7,       zero_page_cycles,    sre},
-/* 0x5C */ {"NOP", absolute_x,   3,         4,       one_page_cylce,      nop},
-/* 0x5D */ {"EOR", absolute_x,   3,         4,       one_page_cylce,      eor},
-/* 0x5E */ {"LSR", absolute_x,   3,         7,       zero_page_cycles,    lsr},
-/* 0x5F */ {"SRE", absolute_x,   0,         7,       zero_page_cycles,    sre},
-/* 0x60 */ {"RTS", implicit,     1,         6,       zero_page_cycles,    rts},
-/* 0x61 */ {"ADC", indexed_x,    2,         6,       zero_page_cycles,    adc},
-/* 0x62 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0x63 */ {"RRA", indexed_x,    0,         8,       zero_page_cycles,    rra},
-/* 0x64 */ {"NOP", zero_page,    2,         3,       zero_page_cycles,    nop},
-/* 0x65 */ {"ADC", zero_page,    2,         3,       zero_page_cycles,    adc},
-/* 0x66 */ {"ROR", zero_page,    2,         5,       zero_page_cycles,    ror},
-/* 0x67 */ {"RRA", zero_page,    0,         5,       zero_page_cycles,    rra},
-/* 0x68 */ {"PLA", implicit,     1,         4,       zero_page_cycles,    pla},
-/* 0x69 */ {"ADC", immediate,    2,         2,       zero_page_cycles,    adc},
-/* 0x6A */ {"ROR", accumulator,  1,         2,       zero_page_cycles,    ror},
-/* 0x6B */ {"ARR", immediate,    0,         2,       zero_page_cycles,    arr},
-/* 0x6C */ {"JMP", indirect,     3,         5,       zero_page_cycles,    jmp},
-/* 0x6D */ {"ADC", absolute,     3,         4,       zero_page_cycles,    adc},
-/* 0x6E */ {"ROR", absolute,     3,         6,       zero_page_cycles,    ror},
-/* 0x6F */ {"RRA", absolute,     0,         6,       zero_page_cycles,    rra},
-/* 0x70 */ {"BVS", relative,     2,         2,       one_page_cylce,      bvs},
-/* 0x71 */ {"ADC", indexed_y,    2,         5,       one_page_cylce,      adc},
-/* 0x72 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0x73 */ {"RRA", indexed_y,    0,         8,       zero_page_cycles,    rra},
-/* 0x74 */ {"NOP", zero_page_x,  2,         4,       zero_page_cycles,    nop},
-/* 0x75 */ {"ADC", zero_page_x,  2,         4,       zero_page_cycles,    adc},
-/* 0x76 */ {"ROR", zero_page_x,  2,         6,       zero_page_cycles,    ror},
-/* 0x77 */ {"RRA", zero_page_x,  0,         6,       zero_page_cycles,    rra},
-/* 0x78 */ {"SEI", implicit,     1,         2,       zero_page_cycles,    sei},
-/* 0x79 */ {"ADC", absolute_y,   3,         4,       one_page_cylce,      adc},
-/* 0x7A */ {"NOP", implicit,     1,         2,       zero_page_cycles,    nop},
-/* 0x7B */ {"RRA", absolute_y,   0,         7,       zero_page_cycles,    rra},
-/* 0x7C */ {"NOP", absolute_x,   3,         4,       one_page_cylce,      nop},
-/* 0x7D */ {"ADC", absolute_x,   3,         4,       one_page_cylce,      adc},
-/* 0x7E */ {"ROR", absolute_x,   3,         7,       zero_page_cycles,    ror},
-/* 0x7F */ {"RRA", absolute_x,   0,         7,       zero_page_cycles,    rra},
-/* 0x80 */ {"NOP", immediate,    2,         2,       zero_page_cycles,    nop},
-/* 0x81 */ {"STA", indexed_x,    2,         6,       zero_page_cycles,    sta},
-/* 0x82 */ {"NOP", immediate,    0,         2,       zero_page_cycles,    nop},
-/* 0x83 */ {"SAX", indexed_x,    0,         6,       zero_page_cycles,    sax},
-/* 0x84 */ {"STY", zero_page,    2,         3,       zero_page_cycles,    sty},
-/* 0x85 */ {"STA", zero_page,    2,         3,       zero_page_cycles,    sta},
-/* 0x86 */ {"STX", zero_page,    2,         3,       zero_page_cycles,    stx},
-/* 0x87 */ {"SAX", zero_page,    0,         3,       zero_page_cycles,    sax},
-/* 0x88 */ {"DEY", implicit,     1,         2,       zero_page_cycles,    dey},
-/* 0x89 */ {"NOP", immediate,    0,         2,       zero_page_cycles,    nop},
-/* 0x8A */ {"TXA", implicit,     1,         2,       zero_page_cycles,    txa},
-/* 0x8B */ {"XAA", immediate,    0,         2,       zero_page_cycles,    xaa},
-/* 0x8C */ {"STY", absolute,     3,         4,       zero_page_cycles,    sty},
-/* 0x8D */ {"STA", absolute,     3,         4,       zero_page_cycles,    sta},
-/* 0x8E */ {"STX", absolute,     3,         4,       zero_page_cycles,    stx},
-/* 0x8F */ {"SAX", absolute,     0,         4,       zero_page_cycles,    sax},
-/* 0x90 */ {"BCC", relative,     2,         2,       one_page_cylce,      bcc},
-/* 0x91 */ {"STA", indexed_y,    2,         6,       zero_page_cycles,    sta},
-/* 0x92 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0x93 */ {"AHX", indexed_y,    0,         6,       zero_page_cycles,    ahx},
-/* 0x94 */ {"STY", zero_page_x,  2,         4,       zero_page_cycles,    sty},
-/* 0x95 */ {"STA", zero_page_x,  2,         4,       zero_page_cycles,    sta},
-/* 0x96 */ {"STX", zero_page_y,  2,         4,       zero_page_cycles,    stx},
-/* 0x97 */ {"SAX", zero_page_y,  0,         4,       zero_page_cycles,    sax},
-/* 0x98 */ {"TYA", implicit,     1,         2,       zero_page_cycles,    tya},
-/* 0x99 */ {"STA", absolute_y,   3,         5,       zero_page_cycles,    sta},
-/* 0x9A */ {"TXS", implicit,     1,         2,       zero_page_cycles,    txs},
-/* 0x9B */ {"TAS", absolute_y,   0,         5,       zero_page_cycles,    tas},
-/* 0x9C */ {"SHY", absolute_x,   0,         5,       zero_page_cycles,    shy},
-/* 0x9D */ {"STA", absolute_x,   3,         5,       zero_page_cycles,    sta},
-/* 0x9E */ {"SHX", zero_page_x,  0,         5,       zero_page_cycles,    shx},
-/* 0x9F */ {"AHX", zero_page_x,  0,         5,       zero_page_cycles,    ahx},
-/* 0xA0 */ {"LDY", immediate,    2,         2,       zero_page_cycles,    ldy},
-/* 0xA1 */ {"LDA", indexed_x,    2,         6,       zero_page_cycles,    lda},
-/* 0xA2 */ {"LDX", immediate,    2,         2,       zero_page_cycles,    ldx},
-/* 0xA3 */ {"LAX", indexed_x,    0,         6,       zero_page_cycles,    lax},
-/* 0xA4 */ {"LDY", zero_page,    2,         3,       zero_page_cycles,    ldy},
-/* 0xA5 */ {"LDA", zero_page,    2,         3,       zero_page_cycles,    lda},
-/* 0xA6 */ {"LDX", zero_page,    2,         3,       zero_page_cycles,    ldx},
-/* 0xA7 */ {"LAX", zero_page,    0,         3,       zero_page_cycles,    lax},
-/* 0xA8 */ {"TAY", implicit,     1,         2,       zero_page_cycles,    tay},
-/* 0xA9 */ {"LDA", immediate,    2,         2,       zero_page_cycles,    lda},
-/* 0xAA */ {"TAX", implicit,     1,         2,       zero_page_cycles,    tax},
-/* 0xAB */ {"LAX", immediate,    0,         2,       zero_page_cycles,    lax},
-/* 0xAC */ {"LDY", absolute,     3,         4,       zero_page_cycles,    ldy},
-/* 0xAD */ {"LDA", absolute,     3,         4,       zero_page_cycles,    lda},
-/* 0xAE */ {"LDX", absolute,     3,         4,       zero_page_cycles,    ldx},
-/* 0xAF */ {"LAX", absolute,     0,         4,       zero_page_cycles,    lax},
-/* 0xB0 */ {"BCS", relative,     2,         2,       one_page_cylce,      bcs},
-/* 0xB1 */ {"LDA", indexed_y,    2,         5,       one_page_cylce,      lda},
-/* 0xB2 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0xB3 */ {"LAX", indexed_y,    0,         5,       one_page_cylce,      lax},
-/* 0xB4 */ {"LDY", zero_page_x,  2,         4,       zero_page_cycles,    ldy},
-/* 0xB5 */ {"LDA", zero_page_x,  2,         4,       zero_page_cycles,    lda},
-/* 0xB6 */ {"LDX", zero_page_y,  2,         4,       zero_page_cycles,    ldx},
-/* 0xB7 */ {"LAX", zero_page_y,  0,         4,       zero_page_cycles,    lax},
-/* 0xB8 */ {"CLV", implicit,     1,         2,       zero_page_cycles,    clv},
-/* 0xB9 */ {"LDA", absolute_y,   3,         4,       one_page_cylce,      lda},
-/* 0xBA */ {"TSX", implicit,     1,         2,       zero_page_cycles,    tsx},
-/* 0xBB */ {"LAS", absolute_y,   0,         4,       one_page_cylce,      las},
-/* 0xBC */ {"LDY", absolute_x,   3,         4,       one_page_cylce,      ldy},
-/* 0xBD */ {"LDA", absolute_x,   3,         4,       one_page_cylce,      lda},
-/* 0xBE */ {"LDX", zero_page_x,  3,         4,       one_page_cylce,      ldx},
-/* 0xBF */ {"LAX", zero_page_x,  0,         4,       one_page_cylce,      lax},
-/* 0xC0 */ {"CPY", immediate,    2,         2,       zero_page_cycles,    cpy},
-/* 0xC1 */ {"CMP", indexed_x,    2,         6,       zero_page_cycles,    cmp},
-/* 0xC2 */ {"NOP", immediate,    0,         2,       zero_page_cycles,    nop},
-/* 0xC3 */ {"DCP", indexed_x,    0,         8,       zero_page_cycles,    dcp},
-/* 0xC4 */ {"CPY", zero_page,    2,         3,       zero_page_cycles,    cpy},
-/* 0xC5 */ {"CMP", zero_page,    2,         3,       zero_page_cycles,    cmp},
-/* 0xC6 */ {"DEC", zero_page,    2,         5,       zero_page_cycles,    dec},
-/* 0xC7 */ {"DCP", zero_page,    0,         5,       zero_page_cycles,    dcp},
-/* 0xC8 */ {"INY", implicit,     1,         2,       zero_page_cycles,    iny},
-/* 0xC9 */ {"CMP", immediate,    2,         2,       zero_page_cycles,    cmp},
-/* 0xCA */ {"DEX", implicit,     1,         2,       zero_page_cycles,    dex},
-/* 0xCB */ {"AXS", immediate,    0,         2,       zero_page_cycles,    axs},
-/* 0xCC */ {"CPY", absolute,     3,         4,       zero_page_cycles,    cpy},
-/* 0xCD */ {"CMP", absolute,     3,         4,       zero_page_cycles,    cmp},
-/* 0xCE */ {"DEC", absolute,     3,         6,       zero_page_cycles,    dec},
-/* 0xCF */ {"DCP", absolute,     0,         6,       zero_page_cycles,    dcp},
-/* 0xD0 */ {"BNE", relative,     2,         2,       one_page_cylce,      bne},
-/* 0xD1 */ {"CMP", indexed_y,    2,         5,       one_page_cylce,      cmp},
-/* 0xD2 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0xD3 */ {"DCP", indexed_y,    0,         8,       zero_page_cycles,    dcp},
-/* 0xD4 */ {"NOP", zero_page_x,  2,         4,       zero_page_cycles,    nop},
-/* 0xD5 */ {"CMP", zero_page_x,  2,         4,       zero_page_cycles,    cmp},
-/* 0xD6 */ {"DEC", zero_page_x,  2,         6,       zero_page_cycles,    dec},
-/* 0xD7 */ {"DCP", zero_page_x,  0,         6,       zero_page_cycles,    dcp},
-/* 0xD8 */ {"CLD", implicit,     1,         2,       zero_page_cycles,    cld},
-/* 0xD9 */ {"CMP", absolute_y,   3,         4,       one_page_cylce,      cmp},
-/* 0xDA */ {"NOP", implicit,     1,         2,       zero_page_cycles,    nop},
-/* 0xDB */ {"DCP", absolute_y,   0,         7,       zero_page_cycles,    dcp},
-/* 0xDC */ {"NOP", absolute_x,   3,         4,       one_page_cylce,      nop},
-/* 0xDD */ {"CMP", absolute_x,   3,         4,       one_page_cylce,      cmp},
-/* 0xDE */ {"DEC", absolute_x,   3,         7,       zero_page_cycles,    dec},
-/* 0xDF */ {"DCP", absolute_x,   0,         7,       zero_page_cycles,    dcp},
-/* 0xE0 */ {"CPX", immediate,    2,         2,       zero_page_cycles,    cpx},
-/* 0xE1 */ {"SBC", indexed_x,    2,         6,       zero_page_cycles,    sbc},
-/* 0xE2 */ {"NOP", immediate,    0,         2,       zero_page_cycles,    nop},
-/* 0xE3 */ {"ISC", indexed_x,    0,         8,       zero_page_cycles,    isc},
-/* 0xE4 */ {"CPX", zero_page,    2,         3,       zero_page_cycles,    cpx},
-/* 0xE5 */ {"SBC", zero_page,    2,         3,       zero_page_cycles,    sbc},
-/* 0xE6 */ {"INC", zero_page,    2,         5,       zero_page_cycles,    inc},
-/* 0xE7 */ {"ISC", zero_page,    0,         5,       zero_page_cycles,    isc},
-/* 0xE8 */ {"INX", implicit,     1,         2,       zero_page_cycles,    inx},
-/* 0xE9 */ {"SBC", immediate,    2,         2,       zero_page_cycles,    sbc},
-/* 0xEA */ {"NOP", implicit,     1,         2,       zero_page_cycles,    nop},
-/* 0xEB */ {"SBC", immediate,    0,         2,       zero_page_cycles,    sbc},
-/* 0xEC */ {"CPX", absolute,     3,         4,       zero_page_cycles,    cpx},
-/* 0xED */ {"SBC", absolute,     3,         4,       zero_page_cycles,    sbc},
-/* 0xEE */ {"INC", absolute,     3,         6,       zero_page_cycles,    inc},
-/* 0xEF */ {"ISC", absolute,     0,         6,       zero_page_cycles,    isc},
-/* 0xF0 */ {"BEQ", relative,     2,         2,       one_page_cylce,      beq},
-/* 0xF1 */ {"SBC", indexed_y,    2,         5,       one_page_cylce,      sbc},
-/* 0xF2 */ {"KIL", implicit,     0,         2,       zero_page_cycles,    kil},
-/* 0xF3 */ {"ISC", indexed_y,    0,         8,       zero_page_cycles,    isc},
-/* 0xF4 */ {"NOP", zero_page_x,  2,         4,       zero_page_cycles,    nop},
-/* 0xF5 */ {"SBC", zero_page_x,  2,         4,       zero_page_cycles,    sbc},
-/* 0xF6 */ {"INC", zero_page_x,  2,         6,       zero_page_cycles,    inc},
-/* 0xF7 */ {"ISC", zero_page_x,  0,         6,       zero_page_cycles,    isc},
-/* 0xF8 */ {"SED", implicit,     1,         2,       zero_page_cycles,    sed},
-/* 0xF9 */ {"SBC", absolute_y,   3,         4,       one_page_cylce,      sbc},
-/* 0xFA */ {"NOP", implicit,     1,         2,       zero_page_cycles,    nop},
-/* 0xFB */ {"ISC", absolute_y,   0,         7,       zero_page_cycles,    isc},
-/* 0xFC */ {"NOP", absolute_x,   3,         4,       one_page_cylce,      nop},
-/* 0xFD */ {"SBC", absolute_x,   3,         4,       one_page_cylce,      sbc},
-/* 0xFE */ {"INC", absolute_x,   3,         7,       zero_page_cycles,    inc},
-/* 0xFF */ {"ISC", absolute_x,   0,         7,       zero_page_cycles,    isc}
-}};
+//
+// Every op code as (op code, name, handler, mode, number of bytes, number of
+// cycles, add cycle if page crossed). Both the instruction table and the
+// dispatch switch are built from this list, with each slot bound to the
+// handler specialized for its addressing mode.
+#define NES_EMULATOR_OPCODES(OP) \
+/*  code |  name | func | mode       |bytes|cycles| page crossed */ \
+    OP(0x00, "BRK", brk, implicit,    1,  7,  zero_page_cycles) \
+    OP(0x01, "ORA", ora, indexed_x,   2,  6,  zero_page_cycles) \
+    OP(0x02, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0x03, "SLO", slo, indexed_x,   0,  8,  zero_page_cycles) \
+    OP(0x04, "NOP", nop, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x05, "ORA", ora, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x06, "ASL", asl, zero_page,   2,  5,  zero_page_cycles) \
+    OP(0x07, "SLO", slo, zero_page,   0,  5,  zero_page_cycles) \
+    OP(0x08, "PHP", php, implicit,    1,  3,  zero_page_cycles) \
+    OP(0x09, "ORA", ora, immediate,   2,  2,  zero_page_cycles) \
+    OP(0x0A, "ASL", asl, accumulator, 1,  2,  zero_page_cycles) \
+    OP(0x0B, "ANC", anc, immediate,   0,  2,  zero_page_cycles) \
+    OP(0x0C, "NOP", nop, absolute,    3,  4,  zero_page_cycles) \
+    OP(0x0D, "ORA", ora, absolute,    3,  4,  zero_page_cycles) \
+    OP(0x0E, "ASL", asl, absolute,    3,  6,  zero_page_cycles) \
+    OP(0x0F, "SLO", slo, absolute,    0,  6,  zero_page_cycles) \
+    OP(0x10, "BPL", bpl, relative,    2,  2,  one_page_cylce) \
+    OP(0x11, "ORA", ora, indexed_y,   2,  5,  one_page_cylce) \
+    OP(0x12, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0x13, "SLO", slo, indexed_y,   0,  8,  zero_page_cycles) \
+    OP(0x14, "NOP", nop, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x15, "ORA", ora, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x16, "ASL", asl, zero_page_x, 2,  6,  zero_page_cycles) \
+    OP(0x17, "SLO", slo, zero_page_x, 0,  6,  zero_page_cycles) \
+    OP(0x18, "CLC", clc, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x19, "ORA", ora, absolute_y,  3,  4,  one_page_cylce) \
+    OP(0x1A, "NOP", nop, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x1B, "SLO", slo, absolute_y,  0,  7,  zero_page_cycles) \
+    OP(0x1C, "NOP", nop, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0x1D, "ORA", ora, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0x1E, "ASL", asl, absolute_x,  3,  7,  zero_page_cycles) \
+    OP(0x1F, "SLO", slo, absolute_x,  0,  7,  zero_page_cycles) \
+    OP(0x20, "JSR", jsr, absolute,    3,  6,  zero_page_cycles) \
+    OP(0x21, "AND", nd,  indexed_x,   2,  6,  zero_page_cycles) \
+    OP(0x22, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0x23, "RLA", rla, indexed_x,   0,  8,  zero_page_cycles) \
+    OP(0x24, "BIT", bit, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x25, "AND", nd,  zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x26, "ROL", rol, zero_page,   2,  5,  zero_page_cycles) \
+    OP(0x27, "RLA", rla, zero_page,   0,  5,  zero_page_cycles) \
+    OP(0x28, "PLP", plp, implicit,    1,  4,  zero_page_cycles) \
+    OP(0x29, "AND", nd,  immediate,   2,  2,  zero_page_cycles) \
+    OP(0x2A, "ROL", rol, accumulator, 1,  2,  zero_page_cycles) \
+    OP(0x2B, "ANC", anc, immediate,   0,  2,  zero_page_cycles) \
+    OP(0x2C, "BIT", bit, absolute,    3,  4,  zero_page_cycles) \
+    OP(0x2D, "AND", nd,  absolute,    3,  4,  zero_page_cycles) \
+    OP(0x2E, "ROL", rol, absolute,    3,  6,  zero_page_cycles) \
+    OP(0x2F, "RLA", rla, absolute,    0,  6,  zero_page_cycles) \
+    OP(0x30, "BMI", bmi, relative,    2,  2,  one_page_cylce) \
+    OP(0x31, "AND", nd,  indexed_y,   2,  5,  one_page_cylce) \
+    OP(0x32, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0x33, "RLA", rla, indexed_y,   0,  8,  zero_page_cycles) \
+    OP(0x34, "NOP", nop, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x35, "AND", nd,  zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x36, "ROL", rol, zero_page_x, 2,  6,  zero_page_cycles) \
+    OP(0x37, "RLA", rla, zero_page_x, 0,  6,  zero_page_cycles) \
+    OP(0x38, "SEC", sec, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x39, "AND", nd,  absolute_y,  3,  4,  one_page_cylce) \
+    OP(0x3A, "NOP", nop, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x3B, "RLA", rla, absolute_y,  0,  7,  zero_page_cycles) \
+    OP(0x3C, "NOP", nop, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0x3D, "AND", nd,  absolute_x,  3,  4,  one_page_cylce) \
+    OP(0x3E, "ROL", rol, absolute_x,  3,  7,  zero_page_cycles) \
+    OP(0x3F, "RLA", rla, absolute_x,  0,  7,  zero_page_cycles) \
+    OP(0x40, "RTI", rti, implicit,    1,  6,  zero_page_cycles) \
+    OP(0x41, "EOR", eor, indexed_x,   2,  6,  zero_page_cycles) \
+    OP(0x42, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0x43, "SRE", sre, indexed_x,   0,  8,  zero_page_cycles) \
+    OP(0x44, "NOP", nop, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x45, "EOR", nop, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x46, "LSR", lsr, zero_page,   2,  5,  zero_page_cycles) \
+    OP(0x47, "SRE", sre, zero_page,   0,  5,  zero_page_cycles) \
+    OP(0x48, "PHA", pha, implicit,    1,  3,  zero_page_cycles) \
+    OP(0x49, "EOR", eor, immediate,   2,  2,  zero_page_cycles) \
+    OP(0x4A, "LSR", lsr, accumulator, 1,  2,  zero_page_cycles) \
+    OP(0x4B, "ALR", alr, immediate,   0,  2,  zero_page_cycles) \
+    OP(0x4C, "JMP", jmp, absolute,    3,  3,  zero_page_cycles) \
+    OP(0x4D, "EOR", eor, absolute,    3,  4,  zero_page_cycles) \
+    OP(0x4E, "LSR", lsr, absolute,    3,  6,  zero_page_cycles) \
+    OP(0x4F, "SRE", sre, absolute,    0,  6,  zero_page_cycles) \
+    OP(0x50, "BVC", bvc, relative,    2,  2,  one_page_cylce) \
+    OP(0x51, "EOR", eor, indexed_y,   2,  5,  one_page_cylce) \
+    OP(0x52, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0x53, "SRE", sre, indexed_y,   0,  8,  zero_page_cycles) \
+    OP(0x54, "NOP", nop, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x55, "EOR", eor, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x56, "LSR", lsr, zero_page_x, 2,  6,  zero_page_cycles) \
+    OP(0x57, "SRE", sre, zero_page_x, 0,  6,  zero_page_cycles) \
+    OP(0x58, "CLI", cli, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x59, "EOR", eor, absolute_y,  3,  4,  one_page_cylce) \
+    OP(0x5A, "NOP", nop, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x5B, "SRE", sre, absolute_y,  0,  7,  zero_page_cycles) \
+    OP(0x5C, "NOP", nop, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0x5D, "EOR", eor, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0x5E, "LSR", lsr, absolute_x,  3,  7,  zero_page_cycles) \
+    OP(0x5F, "SRE", sre, absolute_x,  0,  7,  zero_page_cycles) \
+    OP(0x60, "RTS", rts, implicit,    1,  6,  zero_page_cycles) \
+    OP(0x61, "ADC", adc, indexed_x,   2,  6,  zero_page_cycles) \
+    OP(0x62, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0x63, "RRA", rra, indexed_x,   0,  8,  zero_page_cycles) \
+    OP(0x64, "NOP", nop, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x65, "ADC", adc, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x66, "ROR", ror, zero_page,   2,  5,  zero_page_cycles) \
+    OP(0x67, "RRA", rra, zero_page,   0,  5,  zero_page_cycles) \
+    OP(0x68, "PLA", pla, implicit,    1,  4,  zero_page_cycles) \
+    OP(0x69, "ADC", adc, immediate,   2,  2,  zero_page_cycles) \
+    OP(0x6A, "ROR", ror, accumulator, 1,  2,  zero_page_cycles) \
+    OP(0x6B, "ARR", arr, immediate,   0,  2,  zero_page_cycles) \
+    OP(0x6C, "JMP", jmp, indirect,    3,  5,  zero_page_cycles) \
+    OP(0x6D, "ADC", adc, absolute,    3,  4,  zero_page_cycles) \
+    OP(0x6E, "ROR", ror, absolute,    3,  6,  zero_page_cycles) \
+    OP(0x6F, "RRA", rra, absolute,    0,  6,  zero_page_cycles) \
+    OP(0x70, "BVS", bvs, relative,    2,  2,  one_page_cylce) \
+    OP(0x71, "ADC", adc, indexed_y,   2,  5,  one_page_cylce) \
+    OP(0x72, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0x73, "RRA", rra, indexed_y,   0,  8,  zero_page_cycles) \
+    OP(0x74, "NOP", nop, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x75, "ADC", adc, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x76, "ROR", ror, zero_page_x, 2,  6,  zero_page_cycles) \
+    OP(0x77, "RRA", rra, zero_page_x, 0,  6,  zero_page_cycles) \
+    OP(0x78, "SEI", sei, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x79, "ADC", adc, absolute_y,  3,  4,  one_page_cylce) \
+    OP(0x7A, "NOP", nop, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x7B, "RRA", rra, absolute_y,  0,  7,  zero_page_cycles) \
+    OP(0x7C, "NOP", nop, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0x7D, "ADC", adc, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0x7E, "ROR", ror, absolute_x,  3,  7,  zero_page_cycles) \
+    OP(0x7F, "RRA", rra, absolute_x,  0,  7,  zero_page_cycles) \
+    OP(0x80, "NOP", nop, immediate,   2,  2,  zero_page_cycles) \
+    OP(0x81, "STA", sta, indexed_x,   2,  6,  zero_page_cycles) \
+    OP(0x82, "NOP", nop, immediate,   0,  2,  zero_page_cycles) \
+    OP(0x83, "SAX", sax, indexed_x,   0,  6,  zero_page_cycles) \
+    OP(0x84, "STY", sty, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x85, "STA", sta, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x86, "STX", stx, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0x87, "SAX", sax, zero_page,   0,  3,  zero_page_cycles) \
+    OP(0x88, "DEY", dey, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x89, "NOP", nop, immediate,   0,  2,  zero_page_cycles) \
+    OP(0x8A, "TXA", txa, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x8B, "XAA", xaa, immediate,   0,  2,  zero_page_cycles) \
+    OP(0x8C, "STY", sty, absolute,    3,  4,  zero_page_cycles) \
+    OP(0x8D, "STA", sta, absolute,    3,  4,  zero_page_cycles) \
+    OP(0x8E, "STX", stx, absolute,    3,  4,  zero_page_cycles) \
+    OP(0x8F, "SAX", sax, absolute,    0,  4,  zero_page_cycles) \
+    OP(0x90, "BCC", bcc, relative,    2,  2,  one_page_cylce) \
+    OP(0x91, "STA", sta, indexed_y,   2,  6,  zero_page_cycles) \
+    OP(0x92, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0x93, "AHX", ahx, indexed_y,   0,  6,  zero_page_cycles) \
+    OP(0x94, "STY", sty, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x95, "STA", sta, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0x96, "STX", stx, zero_page_y, 2,  4,  zero_page_cycles) \
+    OP(0x97, "SAX", sax, zero_page_y, 0,  4,  zero_page_cycles) \
+    OP(0x98, "TYA", tya, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x99, "STA", sta, absolute_y,  3,  5,  zero_page_cycles) \
+    OP(0x9A, "TXS", txs, implicit,    1,  2,  zero_page_cycles) \
+    OP(0x9B, "TAS", tas, absolute_y,  0,  5,  zero_page_cycles) \
+    OP(0x9C, "SHY", shy, absolute_x,  0,  5,  zero_page_cycles) \
+    OP(0x9D, "STA", sta, absolute_x,  3,  5,  zero_page_cycles) \
+    OP(0x9E, "SHX", shx, zero_page_x, 0,  5,  zero_page_cycles) \
+    OP(0x9F, "AHX", ahx, zero_page_x, 0,  5,  zero_page_cycles) \
+    OP(0xA0, "LDY", ldy, immediate,   2,  2,  zero_page_cycles) \
+    OP(0xA1, "LDA", lda, indexed_x,   2,  6,  zero_page_cycles) \
+    OP(0xA2, "LDX", ldx, immediate,   2,  2,  zero_page_cycles) \
+    OP(0xA3, "LAX", lax, indexed_x,   0,  6,  zero_page_cycles) \
+    OP(0xA4, "LDY", ldy, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0xA5, "LDA", lda, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0xA6, "LDX", ldx, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0xA7, "LAX", lax, zero_page,   0,  3,  zero_page_cycles) \
+    OP(0xA8, "TAY", tay, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xA9, "LDA", lda, immediate,   2,  2,  zero_page_cycles) \
+    OP(0xAA, "TAX", tax, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xAB, "LAX", lax, immediate,   0,  2,  zero_page_cycles) \
+    OP(0xAC, "LDY", ldy, absolute,    3,  4,  zero_page_cycles) \
+    OP(0xAD, "LDA", lda, absolute,    3,  4,  zero_page_cycles) \
+    OP(0xAE, "LDX", ldx, absolute,    3,  4,  zero_page_cycles) \
+    OP(0xAF, "LAX", lax, absolute,    0,  4,  zero_page_cycles) \
+    OP(0xB0, "BCS", bcs, relative,    2,  2,  one_page_cylce) \
+    OP(0xB1, "LDA", lda, indexed_y,   2,  5,  one_page_cylce) \
+    OP(0xB2, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0xB3, "LAX", lax, indexed_y,   0,  5,  one_page_cylce) \
+    OP(0xB4, "LDY", ldy, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0xB5, "LDA", lda, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0xB6, "LDX", ldx, zero_page_y, 2,  4,  zero_page_cycles) \
+    OP(0xB7, "LAX", lax, zero_page_y, 0,  4,  zero_page_cycles) \
+    OP(0xB8, "CLV", clv, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xB9, "LDA", lda, absolute_y,  3,  4,  one_page_cylce) \
+    OP(0xBA, "TSX", tsx, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xBB, "LAS", las, absolute_y,  0,  4,  one_page_cylce) \
+    OP(0xBC, "LDY", ldy, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0xBD, "LDA", lda, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0xBE, "LDX", ldx, zero_page_x, 3,  4,  one_page_cylce) \
+    OP(0xBF, "LAX", lax, zero_page_x, 0,  4,  one_page_cylce) \
+    OP(0xC0, "CPY", cpy, immediate,   2,  2,  zero_page_cycles) \
+    OP(0xC1, "CMP", cmp, indexed_x,   2,  6,  zero_page_cycles) \
+    OP(0xC2, "NOP", nop, immediate,   0,  2,  zero_page_cycles) \
+    OP(0xC3, "DCP", dcp, indexed_x,   0,  8,  zero_page_cycles) \
+    OP(0xC4, "CPY", cpy, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0xC5, "CMP", cmp, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0xC6, "DEC", dec, zero_page,   2,  5,  zero_page_cycles) \
+    OP(0xC7, "DCP", dcp, zero_page,   0,  5,  zero_page_cycles) \
+    OP(0xC8, "INY", iny, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xC9, "CMP", cmp, immediate,   2,  2,  zero_page_cycles) \
+    OP(0xCA, "DEX", dex, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xCB, "AXS", axs, immediate,   0,  2,  zero_page_cycles) \
+    OP(0xCC, "CPY", cpy, absolute,    3,  4,  zero_page_cycles) \
+    OP(0xCD, "CMP", cmp, absolute,    3,  4,  zero_page_cycles) \
+    OP(0xCE, "DEC", dec, absolute,    3,  6,  zero_page_cycles) \
+    OP(0xCF, "DCP", dcp, absolute,    0,  6,  zero_page_cycles) \
+    OP(0xD0, "BNE", bne, relative,    2,  2,  one_page_cylce) \
+    OP(0xD1, "CMP", cmp, indexed_y,   2,  5,  one_page_cylce) \
+    OP(0xD2, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0xD3, "DCP", dcp, indexed_y,   0,  8,  zero_page_cycles) \
+    OP(0xD4, "NOP", nop, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0xD5, "CMP", cmp, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0xD6, "DEC", dec, zero_page_x, 2,  6,  zero_page_cycles) \
+    OP(0xD7, "DCP", dcp, zero_page_x, 0,  6,  zero_page_cycles) \
+    OP(0xD8, "CLD", cld, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xD9, "CMP", cmp, absolute_y,  3,  4,  one_page_cylce) \
+    OP(0xDA, "NOP", nop, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xDB, "DCP", dcp, absolute_y,  0,  7,  zero_page_cycles) \
+    OP(0xDC, "NOP", nop, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0xDD, "CMP", cmp, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0xDE, "DEC", dec, absolute_x,  3,  7,  zero_page_cycles) \
+    OP(0xDF, "DCP", dcp, absolute_x,  0,  7,  zero_page_cycles) \
+    OP(0xE0, "CPX", cpx, immediate,   2,  2,  zero_page_cycles) \
+    OP(0xE1, "SBC", sbc, indexed_x,   2,  6,  zero_page_cycles) \
+    OP(0xE2, "NOP", nop, immediate,   0,  2,  zero_page_cycles) \
+    OP(0xE3, "ISC", isc, indexed_x,   0,  8,  zero_page_cycles) \
+    OP(0xE4, "CPX", cpx, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0xE5, "SBC", sbc, zero_page,   2,  3,  zero_page_cycles) \
+    OP(0xE6, "INC", inc, zero_page,   2,  5,  zero_page_cycles) \
+    OP(0xE7, "ISC", isc, zero_page,   0,  5,  zero_page_cycles) \
+    OP(0xE8, "INX", inx, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xE9, "SBC", sbc, immediate,   2,  2,  zero_page_cycles) \
+    OP(0xEA, "NOP", nop, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xEB, "SBC", sbc, immediate,   0,  2,  zero_page_cycles) \
+    OP(0xEC, "CPX", cpx, absolute,    3,  4,  zero_page_cycles) \
+    OP(0xED, "SBC", sbc, absolute,    3,  4,  zero_page_cycles) \
+    OP(0xEE, "INC", inc, absolute,    3,  6,  zero_page_cycles) \
+    OP(0xEF, "ISC", isc, absolute,    0,  6,  zero_page_cycles) \
+    OP(0xF0, "BEQ", beq, relative,    2,  2,  one_page_cylce) \
+    OP(0xF1, "SBC", sbc, indexed_y,   2,  5,  one_page_cylce) \
+    OP(0xF2, "KIL", kil, implicit,    0,  2,  zero_page_cycles) \
+    OP(0xF3, "ISC", isc, indexed_y,   0,  8,  zero_page_cycles) \
+    OP(0xF4, "NOP", nop, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0xF5, "SBC", sbc, zero_page_x, 2,  4,  zero_page_cycles) \
+    OP(0xF6, "INC", inc, zero_page_x, 2,  6,  zero_page_cycles) \
+    OP(0xF7, "ISC", isc, zero_page_x, 0,  6,  zero_page_cycles) \
+    OP(0xF8, "SED", sed, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xF9, "SBC", sbc, absolute_y,  3,  4,  one_page_cylce) \
+    OP(0xFA, "NOP", nop, implicit,    1,  2,  zero_page_cycles) \
+    OP(0xFB, "ISC", isc, absolute_y,  0,  7,  zero_page_cycles) \
+    OP(0xFC, "NOP", nop, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0xFD, "SBC", sbc, absolute_x,  3,  4,  one_page_cylce) \
+    OP(0xFE, "INC", inc, absolute_x,  3,  7,  zero_page_cycles) \
+    OP(0xFF, "ISC", isc, absolute_x,  0,  7,  zero_page_cycles)
+
+extern std::array<OpInfo, 256> const instruction;
+
+// The handler each op code is bound to, specialized for its addressing mode.
+// The operand has to be decoded into the CPU before calling one.
+extern std::array<void (*)(CPU* cpu), 256> const specialized_handler;
 
 }
 
@@ -0,0 +1,818 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Op code handlers specialized on their addressing mode. Each slot in the
+instruction table is bound to handler<mode>, so the operand fetch is
+resolved at compile time rather than switching on OpMode per instruction.
+
+*/
+
+#ifndef NES_EMULATOR_CPU_OPERATIONS_H_
+#define NES_EMULATOR_CPU_OPERATIONS_H_
+
+#include "cpu.h"
+#include "cpu_instructions.h"
+
+namespace emulator
+{
+namespace ops
+{
+inline void update_zero(CPU* cpu, uint8_t value)
+{
+    if (cpu->lazy_flags())
+    {
+        cpu->set_zero_result(value);
+        return;
+    }
+
+    cpu->update_flags([value] { return value == 0; }, zero);
+}
+
+inline void update_sign(CPU* cpu, uint8_t value)
+{
+    if (cpu->lazy_flags())
+    {
+        cpu->set_sign_result(value);
+        return;
+    }
+
+    cpu->update_flags([value] { return value & 0x80; }, sign);
+}
+
+inline void update_zero_sign(CPU* cpu, uint8_t value)
+{
+    update_zero(cpu, value);
+    update_sign(cpu, value);
+}
+
+inline void update_overflow(CPU* cpu, uint8_t acc, uint8_t mem, uint8_t new_value)
+{
+    if (cpu->lazy_flags())
+    {
+        cpu->set_overflow_result(acc, mem, new_value);
+        return;
+    }
+
+    cpu->update_flags([acc, mem, new_value] {
+        return !((acc ^ mem) & 0x80) && ((acc ^ new_value) & 0x80);
+    }, overflow);
+}
+
+inline void update_overflow_if(CPU* cpu, bool set)
+{
+    if (cpu->lazy_flags())
+    {
+        // acc and mem agree on the sign so only the result decides V
+        cpu->set_overflow_result(0, 0, set ? 0x80 : 0);
+        return;
+    }
+
+    cpu->update_flags([set] { return set; }, overflow);
+}
+
+inline void update_carry_if(CPU* cpu, bool set)
+{
+    if (cpu->lazy_flags())
+    {
+        cpu->set_carry_result(set);
+        return;
+    }
+
+    cpu->update_flags([set] { return set; }, carry);
+}
+
+inline void update_carry(CPU* cpu, uint32_t value)
+{
+    update_carry_if(cpu, value > 0xFF);
+}
+
+template <OpMode Mode>
+void branch_if_cond(bool cond, CPU* cpu)
+{
+    if (cond)
+    {
+        auto address = cpu->address_to_arguemnts<Mode>();
+        cpu->set_program_counter(address);
+        cpu->add_branch_cycle(address);
+    }
+}
+
+// ADC Add Memory to Accumulator with Carry
+template <OpMode Mode>
+void adc(CPU* cpu)
+{
+    auto a            = cpu->accumulator();
+    auto mem          = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    uint8_t c         = cpu->carry();
+    uint8_t new_value = a + mem + c;
+
+    update_zero(cpu, new_value);
+
+    if (cpu->decimal())
+    {
+        // TODO BCD
+    }
+    else
+    {
+        update_sign(cpu, new_value);
+        update_overflow(cpu, a, mem, new_value);
+
+        auto as_int32 =
+            static_cast<int>(a) +
+            static_cast<int>(mem) +
+            static_cast<int>(c);
+
+        update_carry(cpu, as_int32);
+    }
+
+    cpu->set_accumulator(new_value);
+}
+
+// AND "AND" Memory with Accumulator
+template <OpMode Mode>
+void nd(CPU* cpu)
+{
+    auto a         = cpu->accumulator();
+    auto mem       = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    auto new_value = a & mem;
+    cpu->set_accumulator(new_value);
+
+    update_zero_sign(cpu, new_value);
+}
+
+// ASL Shift Left One Bit (Memory or Accumulator)
+template <OpMode Mode>
+void asl(CPU* cpu)
+{
+    uint16_t new_value = 0;
+
+    if constexpr (Mode == accumulator)
+    {
+        new_value = cpu->accumulator() << 1;
+        cpu->set_accumulator(new_value);
+    }
+    else
+    {
+        auto address = cpu->address_to_arguemnts<Mode>();
+        new_value    = cpu->read8(address) << 1;
+        cpu->write8(address, new_value);
+    }
+
+    update_zero_sign(cpu, new_value);
+}
+
+// BCC Branch on Carry Clear
+template <OpMode Mode>
+void bcc(CPU* cpu)
+{
+    branch_if_cond<Mode>((cpu->carry()) == 0, cpu);
+}
+
+// BCS Branch on Carry Set
+template <OpMode Mode>
+void bcs(CPU* cpu)
+{
+    branch_if_cond<Mode>(cpu->carry(), cpu);
+}
+
+// BEQ Branch on Result Zero
+template <OpMode Mode>
+void beq(CPU* cpu)
+{
+    branch_if_cond<Mode>(cpu->zero(), cpu);
+}
+
+// BIT Test Bits in Memory with Accumulator
+template <OpMode Mode>
+void bit(CPU* cpu)
+{
+    auto address = cpu->address_to_arguemnts<Mode>();
+    auto mem     = cpu->read8(address);
+
+    update_overflow_if(cpu, (mem >> 6) & 1);
+
+    update_zero(cpu, mem & cpu->accumulator());
+    update_sign(cpu, mem);
+}
+
+// BMI Branch on Result Minus
+template <OpMode Mode>
+void bmi(CPU* cpu)
+{
+    branch_if_cond<Mode>(cpu->sign(), cpu);
+}
+
+// BNE Branch on Result not Zero
+template <OpMode Mode>
+void bne(CPU* cpu)
+{
+    branch_if_cond<Mode>((cpu->zero()) == 0, cpu);
+
+}
+
+// BPL Branch on Result Plus
+template <OpMode Mode>
+void bpl(CPU* cpu)
+{
+    branch_if_cond<Mode>((cpu->sign()) == 0, cpu);
+}
+
+// BRK Force Break
+template <OpMode Mode>
+void brk(CPU* cpu)
+{
+    auto pc = cpu->program_counter() + 2;
+    cpu->push(pc >> 8 & 0xFF);
+    cpu->push(pc & 0xFF);
+    cpu->add_flags(brk_inter);
+    cpu->push(cpu->status());
+    cpu->add_flags(interrupt);
+    cpu->set_program_counter(cpu->read8(0xFFFE) | cpu->read8(0xFFFF) << 8);
+}
+
+// BVC Branch on Overflow Clear
+template <OpMode Mode>
+void bvc(CPU* cpu)
+{
+    branch_if_cond<Mode>((cpu->overflow()) == 0, cpu);
+}
+
+// BVS Branch on Overflow Set
+template <OpMode Mode>
+void bvs(CPU* cpu)
+{
+    branch_if_cond<Mode>(cpu->overflow(), cpu);
+}
+
+// CLC Clear Carry Flag
+template <OpMode Mode>
+void clc(CPU* cpu)
+{
+    cpu->remove_flags(carry);
+}
+
+// CLD Clear Decimal Mode
+template <OpMode Mode>
+void cld(CPU* cpu)
+{
+    cpu->remove_flags(decimal);
+}
+
+// CLI Clear interrupt Disable Bit
+template <OpMode Mode>
+void cli(CPU* cpu)
+{
+    cpu->remove_flags(interrupt);
+}
+
+// CLV Clear Overflow Flag
+template <OpMode Mode>
+void clv(CPU* cpu)
+{
+    cpu->remove_flags(overflow);
+}
+
+// CMP Compare Memory and Accumulator
+template <OpMode Mode>
+void cmp(CPU* cpu)
+{
+    auto mem = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    mem      = cpu->accumulator() - mem;
+    update_carry(cpu, mem);
+    update_zero_sign(cpu, mem);
+}
+
+// CPX Compare Memory and Index X
+template <OpMode Mode>
+void cpx(CPU* cpu)
+{
+    auto mem = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    mem      = cpu->x_register() - mem;
+    update_carry(cpu, mem);
+    update_zero_sign(cpu, mem);
+}
+
+// CPY Compare Memory and Index Y
+template <OpMode Mode>
+void cpy(CPU* cpu)
+{
+    auto mem = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    mem      = cpu->y_register() - mem;
+    update_carry(cpu, mem);
+    update_zero_sign(cpu, mem);
+}
+
+// DEC Decrement Memory by One
+template <OpMode Mode>
+void dec(CPU* cpu)
+{
+    auto address = cpu->address_to_arguemnts<Mode>();
+    auto mem     = cpu->read8(address);
+    mem = (mem - 1) & 0xFF;
+    update_zero_sign(cpu, mem);
+    cpu->write8(address, mem);
+}
+
+// DEX Decrement Index X by One
+template <OpMode Mode>
+void dex(CPU* cpu)
+{
+    auto x = cpu->x_register();
+    cpu->set_x_register(x - 1);
+    update_zero_sign(cpu, x);
+}
+
+// DEY Decrement Index Y by One
+template <OpMode Mode>
+void dey(CPU* cpu)
+{
+    auto y = cpu->y_register();
+    cpu->set_y_register(y - 1);
+    update_zero_sign(cpu, y);
+}
+
+// EOR "Exclusive-Or" Memory with Accumulator
+template <OpMode Mode>
+void eor(CPU* cpu)
+{
+    auto address = cpu->address_to_arguemnts<Mode>();
+    auto mem     = cpu->read8(address);
+    cpu->set_accumulator(mem ^ cpu->accumulator());
+}
+
+// INC Increment Memory by One
+template <OpMode Mode>
+void inc(CPU* cpu)
+{
+    auto address = cpu->address_to_arguemnts<Mode>();
+    auto mem     = cpu->read8(address);
+    cpu->write8(address, (mem + 1) & 0xFF);
+    update_zero_sign(cpu, mem);
+}
+
+// INX Increment Index X by One
+template <OpMode Mode>
+void inx(CPU* cpu)
+{
+    auto x = cpu->x_register();
+    cpu->set_x_register((x + 1) & 0xFF);
+    update_zero_sign(cpu, x);
+}
+
+// INY Increment Index Y by One
+template <OpMode Mode>
+void iny(CPU* cpu)
+{
+    auto y = cpu->y_register();
+    cpu->set_y_register((y + 1) & 0xFF);
+    update_zero_sign(cpu, y);
+}
+
+// JMP Jump to New Location
+template <OpMode Mode>
+void jmp(CPU* cpu)
+{
+    auto address = cpu->address_to_arguemnts<Mode>();
+    cpu->set_program_counter(address);
+}
+
+// JSR Jump to New Location Saving Return Address
+template <OpMode Mode>
+void jsr(CPU* cpu)
+{
+    // Since JSR + args is 3 bytes, and we want to move to next op - 1
+    auto pc = cpu->program_counter() + 2;
+    cpu->push(pc >> 8 & 0xFF);
+    cpu->push(pc & 0xFF);
+    auto address = cpu->address_to_arguemnts<Mode>();
+    cpu->set_program_counter(address);
+}
+
+// LDA Load Accumulator with Memory
+template <OpMode Mode>
+void lda(CPU* cpu)
+{
+    auto mem = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    cpu->set_accumulator(mem);
+    update_zero_sign(cpu, mem);
+}
+
+// LDX Load Index X with Memory
+template <OpMode Mode>
+void ldx(CPU* cpu)
+{
+    auto mem = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    cpu->set_x_register(mem);
+    update_zero_sign(cpu, mem);
+}
+
+// LDY Load Index Y with Memory
+template <OpMode Mode>
+void ldy(CPU* cpu)
+{
+    auto mem = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    cpu->set_y_register(mem);
+    update_zero_sign(cpu, mem);
+}
+
+// LSR Shift Right One Bit (Memory or Accumulator)
+template <OpMode Mode>
+void lsr(CPU* cpu)
+{
+    // 16 incase we have a carry
+    uint16_t new_value = 0;
+
+    if constexpr (Mode == accumulator)
+    {
+        new_value = cpu->accumulator() >> 1;
+        cpu->set_accumulator(new_value);
+    }
+    else
+    {
+        auto address = cpu->address_to_arguemnts<Mode>();
+        new_value    = cpu->read8(address) >> 1;
+        cpu->write8(address, new_value);
+    }
+
+    update_zero_sign(cpu, new_value);
+}
+
+// NOP No Operation
+template <OpMode Mode>
+void nop(CPU* cpu)
+{
+}
+
+// ORA "OR" Memory with Accumulator
+template <OpMode Mode>
+void ora(CPU* cpu)
+{
+    auto mem = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    cpu->set_accumulator(mem | cpu->accumulator());
+    update_zero_sign(cpu, mem);
+}
+
+// PHA Push Accumulator on Stack
+template <OpMode Mode>
+void pha(CPU* cpu)
+{
+    cpu->push(cpu->accumulator());
+}
+
+// PHP Push Processor Status on Stack
+template <OpMode Mode>
+void php(CPU* cpu)
+{
+    cpu->push(cpu->status());
+}
+
+// PLA Pull Accumulator from Stack
+template <OpMode Mode>
+void pla(CPU* cpu)
+{
+    cpu->set_accumulator(cpu->pop());
+    update_zero_sign(cpu, cpu->accumulator());
+}
+
+// PLP Pull Processor Status from Stack
+template <OpMode Mode>
+void plp(CPU* cpu)
+{
+    cpu->set_status(cpu->pop());
+}
+
+// ROL Rotate One Bit Left (Memory or Accumulator)
+template <OpMode Mode>
+void rol(CPU* cpu)
+{
+    uint16_t new_value = 0;
+
+    if constexpr (Mode == accumulator)
+    {
+        new_value = cpu->accumulator() << 1;
+        if (cpu->carry())
+        {
+            new_value |= 0x1;
+        }
+
+        cpu->set_accumulator(new_value);
+    }
+    else
+    {
+        auto address = cpu->address_to_arguemnts<Mode>();
+        new_value = cpu->read8(address) << 1;
+        if (cpu->carry())
+        {
+            new_value |= 0x1;
+        }
+
+        cpu->write8(address, new_value);
+    }
+
+    update_carry(cpu, new_value);
+    update_zero_sign(cpu, new_value);
+}
+
+// ROR Rotate One Bit Right (Memory or Accumulator)
+template <OpMode Mode>
+void ror(CPU* cpu)
+{
+    uint16_t new_value = 0;
+
+    if constexpr (Mode == accumulator)
+    {
+        new_value = cpu->accumulator();
+        if (cpu->carry())
+        {
+            new_value |= 0x100;
+        }
+
+        // If we are about to shift the least bit we will need to carry
+        update_carry_if(cpu, new_value & 0x1);
+
+        new_value >>= 1;
+
+        cpu->set_accumulator(new_value);
+    }
+    else
+    {
+        auto address = cpu->address_to_arguemnts<Mode>();
+        new_value    = cpu->read8(address);
+        if (cpu->carry())
+        {
+            new_value |= 0x100;
+        }
+
+        // If we are about to shift the least bit we will need to carry
+        update_carry_if(cpu, new_value & 0x1);
+
+        new_value >>= 1;
+
+        cpu->write8(address, new_value);
+    }
+
+    update_zero_sign(cpu, new_value);
+}
+
+// RTI Return from Interrupt
+template <OpMode Mode>
+void rti(CPU* cpu)
+{
+    cpu->set_status(cpu->pop());
+    auto new_pc = cpu->pop();
+    new_pc |= cpu->pop() << 8;
+    cpu->set_program_counter(new_pc);
+}
+
+// RTS Return from Subroutine
+template <OpMode Mode>
+void rts(CPU* cpu)
+{
+    uint16_t new_pc = cpu->pop();
+    new_pc += (cpu->pop() << 8) + 1;
+    cpu->set_program_counter(new_pc);
+}
+
+// SBC Subtract Memory from Accumulator with Borrow
+template <OpMode Mode>
+void sbc(CPU* cpu)
+{
+    auto a             = cpu->accumulator();
+    auto mem           = cpu->read8(cpu->address_to_arguemnts<Mode>());
+    auto carry         = cpu->carry();
+    uint16_t new_value = a - mem - carry;
+
+    update_zero_sign(cpu, new_value);
+    update_overflow(cpu, a, mem, new_value);
+    if (cpu->decimal())
+    {
+        // TODO BCD
+    }
+
+    update_carry_if(cpu, new_value > 0x100);
+    cpu->set_accumulator(new_value & 0xFF);
+}
+
+// SEC Set Carry Flag
+template <OpMode Mode>
+void sec(CPU* cpu)
+{
+    cpu->add_flags(carry);
+}
+
+// SED Set Decimal Mode
+template <OpMode Mode>
+void sed(CPU* cpu)
+{
+    cpu->add_flags(decimal);
+}
+
+// SEI Set Interrupt Disable Status
+template <OpMode Mode>
+void sei(CPU* cpu)
+{
+    cpu->add_flags(interrupt);
+}
+
+// STA Store Accumulator in Memory
+template <OpMode Mode>
+void sta(CPU* cpu)
+{
+    auto address = cpu->address_to_arguemnts<Mode>();
+    cpu->write8(address, cpu->accumulator());
+}
+
+// STX Store Index X in Memory
+template <OpMode Mode>
+void stx(CPU* cpu)
+{
+    auto address = cpu->address_to_arguemnts<Mode>();
+    cpu->write8(address, cpu->x_register());
+}
+
+// STY Store Index Y in Memory
+template <OpMode Mode>
+void sty(CPU* cpu)
+{
+    auto address = cpu->address_to_arguemnts<Mode>();
+    cpu->write8(address, cpu->y_register());
+}
+
+// TAX Transfer Accumulator to Index X
+template <OpMode Mode>
+void tax(CPU* cpu)
+{
+    auto a = cpu->accumulator();
+    cpu->set_x_register(a);
+    update_zero_sign(cpu, a);
+}
+
+// TAY Transfer Accumulator to Index Y
+template <OpMode Mode>
+void tay(CPU* cpu)
+{
+    auto a = cpu->accumulator();
+    cpu->set_y_register(a);
+    update_zero_sign(cpu, a);
+}
+
+// TSX Transfer Stack Pointer to Index X
+template <OpMode Mode>
+void tsx(CPU* cpu)
+{
+    auto s = cpu->stack();
+    cpu->set_x_register(s);
+    update_zero_sign(cpu, s);
+}
+
+// TXA Transfer Index X to Accumulator
+template <OpMode Mode>
+void txa(CPU* cpu)
+{
+    auto x = cpu->x_register();
+    cpu->set_accumulator(x);
+    update_zero_sign(cpu, x);
+}
+
+// TXS Transfer Index X to Stack Pointer
+template <OpMode Mode>
+void txs(CPU* cpu)
+{
+    auto x = cpu->x_register();
+    cpu->set_stack(x);
+    update_zero_sign(cpu, x);
+}
+
+// TYA Transfer Index Y to Accumulator
+template <OpMode Mode>
+void tya(CPU* cpu)
+{
+    auto y = cpu->y_register();
+    cpu->set_accumulator(y);
+    update_zero_sign(cpu, y);
+}
+
+// Unoffical opcodes
+template <OpMode Mode>
+void ahx(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void alr(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void anc(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void arr(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void axs(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void dcp(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void isc(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void kil(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void las(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void lax(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void rla(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void rra(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void sax(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void shx(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void shy(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void slo(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void sre(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void tas(CPU* /*cpu*/)
+{
+}
+
+template <OpMode Mode>
+void xaa(CPU* /*cpu*/)
+{
+}
+
+}
+}
+
+#endif /* NES_EMULATOR_CPU_OPERATIONS_H_ */
@@ -0,0 +1,132 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "io_registers.h"
+
+namespace
+{
+uint16_t const io_start{0x4000};
+uint16_t const io_end{0x4020};
+
+uint16_t const apu_channels_end{0x4014};
+uint16_t const oam_dma{0x4014};
+uint16_t const apu_status{0x4015};
+uint16_t const controller_one{0x4016};
+uint16_t const controller_two{0x4017};
+uint8_t const controller_open_bus{0x40};
+uint16_t const apu_frame_counter{0x4017};
+}
+
+void emulator::IORegisters::set_oam_dma_handler(std::function<void(uint8_t page)> const& handler)
+{
+    oam_dma_handler = handler;
+}
+
+void emulator::IORegisters::set_apu(APU* apu)
+{
+    this->apu = apu;
+}
+
+void emulator::IORegisters::set_controller(uint8_t port, Controller* controller)
+{
+    controllers[port] = controller;
+}
+
+uint8_t emulator::IORegisters::read(uint16_t address)
+{
+    if (address >= io_end)
+    {
+        return 0;
+    }
+
+    if (address == apu_status && apu)
+    {
+        return apu->read_status();
+    }
+
+    if (address == controller_one || address == controller_two)
+    {
+        auto* controller = controllers[address - controller_one];
+        return controller_open_bus | (controller ? controller->read() : 0);
+    }
+
+    return registers[address - io_start];
+}
+
+void emulator::IORegisters::write(uint16_t address, uint8_t value)
+{
+    if (address >= io_end)
+    {
+        return;
+    }
+
+    registers[address - io_start] = value;
+
+    if (address == oam_dma && oam_dma_handler)
+    {
+        oam_dma_handler(value);
+    }
+    else if (address == controller_one)
+    {
+        // Both ports share the strobe line
+        for (auto* controller : controllers)
+        {
+            if (controller)
+            {
+                controller->write_strobe(value);
+            }
+        }
+    }
+    else if (apu && (address < apu_channels_end || address == apu_status || address == apu_frame_counter))
+    {
+        apu->write_register(address, value);
+    }
+}
+
+void emulator::IORegisters::save(SaveState& state) const
+{
+    state.write(registers);
+
+    for (auto* controller : controllers)
+    {
+        if (controller)
+        {
+            controller->save(state);
+        }
+    }
+}
+
+void emulator::IORegisters::load(SaveState& state)
+{
+    state.read(registers);
+
+    for (auto* controller : controllers)
+    {
+        if (controller)
+        {
+            controller->load(state);
+        }
+    }
+}
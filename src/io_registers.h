@@ -0,0 +1,92 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+APU and I/O registers, 0x4000 - 0x401F.
+
+Sits on the bus over the 0x4000 page, so writes with side effects can be
+handed off. Registers without a handler read back what was written to them,
+the rest of the page is cartridge expansion space and is open bus.
+
+    Address           Name    Handled
+    ------------------------------------
+    0x4000 - 0x4013 : APU    : Channel registers, write only
+    0x4014          : OAMDMA : OAM DMA from the page written
+    0x4015          : APU    : Channel enables and status
+    0x4016          : Input  : Controller strobe on write, controller 1 on read
+    0x4017          : APU    : Frame counter on write, controller 2 on read
+
+Controller reads only drive bit 0, the upper bits are open bus which is
+usually 0x40 from the address.
+
+*/
+
+#ifndef NES_EMULATOR_IO_REGISTERS_H_
+#define NES_EMULATOR_IO_REGISTERS_H_
+
+#include "apu.h"
+#include "bus.h"
+#include "controller.h"
+#include "save_state.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+namespace emulator
+{
+
+class IORegisters : public BusDevice
+{
+public:
+    void set_oam_dma_handler(std::function<void(uint8_t page)> const& handler);
+
+    // Until one is set APU registers just hold what was written
+    void set_apu(APU* apu);
+
+    // Port 0 or 1, reads of an empty port are open bus
+    void set_controller(uint8_t port, Controller* controller);
+
+    uint8_t read(uint16_t address) override;
+    void write(uint16_t address, uint8_t value) override;
+
+    // The registers and the controllers plugged in
+    void save(SaveState& state) const;
+    void load(SaveState& state);
+
+private:
+    std::array<uint8_t, 0x20> registers{};
+
+    std::function<void(uint8_t page)> oam_dma_handler;
+
+    APU* apu{nullptr};
+
+    std::array<Controller*, 2> controllers{};
+};
+
+}
+
+#endif /* NES_EMULATOR_IO_REGISTERS_H_ */
@@ -0,0 +1,1100 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "jit.h"
+#include "cpu.h"
+#include "cpu_instructions.h"
+#include "cpu_operations.h"
+
+#if defined(__x86_64__) && defined(__unix__)
+#define NES_EMULATOR_JIT_X86_64
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+size_t const arena_size{4 * 1024 * 1024};
+
+// Enough for the largest block we can generate, checked again as we emit
+size_t const max_block_code{8 * 1024};
+
+uint32_t const hot_block_runs{8};
+
+#ifdef NES_EMULATOR_JIT_X86_64
+
+enum Reg : uint8_t
+{
+    rax = 0,
+    rcx = 1,
+    rdx = 2,
+    rbx = 3,
+    rsp = 4,
+    rbp = 5,
+    rsi = 6,
+    rdi = 7,
+    r12 = 12,
+    r13 = 13,
+    r14 = 14,
+    r15 = 15
+};
+
+enum Cond : uint8_t
+{
+    equal     = 0x4,
+    not_equal = 0x5
+};
+
+enum Alu : uint8_t
+{
+    add = 0x01,
+    bit_or  = 0x09,
+    bit_and = 0x21,
+    sub = 0x29,
+    bit_xor = 0x31
+};
+
+// Just the x86-64 encodings the translator needs. Memory operands are always
+// [base + disp32].
+class Assembler
+{
+public:
+    Assembler(uint8_t* code, size_t capacity) :
+        code(code),
+        capacity(capacity)
+    {
+    }
+
+    size_t size() const
+    {
+        return position;
+    }
+
+    bool overflowed() const
+    {
+        return position > capacity;
+    }
+
+    void push(Reg r)
+    {
+        rex(false, 0, r);
+        byte(0x50 + (r & 7));
+    }
+
+    void pop(Reg r)
+    {
+        rex(false, 0, r);
+        byte(0x58 + (r & 7));
+    }
+
+    void ret()
+    {
+        byte(0xC3);
+    }
+
+    // mov dst, src
+    void mov64(Reg dst, Reg src)
+    {
+        rex(true, src, dst);
+        byte(0x89);
+        modrm(src, dst);
+    }
+
+    void mov32(Reg dst, Reg src)
+    {
+        rex(false, src, dst);
+        byte(0x89);
+        modrm(src, dst);
+    }
+
+    void mov_imm32(Reg dst, uint32_t value)
+    {
+        rex(false, 0, dst);
+        byte(0xB8 + (dst & 7));
+        imm32(value);
+    }
+
+    void mov_imm64(Reg dst, uint64_t value)
+    {
+        rex(true, 0, dst);
+        byte(0xB8 + (dst & 7));
+        imm64(value);
+    }
+
+    template <typename T>
+    void mov_imm64(Reg dst, T* pointer)
+    {
+        mov_imm64(dst, reinterpret_cast<uint64_t>(pointer));
+    }
+
+    // mov dst, qword [base + disp]
+    void load64(Reg dst, Reg base, int32_t disp)
+    {
+        rex(true, dst, base);
+        byte(0x8B);
+        memory(dst, base, disp);
+    }
+
+    // movzx dst, byte [base + disp]
+    void load8(Reg dst, Reg base, int32_t disp)
+    {
+        rex(false, dst, base);
+        byte(0x0F);
+        byte(0xB6);
+        memory(dst, base, disp);
+    }
+
+    // mov byte [base + disp], src
+    void store8(Reg base, int32_t disp, Reg src)
+    {
+        rex(false, src, base, true);
+        byte(0x88);
+        memory(src, base, disp);
+    }
+
+    void store8_imm(Reg base, int32_t disp, uint8_t value)
+    {
+        rex(false, 0, base);
+        byte(0xC6);
+        memory(0, base, disp);
+        byte(value);
+    }
+
+    void store16_imm(Reg base, int32_t disp, uint16_t value)
+    {
+        byte(0x66);
+        rex(false, 0, base);
+        byte(0xC7);
+        memory(0, base, disp);
+        imm16(value);
+    }
+
+    // add qword [base + disp], imm8 sign extended
+    void add64_imm8(Reg base, int32_t disp, uint8_t value)
+    {
+        rex(true, 0, base);
+        byte(0x83);
+        memory(0, base, disp);
+        byte(value);
+    }
+
+    void test8_imm(Reg base, int32_t disp, uint8_t value)
+    {
+        rex(false, 0, base);
+        byte(0xF6);
+        memory(0, base, disp);
+        byte(value);
+    }
+
+    // seta byte [base + disp]
+    void seta8(Reg base, int32_t disp)
+    {
+        rex(false, 0, base);
+        byte(0x0F);
+        byte(0x97);
+        memory(0, base, disp);
+    }
+
+    void test64(Reg a, Reg b)
+    {
+        rex(true, b, a);
+        byte(0x85);
+        modrm(b, a);
+    }
+
+    void cmp64(Reg a, Reg b)
+    {
+        rex(true, b, a);
+        byte(0x39);
+        modrm(b, a);
+    }
+
+    void cmp32_imm(Reg a, uint32_t value)
+    {
+        alu32_imm(7, a, value);
+    }
+
+    void and32_imm(Reg a, uint32_t value)
+    {
+        alu32_imm(4, a, value);
+    }
+
+    // op dst, src on the 32 bit registers
+    void alu32(Alu op, Reg dst, Reg src)
+    {
+        rex(false, src, dst);
+        byte(op);
+        modrm(src, dst);
+    }
+
+    // op dst, imm32 where op is the /digit of the 0x81 group
+    void alu32_imm(uint8_t digit, Reg dst, uint32_t value)
+    {
+        rex(false, 0, dst);
+        byte(0x81);
+        modrm(digit, dst);
+        imm32(value);
+    }
+
+    void shr32_imm(Reg r, uint8_t value)
+    {
+        rex(false, 0, r);
+        byte(0xC1);
+        modrm(5, r);
+        byte(value);
+    }
+
+    // imul dst, src, imm8
+    void imul32_imm8(Reg dst, Reg src, uint8_t value)
+    {
+        rex(false, dst, src);
+        byte(0x6B);
+        modrm(dst, src);
+        byte(value);
+    }
+
+    void add64(Reg dst, Reg src)
+    {
+        rex(true, src, dst);
+        byte(0x01);
+        modrm(src, dst);
+    }
+
+    // movzx dst, src's low word
+    void movzx16(Reg dst, Reg src)
+    {
+        rex(false, dst, src);
+        byte(0x0F);
+        byte(0xB7);
+        modrm(dst, src);
+    }
+
+    // movzx dst, src's low byte
+    void movzx8(Reg dst, Reg src)
+    {
+        rex(false, dst, src, true);
+        byte(0x0F);
+        byte(0xB6);
+        modrm(dst, src);
+    }
+
+    void call(Reg target)
+    {
+        rex(false, 0, target);
+        byte(0xFF);
+        modrm(2, target);
+    }
+
+    void sub64_imm8(Reg r, uint8_t value)
+    {
+        rex(true, 0, r);
+        byte(0x83);
+        modrm(5, r);
+        byte(value);
+    }
+
+    void add64_imm8(Reg r, uint8_t value)
+    {
+        rex(true, 0, r);
+        byte(0x83);
+        modrm(0, r);
+        byte(value);
+    }
+
+    // Forward jumps return where their offset goes, to be bound later
+    size_t jump_if(Cond cond)
+    {
+        byte(0x0F);
+        byte(0x80 | cond);
+        imm32(0);
+        return position - 4;
+    }
+
+    size_t jump()
+    {
+        byte(0xE9);
+        imm32(0);
+        return position - 4;
+    }
+
+    void jump_to(size_t target)
+    {
+        byte(0xE9);
+        imm32(static_cast<int32_t>(target - (position + 4)));
+    }
+
+    void bind(size_t patch)
+    {
+        if (patch + 4 <= capacity)
+        {
+            int32_t offset = static_cast<int32_t>(position - (patch + 4));
+            std::memcpy(code + patch, &offset, sizeof(offset));
+        }
+    }
+
+private:
+    void byte(uint8_t value)
+    {
+        if (position < capacity)
+        {
+            code[position] = value;
+        }
+
+        position++;
+    }
+
+    void imm16(uint16_t value)
+    {
+        byte(value);
+        byte(value >> 8);
+    }
+
+    void imm32(uint32_t value)
+    {
+        imm16(value);
+        imm16(value >> 16);
+    }
+
+    void imm64(uint64_t value)
+    {
+        imm32(value);
+        imm32(value >> 32);
+    }
+
+    // Byte registers always get a REX so 4-7 mean spl-dil rather than ah-bh
+    void rex(bool wide, uint8_t reg, uint8_t base, bool byte_register = false)
+    {
+        uint8_t prefix = 0x40 | wide << 3 | (reg >> 3) << 2 | (base >> 3);
+
+        if (prefix != 0x40 || byte_register)
+        {
+            byte(prefix);
+        }
+    }
+
+    void modrm(uint8_t reg, uint8_t rm)
+    {
+        byte(0xC0 | (reg & 7) << 3 | (rm & 7));
+    }
+
+    void memory(uint8_t reg, uint8_t base, int32_t disp)
+    {
+        byte(0x80 | (reg & 7) << 3 | (base & 7));
+
+        // rsp and r12 as a base need a SIB byte
+        if ((base & 7) == rsp)
+        {
+            byte(0x24);
+        }
+
+        imm32(disp);
+    }
+
+    uint8_t* code;
+    size_t capacity;
+    size_t position{0};
+};
+
+enum class Native : uint8_t
+{
+    none,
+    load,
+    store,
+    transfer,
+    increment,
+    decrement,
+    bit_and,
+    bit_or,
+    bit_xor,
+    add_with_carry,
+    compare,
+    clear_carry,
+    set_carry,
+    branch,
+    nothing
+};
+
+enum GuestReg : uint8_t
+{
+    guest_a,
+    guest_x,
+    guest_y
+};
+
+enum BranchFlag : uint8_t
+{
+    zero_flag,
+    carry_flag,
+    sign_flag
+};
+
+struct NativeOp
+{
+    Native kind{Native::none};
+    emulator::OpMode mode{emulator::implicit};
+    GuestReg reg{guest_a};
+    GuestReg src{guest_a};
+
+    // Branches are taken when the lazy result masked with the flag's bit is
+    // non zero, or zero when taken_if_set is false
+    BranchFlag flag{zero_flag};
+    bool taken_if_set{false};
+};
+
+// Must do exactly what the handlers do in lazy flag mode, quirks and all,
+// so the lockstep tests against the interpreter hold
+#define NES_EMULATOR_NATIVE_MODE(handler, kind, mode, reg, src) \
+    {&emulator::ops::handler<emulator::mode>, {kind, emulator::mode, reg, src}},
+
+#define NES_EMULATOR_NATIVE_ADDRESSED(handler, kind, reg)              \
+    NES_EMULATOR_NATIVE_MODE(handler, kind, zero_page, reg, reg)       \
+    NES_EMULATOR_NATIVE_MODE(handler, kind, zero_page_x, reg, reg)     \
+    NES_EMULATOR_NATIVE_MODE(handler, kind, zero_page_y, reg, reg)     \
+    NES_EMULATOR_NATIVE_MODE(handler, kind, absolute, reg, reg)        \
+    NES_EMULATOR_NATIVE_MODE(handler, kind, absolute_x, reg, reg)      \
+    NES_EMULATOR_NATIVE_MODE(handler, kind, absolute_y, reg, reg)
+
+#define NES_EMULATOR_NATIVE_MODES(handler, kind, reg)                  \
+    NES_EMULATOR_NATIVE_MODE(handler, kind, immediate, reg, reg)       \
+    NES_EMULATOR_NATIVE_ADDRESSED(handler, kind, reg)
+
+#define NES_EMULATOR_NATIVE_BRANCH(handler, flag, taken_if_set)        \
+    {&emulator::ops::handler<emulator::relative>,                      \
+        {Native::branch, emulator::relative, guest_a, guest_a, flag, taken_if_set}},
+
+struct NativeHandler
+{
+    void (*handler)(emulator::CPU* cpu);
+    NativeOp op;
+};
+
+NativeHandler const native_handlers[] = {
+    NES_EMULATOR_NATIVE_MODES(lda, Native::load, guest_a)
+    NES_EMULATOR_NATIVE_MODES(ldx, Native::load, guest_x)
+    NES_EMULATOR_NATIVE_MODES(ldy, Native::load, guest_y)
+    NES_EMULATOR_NATIVE_MODES(nd,  Native::bit_and, guest_a)
+    NES_EMULATOR_NATIVE_MODES(ora, Native::bit_or, guest_a)
+    NES_EMULATOR_NATIVE_MODES(eor, Native::bit_xor, guest_a)
+    NES_EMULATOR_NATIVE_MODES(adc, Native::add_with_carry, guest_a)
+    NES_EMULATOR_NATIVE_MODES(cmp, Native::compare, guest_a)
+    NES_EMULATOR_NATIVE_MODES(cpx, Native::compare, guest_x)
+    NES_EMULATOR_NATIVE_MODES(cpy, Native::compare, guest_y)
+    NES_EMULATOR_NATIVE_ADDRESSED(sta, Native::store, guest_a)
+    NES_EMULATOR_NATIVE_ADDRESSED(stx, Native::store, guest_x)
+    NES_EMULATOR_NATIVE_ADDRESSED(sty, Native::store, guest_y)
+    NES_EMULATOR_NATIVE_MODE(tax, Native::transfer, implicit, guest_x, guest_a)
+    NES_EMULATOR_NATIVE_MODE(tay, Native::transfer, implicit, guest_y, guest_a)
+    NES_EMULATOR_NATIVE_MODE(txa, Native::transfer, implicit, guest_a, guest_x)
+    NES_EMULATOR_NATIVE_MODE(tya, Native::transfer, implicit, guest_a, guest_y)
+    NES_EMULATOR_NATIVE_MODE(inx, Native::increment, implicit, guest_x, guest_x)
+    NES_EMULATOR_NATIVE_MODE(iny, Native::increment, implicit, guest_y, guest_y)
+    NES_EMULATOR_NATIVE_MODE(dex, Native::decrement, implicit, guest_x, guest_x)
+    NES_EMULATOR_NATIVE_MODE(dey, Native::decrement, implicit, guest_y, guest_y)
+    NES_EMULATOR_NATIVE_MODE(clc, Native::clear_carry, implicit, guest_a, guest_a)
+    NES_EMULATOR_NATIVE_MODE(sec, Native::set_carry, implicit, guest_a, guest_a)
+    NES_EMULATOR_NATIVE_MODE(nop, Native::nothing, implicit, guest_a, guest_a)
+    NES_EMULATOR_NATIVE_MODE(nop, Native::nothing, zero_page, guest_a, guest_a)
+    NES_EMULATOR_NATIVE_BRANCH(beq, zero_flag, false)
+    NES_EMULATOR_NATIVE_BRANCH(bne, zero_flag, true)
+    NES_EMULATOR_NATIVE_BRANCH(bcc, carry_flag, false)
+    NES_EMULATOR_NATIVE_BRANCH(bcs, carry_flag, true)
+    NES_EMULATOR_NATIVE_BRANCH(bpl, sign_flag, false)
+    NES_EMULATOR_NATIVE_BRANCH(bmi, sign_flag, true)
+};
+
+#undef NES_EMULATOR_NATIVE_MODE
+#undef NES_EMULATOR_NATIVE_ADDRESSED
+#undef NES_EMULATOR_NATIVE_MODES
+#undef NES_EMULATOR_NATIVE_BRANCH
+
+NativeOp native_op(void (*handler)(emulator::CPU* cpu))
+{
+    for (auto const& native : native_handlers)
+    {
+        if (native.handler == handler)
+        {
+            return native.op;
+        }
+    }
+
+    return {};
+}
+
+bool may_call_out(Native kind, emulator::OpMode mode)
+{
+    switch (kind)
+    {
+        case Native::none:
+        case Native::store:
+            return true;
+        case Native::load:
+        case Native::bit_and:
+        case Native::bit_or:
+        case Native::bit_xor:
+        case Native::add_with_carry:
+        case Native::compare:
+            return mode != emulator::immediate;
+        default:
+            return false;
+    }
+}
+
+Reg host_reg(GuestReg reg)
+{
+    switch (reg)
+    {
+        case guest_x:
+            return r13;
+        case guest_y:
+            return r14;
+        default:
+            return r12;
+    }
+}
+
+uint8_t read_through_bus(emulator::CPU* cpu, uint16_t address)
+{
+    return cpu->read8(address);
+}
+
+void write_through_bus(emulator::CPU* cpu, uint16_t address, uint8_t value)
+{
+    cpu->write8(address, value);
+}
+
+#endif
+}
+
+emulator::JIT::JIT(CPU* cpu, BlockCache* cache) :
+    cpu(cpu),
+    cache(cache)
+{
+#ifdef NES_EMULATOR_JIT_X86_64
+    // Starts out writable, translate() flips the pages it emits into to
+    // executable once each block is written
+    auto memory = mmap(nullptr, arena_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (memory != MAP_FAILED)
+    {
+        arena = static_cast<uint8_t*>(memory);
+    }
+#endif
+}
+
+emulator::JIT::~JIT()
+{
+#ifdef NES_EMULATOR_JIT_X86_64
+    if (arena)
+    {
+        munmap(arena, arena_size);
+    }
+#endif
+}
+
+bool emulator::JIT::available() const
+{
+    return arena != nullptr;
+}
+
+bool emulator::JIT::translate(BlockCache::Block& block)
+{
+    if (!arena || !cpu->lazy_flags())
+    {
+        return false;
+    }
+
+    // Generated code has the program counter baked in, so a block entered
+    // through a mirror of where it was decoded stays interpreted
+    if (block.address != cpu->program_counter_)
+    {
+        return false;
+    }
+
+    if (block.native)
+    {
+        return true;
+    }
+
+    if (full || ++block.runs < hot_block_runs)
+    {
+        return false;
+    }
+
+    size_t size = 0;
+
+    if (arena_size - used < max_block_code)
+    {
+        full = true;
+        return false;
+    }
+
+    if (!protect_unused(true))
+    {
+        return false;
+    }
+
+    auto emitted = emit(block, arena + used, arena_size - used, size);
+
+    if (!protect_unused(false))
+    {
+        return false;
+    }
+
+    if (!emitted)
+    {
+        full = true;
+        return false;
+    }
+
+    block.native = reinterpret_cast<void (*)(CPU*)>(arena + used);
+    used += size;
+    translated++;
+
+    return true;
+}
+
+void emulator::JIT::reclaim()
+{
+    if (full)
+    {
+        cache->flush();
+        used = 0;
+        full = false;
+    }
+}
+
+size_t emulator::JIT::translated_blocks() const
+{
+    return translated;
+}
+
+bool emulator::JIT::protect_unused(bool writable)
+{
+#ifdef NES_EMULATOR_JIT_X86_64
+    // From the page the next block starts in, which may hold the end of the
+    // last block, to the end of the arena
+    size_t page  = sysconf(_SC_PAGESIZE);
+    size_t first = used / page * page;
+
+    return mprotect(arena + first, arena_size - first, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) == 0;
+#else
+    (void)writable;
+    return false;
+#endif
+}
+
+#ifdef NES_EMULATOR_JIT_X86_64
+
+bool emulator::JIT::emit(BlockCache::Block const& block, uint8_t* code, size_t capacity, size_t& size) const
+{
+    auto base   = reinterpret_cast<uint8_t const*>(cpu);
+    auto offset = [base](void const* member) {
+        return static_cast<int32_t>(static_cast<uint8_t const*>(member) - base);
+    };
+
+    auto const pc         = offset(&cpu->program_counter_);
+    auto const operand    = offset(&cpu->operand_);
+    auto const jumped     = offset(&cpu->jumped_);
+    auto const cycles     = offset(&cpu->cycles_);
+    auto const status     = offset(&cpu->status_);
+    auto const zero_res   = offset(&cpu->zero_result_);
+    auto const sign_res   = offset(&cpu->sign_result_);
+    auto const carry_res  = offset(&cpu->carry_result_);
+    auto const ov_acc     = offset(&cpu->overflow_acc_);
+    auto const ov_mem     = offset(&cpu->overflow_mem_);
+    auto const ov_result  = offset(&cpu->overflow_result_);
+
+    int32_t const guest[] = {
+        offset(&cpu->accumulator_),
+        offset(&cpu->x_register_),
+        offset(&cpu->y_register_)
+    };
+
+    static_assert(sizeof(Bus::Page) < 0x80, "Page table stride has to fit an imul imm8");
+
+    auto const page_stride = static_cast<int32_t>(sizeof(Bus::Page));
+    auto const page_read   = static_cast<int32_t>(offsetof(Bus::Page, read));
+    auto const page_write  = static_cast<int32_t>(offsetof(Bus::Page, write));
+
+    Assembler a(code, capacity);
+
+    auto spill = [&] {
+        a.store8(rbx, guest[guest_a], r12);
+        a.store8(rbx, guest[guest_x], r13);
+        a.store8(rbx, guest[guest_y], r14);
+    };
+
+    auto reload = [&] {
+        a.load8(r12, rbx, guest[guest_a]);
+        a.load8(r13, rbx, guest[guest_x]);
+        a.load8(r14, rbx, guest[guest_y]);
+    };
+
+    auto zero_sign = [&](Reg value) {
+        a.store8(rbx, zero_res, value);
+        a.store8(rbx, sign_res, value);
+    };
+
+    // Reads into eax or writes src through the bus page table, calling back
+    // into the bus for pages it can't read or write directly
+    auto access = [&](OpMode mode, uint16_t value, bool write, Reg src) {
+        auto field = write ? page_write : page_read;
+
+        auto call_bus = [&] {
+            a.mov64(rdi, rbx);
+
+            if (write)
+            {
+                a.mov32(rdx, src);
+                a.mov_imm64(rax, &write_through_bus);
+            }
+            else
+            {
+                a.mov_imm64(rax, &read_through_bus);
+            }
+
+            a.call(rax);
+
+            if (!write)
+            {
+                a.movzx8(rax, rax);
+            }
+        };
+
+        if (mode == zero_page || mode == absolute)
+        {
+            uint16_t address = mode == zero_page ? value & 0xFF : value;
+
+            a.load64(rax, r15, (address >> 8) * page_stride + field);
+            a.test64(rax, rax);
+            auto slow = a.jump_if(equal);
+
+            if (write)
+            {
+                a.store8(rax, address & 0xFF, src);
+            }
+            else
+            {
+                a.load8(rax, rax, address & 0xFF);
+            }
+
+            auto done = a.jump();
+
+            a.bind(slow);
+            a.mov_imm32(rsi, address);
+            call_bus();
+            a.bind(done);
+            return;
+        }
+
+        bool zero_page_indexed = mode == zero_page_x || mode == zero_page_y;
+        uint16_t base = zero_page_indexed ? value & 0xFF : value;
+        auto index    = mode == zero_page_x || mode == absolute_x ? r13 : r14;
+
+        a.mov_imm32(rcx, base);
+        a.alu32(add, rcx, index);
+
+        // Crossing a page costs a cycle, as in CPU::absolute_get_address
+        a.mov32(rdx, rcx);
+        a.and32_imm(rdx, 0xFF00);
+        a.cmp32_imm(rdx, base & 0xFF00);
+        auto same_page = a.jump_if(equal);
+        a.add64_imm8(rbx, cycles, 1);
+        a.bind(same_page);
+
+        a.movzx16(rcx, rcx);
+        a.mov32(rdx, rcx);
+        a.shr32_imm(rdx, 8);
+        a.imul32_imm8(rdx, rdx, page_stride);
+        a.add64(rdx, r15);
+
+        a.load64(rax, rdx, field);
+        a.test64(rax, rax);
+        auto slow = a.jump_if(equal);
+        a.movzx8(rdx, rcx);
+        a.add64(rax, rdx);
+
+        if (write)
+        {
+            a.store8(rax, 0, src);
+        }
+        else
+        {
+            a.load8(rax, rax, 0);
+        }
+
+        auto done = a.jump();
+
+        a.bind(slow);
+        a.mov32(rsi, rcx);
+        call_bus();
+        a.bind(done);
+    };
+
+    // Leaves the operand value in eax
+    auto load_operand = [&](OpMode mode, uint16_t value) {
+        if (mode == immediate)
+        {
+            a.mov_imm32(rax, value & 0xFF);
+            return;
+        }
+
+        access(mode, value, false, rax);
+    };
+
+    struct Exit
+    {
+        size_t patch;
+        uint16_t pc;
+    };
+
+    std::vector<Exit> exits;
+    uint32_t pending_cycles = 0;
+
+    auto flush_cycles = [&] {
+        while (pending_cycles > 0)
+        {
+            auto chunk = pending_cycles > 0x7F ? 0x7F : pending_cycles;
+            a.add64_imm8(rbx, cycles, chunk);
+            pending_cycles -= chunk;
+        }
+    };
+
+    // Anything that calls out may have written over this very block
+    auto check_generation = [&](uint16_t next_pc) {
+        a.mov_imm64(rax, &cache->generation_);
+        a.load64(rax, rax, 0);
+        a.cmp64(rax, rbp);
+        exits.push_back({a.jump_if(not_equal), next_pc});
+    };
+
+    a.push(rbx);
+    a.push(rbp);
+    a.push(r12);
+    a.push(r13);
+    a.push(r14);
+    a.push(r15);
+    a.sub64_imm8(rsp, 8);
+
+    a.mov64(rbx, rdi);
+    reload();
+    a.mov_imm64(r15, cpu->bus.pages.data());
+    a.mov_imm64(rax, &cache->generation_);
+    a.load64(rbp, rax, 0);
+
+    uint16_t op_pc = cpu->program_counter_;
+    bool pc_written = false;
+
+    for (auto i = 0u; i < block.ops.size(); i++)
+    {
+        auto const& op = block.ops[i];
+        bool last      = i + 1 == block.ops.size();
+        auto native    = native_op(op.handler);
+        auto mode      = native.mode;
+        auto calls_out = may_call_out(native.kind, mode);
+
+        uint16_t next_pc = op_pc + op.number_bytes;
+        auto reg         = host_reg(native.reg);
+
+        if (calls_out)
+        {
+            flush_cycles();
+        }
+
+        switch (native.kind)
+        {
+            case Native::load:
+                load_operand(mode, op.operand);
+                a.mov32(reg, rax);
+                zero_sign(reg);
+                break;
+            case Native::store:
+                access(mode, op.operand, true, reg);
+                break;
+            case Native::transfer:
+                a.mov32(reg, host_reg(native.src));
+                zero_sign(reg);
+                break;
+            case Native::increment:
+            case Native::decrement:
+                // Flags come from the value before the step, as in the handlers
+                zero_sign(reg);
+                a.mov_imm32(rax, 1);
+                a.alu32(native.kind == Native::increment ? add : sub, reg, rax);
+                a.movzx8(reg, reg);
+                break;
+            case Native::bit_and:
+                load_operand(mode, op.operand);
+                a.alu32(bit_and, r12, rax);
+                zero_sign(r12);
+                break;
+            case Native::bit_or:
+                // ORA sets Z and N from the operand, as in the handler
+                load_operand(mode, op.operand);
+                a.alu32(bit_or, r12, rax);
+                zero_sign(rax);
+                break;
+            case Native::bit_xor:
+                load_operand(mode, op.operand);
+                a.alu32(bit_xor, r12, rax);
+                break;
+            case Native::add_with_carry:
+            {
+                load_operand(mode, op.operand);
+                a.load8(rcx, rbx, carry_res);
+                a.mov32(rdx, r12);
+                a.alu32(add, rdx, rax);
+                a.alu32(add, rdx, rcx);
+                a.store8(rbx, zero_res, rdx);
+
+                a.test8_imm(rbx, status, decimal);
+                auto decimal_mode = a.jump_if(not_equal);
+                a.store8(rbx, sign_res, rdx);
+                a.store8(rbx, ov_acc, r12);
+                a.store8(rbx, ov_mem, rax);
+                a.store8(rbx, ov_result, rdx);
+                a.cmp32_imm(rdx, 0xFF);
+                a.seta8(rbx, carry_res);
+                a.bind(decimal_mode);
+
+                a.movzx8(r12, rdx);
+                break;
+            }
+            case Native::compare:
+                // The difference is only 8 bits wide in the handlers so C always clears
+                load_operand(mode, op.operand);
+                a.mov32(rdx, reg);
+                a.alu32(sub, rdx, rax);
+                zero_sign(rdx);
+                a.store8_imm(rbx, carry_res, 0);
+                break;
+            case Native::clear_carry:
+                a.store8_imm(rbx, carry_res, 0);
+                break;
+            case Native::set_carry:
+                a.store8_imm(rbx, carry_res, 1);
+                break;
+            case Native::branch:
+            {
+                int32_t flag[] = {zero_res, carry_res, sign_res};
+                uint8_t mask[] = {0xFF, 0xFF, 0x80};
+
+                uint16_t target = next_pc + static_cast<int8_t>(op.operand & 0xFF);
+
+                a.test8_imm(rbx, flag[native.flag], mask[native.flag]);
+                auto taken = a.jump_if(native.taken_if_set ? not_equal : equal);
+                a.store16_imm(rbx, pc, next_pc);
+                auto done = a.jump();
+
+                // Always the one cycle, CPU::add_branch_cycle compares the
+                // target against the program counter after it has moved
+                a.bind(taken);
+                a.store16_imm(rbx, pc, target);
+                a.add64_imm8(rbx, cycles, 1);
+                a.bind(done);
+
+                pc_written = true;
+                break;
+            }
+            case Native::nothing:
+                break;
+            case Native::none:
+                spill();
+                a.store16_imm(rbx, pc, op_pc);
+                a.store16_imm(rbx, operand, op.operand);
+                a.store8_imm(rbx, jumped, 0);
+                a.mov64(rdi, rbx);
+                a.mov_imm64(rax, op.handler);
+                a.call(rax);
+                reload();
+
+                if (last)
+                {
+                    // Only the last op of a block can move the program counter
+                    a.test8_imm(rbx, jumped, 1);
+                    auto moved = a.jump_if(not_equal);
+                    a.store16_imm(rbx, pc, next_pc);
+                    a.bind(moved);
+                    pc_written = true;
+                }
+                break;
+        }
+
+        pending_cycles += op.number_cycles;
+
+        if (calls_out)
+        {
+            flush_cycles();
+
+            if (!last)
+            {
+                check_generation(next_pc);
+            }
+        }
+
+        op_pc = next_pc;
+    }
+
+    flush_cycles();
+
+    if (!pc_written)
+    {
+        a.store16_imm(rbx, pc, op_pc);
+    }
+
+    auto epilogue = a.size();
+    spill();
+    a.add64_imm8(rsp, 8);
+    a.pop(r15);
+    a.pop(r14);
+    a.pop(r13);
+    a.pop(r12);
+    a.pop(rbp);
+    a.pop(rbx);
+    a.ret();
+
+    for (auto const& exit : exits)
+    {
+        a.bind(exit.patch);
+        a.store16_imm(rbx, pc, exit.pc);
+        a.jump_to(epilogue);
+    }
+
+    size = a.size();
+    return !a.overflowed();
+}
+
+#else
+
+bool emulator::JIT::emit(BlockCache::Block const& /*block*/, uint8_t* /*code*/, size_t /*capacity*/, size_t& /*size*/) const
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,97 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+x86-64 translation of hot basic blocks.
+
+Blocks come from the block cache, once one has run hot_block_runs times it is
+translated into native code in an arena. The arena is never writable and
+executable at the same time. It is made writable only while a block is
+emitted. While a block runs the accumulator, X and Y live in r12, r13 and
+r14, the CPU in rbx and the bus page table in r15.
+
+Loads, stores, transfers, increments and the ALU ops are generated inline.
+Memory goes through the bus page table at run time, so a page that is an
+I/O device or has been write protected by the block cache takes a call back
+into the bus instead. Everything else calls the op's specialized handler.
+
+Generated code writes the flags the lazy way, so blocks only run natively
+while the CPU has lazy flags on. On other hosts translate() always fails
+and the blocks are interpreted.
+
+*/
+
+#ifndef NES_EMULATOR_JIT_H_
+#define NES_EMULATOR_JIT_H_
+
+#include "block_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace emulator
+{
+class CPU;
+
+class JIT
+{
+public:
+    JIT(CPU* cpu, BlockCache* cache);
+    ~JIT();
+
+    JIT(JIT const&) = delete;
+    JIT& operator=(JIT const&) = delete;
+
+    bool available() const;
+
+    // True once block has native code to run, it may take a few calls
+    bool translate(BlockCache::Block& block);
+
+    // Starts the arena over once it can't fit another block. This drops every
+    // cached block so must not be called while one is running.
+    void reclaim();
+
+    size_t translated_blocks() const;
+
+private:
+    bool emit(BlockCache::Block const& block, uint8_t* code, size_t capacity, size_t& size) const;
+
+    // Makes the arena from the page holding used to the end read write for
+    // emitting, or read execute for running
+    bool protect_unused(bool writable);
+
+    CPU* cpu;
+    BlockCache* cache;
+
+    uint8_t* arena{nullptr};
+    size_t used{0};
+    bool full{false};
+    size_t translated{0};
+};
+
+}
+
+#endif /* NES_EMULATOR_JIT_H_ */
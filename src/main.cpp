@@ -23,39 +23,82 @@
  * SOFTWARE.
  */
 
+#include <atomic>
 #include <bitset>
+#include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <iterator>
-#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 
-#include "cpu.h"
+#include <SDL.h>
+
+#include "console.h"
+#include "run_ahead.h"
+#include "sdl_audio.h"
+#include "sdl_input.h"
+#include "sdl_video.h"
+#include "triple_buffer.h"
 
 namespace
 {
-uint32_t const expected_magic_nes_header{0x1a53454e};
-uint32_t const kilobyte{1024};
-}
+#ifdef NES_EMULATOR_TRACE
+size_t const trace_records{1 << 20};
+#endif
+
+char const* const default_rom{"../super_mario.nes"};
+
+// Most games show input a frame after reading it
+uint8_t const default_run_ahead{1};
+
+using Clock = std::chrono::steady_clock;
+
+// 60.0988Hz, 89342 PPU dots a frame
+std::chrono::duration<double> const frame_period{
+    static_cast<double>(emulator::ppu_dots_per_frame) /
+    (emulator::ppu_dots_per_cpu_cycle * emulator::cpu_clock_rate)};
+
+// Further behind than this and the frame clock starts again from now, rather
+// than running flat out to catch up
+std::chrono::milliseconds const max_lag{100};
 
-std::vector<uint8_t> read_in_file(std::string const& path)
+// Emulation thread. Paced by the clock, with the audio's rate control taking
+// up whatever drift there is between it and the sound card. Never waits on
+// the render thread.
+void emulate(emulator::RunAhead& run_ahead, emulator::ConsoleBase& console,
+             emulator::TripleBuffer& frames, std::atomic<bool> const& running)
 {
-    std::ifstream is(path, std::ifstream::binary);
-    is >> std::noskipws;
-    return std::vector<uint8_t>(std::istream_iterator<uint8_t>(is), {});
+    auto next_frame = Clock::now();
+
+    while (running.load(std::memory_order_relaxed))
+    {
+        // Audio is handed over after the real frame, the picture is the last
+        // frame run ahead
+        run_ahead.run_frame();
+
+        frames.back() = console.ppu().rgba_framebuffer();
+        frames.publish();
+
+        next_frame += std::chrono::duration_cast<Clock::duration>(frame_period);
+
+        auto now = Clock::now();
+        if (now - next_frame > max_lag)
+        {
+            next_frame = now;
+        }
+        else
+        {
+            std::this_thread::sleep_until(next_frame);
+        }
+    }
+}
 }
 
-struct RomHeader
-{
-    uint32_t nes_magic;
-    uint8_t  prg_size;
-    uint8_t  chr_size;
-    uint8_t  flags_six;
-    uint8_t  flags_seven;
-    uint8_t  prg_ram_size;
-    uint8_t  flags_nine;
-};
-
-std::ostream& operator<<(std::ostream& os, RomHeader const& header)
+std::ostream& operator<<(std::ostream& os, emulator::RomHeader const& header)
 {
     return os << "PRG ROM: " << std::hex << "0x" << (int)header.prg_size << std::endl
               << "CHR ROM: " << std::hex << "0x" << (int)header.chr_size << std::endl
@@ -65,96 +108,112 @@ std::ostream& operator<<(std::ostream& os, RomHeader const& header)
               << "Flgas 9: " << std::bitset<8>(header.flags_nine);
 }
 
-int main()
+int main(int argc, char* argv[])
 {
-    emulator::PPU ppu;
-    emulator::CPU cpu(&ppu);
+    std::string rom_path = argc > 1 ? argv[1] : default_rom;
+    auto run_ahead_frames = argc > 2 ? static_cast<uint8_t>(std::strtoul(argv[2], nullptr, 10)) : default_run_ahead;
+    std::unique_ptr<emulator::ConsoleBase> console;
 
-    ppu.set_non_maskable_interrupt_handler([&cpu] {
-        cpu.handle_non_maskable_interrupt();
-    });
+    try
+    {
+        auto rom = emulator::load_rom(rom_path);
 
-    auto raw_rom = read_in_file("../super_mario.nes");
-    uint32_t current_byte = 0x10;
+        std::cout << rom.header() << " " << std::endl
+                  << "Mapper number: "  << std::hex << "0x" << rom.mapper() << std::endl << std::dec
+                  << "Mirroring: " << static_cast<int>(rom.mirroring()) << std::endl
+                  << "Battery: " << rom.battery() << std::endl
+                  << "Trainer: " << rom.trainer() << std::endl
+                  << "PrgBytes: " << rom.prg_size() << std::endl
+                  << "ChrBytes: " << rom.chr_size() << std::endl;
 
-    if (raw_rom.size() < 0xF)
+        console = emulator::make_console(std::move(rom));
+    }
+    catch (std::runtime_error const& error)
     {
-        std::cerr << "Invalid size, less then the expect" << std::endl;
+        std::cerr << error.what() << std::endl;
         return -1;
     }
 
-    RomHeader header = *reinterpret_cast<RomHeader*>(raw_rom.data());
+    console->reset();
 
-    if (header.nes_magic != expected_magic_nes_header)
+#ifdef NES_EMULATOR_TRACE
+    // Only the first frame, the trace would outgrow any buffer otherwise
+    emulator::TraceBuffer trace(trace_records);
+    console->run_frame(trace);
+
+    // Render with nes-trace-dump
+    std::ofstream trace_file("nes.trace", std::ofstream::binary);
+    trace.save(trace_file);
+#endif
+
+    if (SDL_Init(SDL_INIT_EVENTS) != 0)
     {
-        std::cerr << "Incorrect file type, expect *.nes" << std::endl;
+        std::cerr << "Failed to init SDL: " << SDL_GetError() << std::endl;
         return -1;
     }
 
-    auto lower_nibble = header.flags_six >> 4;
-    auto upper_nibble = header.flags_seven >> 4;
-    auto mapper = lower_nibble | upper_nibble << 4;
-
-    auto mirror_mode    = header.flags_six & 0x1;
-    auto disable_mirror = (header.flags_six >> 3) & 0x1;
-
-    auto battery = (header.flags_six >> 1) & 0x1;
+    std::unique_ptr<emulator::SDLVideo> video;
+    std::unique_ptr<emulator::SDLAudio> audio;
 
-    auto trainer = (header.flags_six >> 2) & 0x1;
+    try
+    {
+        video = std::make_unique<emulator::SDLVideo>();
+    }
+    catch (std::runtime_error const& error)
+    {
+        std::cerr << error.what() << std::endl;
+        SDL_Quit();
+        return -1;
+    }
 
-    // TODO
-    if (trainer)
+    // Plays on silently without a sound card
+    try
+    {
+        audio = std::make_unique<emulator::SDLAudio>();
+    }
+    catch (std::runtime_error const& error)
     {
-        current_byte += 0x200;
+        std::cerr << error.what() << std::endl;
     }
 
-    auto prg_byte_size = header.prg_size * kilobyte * 16;
-    auto chr_byte_size = header.chr_size * kilobyte * 8;
+    emulator::RunAhead run_ahead(console.get(), run_ahead_frames);
 
-    if (raw_rom.size() != current_byte + prg_byte_size + chr_byte_size)
+    // Without a device the APU drops what it can't hold
+    if (audio)
     {
-        // TODO need to account for extra things like PlayerChoice10
-        std::cerr << "Assumption on file size. We to many or to few bytes in the *.nes file!" << std::endl;
+        run_ahead.set_audio_handler([&audio] (emulator::APU& apu) {
+            audio->queue_frame(apu);
+        });
     }
 
-    std::vector<uint8_t> prg(raw_rom.data() + current_byte, raw_rom.data() + current_byte + prg_byte_size);
-    current_byte += prg_byte_size;
+    emulator::TripleBuffer frames;
+    std::atomic<bool> running{true};
 
-    std::vector<uint8_t> chr(raw_rom.data() + current_byte, raw_rom.data() + current_byte + chr_byte_size);
-    current_byte += chr_byte_size;
+    std::thread emulation(emulate, std::ref(run_ahead), std::ref(*console), std::ref(frames), std::cref(running));
 
-    std::cout << header << " " << std::endl
-              << "Mapper number: "  << std::hex << "0x" << mapper << std::endl << std::dec
-              << "MirrorMode: " << (mirror_mode ? "Vertical" : "Horizontal") << std::endl
-              << "DisableMirror: " << disable_mirror << std::endl
-              << "Battery: " << battery << std::endl
-              << "Trainer: " << trainer << std::endl
-              << "PrgBytes: " << prg.size() << std::endl
-              << "ChrBytes: " << chr.size() << std::endl;
-
-    int index = 0x8000;
-    for (auto i = prg.begin(); i != prg.end(); ++i)
+    // Render thread, paced by vsync
+    while (emulator::poll_input(console->controller(0)))
     {
-        cpu.memory.write8(index++, *i);
+        video->present(frames);
     }
-/*
-    std::copy(prg.begin(), prg.end(), cpu.memory.begin() + 0x8000);
-    printf("%lu %i - %i\n", prg.size(), cpu.memory[0xFFFC], cpu.memory[0xFFFD]);
-    */
-    cpu.reset();
 
-    //cpu.memory[0x2002] = 0xFF;
+    running = false;
+    emulation.join();
+
+    std::cout << "Frames emulated: " << frames.published()
+              << ", shown: " << video->frames_shown() << std::endl;
 
-    for (auto i = 0u; i < 200; i++)
+    if (run_ahead.frames())
     {
-        //printf("PC: %i\n", cpu.program_counter());
-        printf("%i\n", (int)cpu.step());
-        //cpu.step();
+        std::cout << "Run-ahead: " << static_cast<int>(run_ahead.frames()) << " frames, "
+                  << run_ahead.state_size() << " byte state, save "
+                  << run_ahead.save_time().count() / 1000.0 << "us, load "
+                  << run_ahead.load_time().count() / 1000.0 << "us" << std::endl;
     }
 
-    std::cout << std::endl;
-
-    cpu.dump_ram();
+    audio.reset();
+    video.reset();
+    SDL_Quit();
 
     return 0;
 }
@@ -0,0 +1,180 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mapper.h"
+#include "mappers.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+// Where DMC sample addresses start
+uint32_t const sample_space{0xC000};
+}
+
+emulator::Mapper::Mapper(Rom const* rom, Bus* bus, PPU* ppu) :
+    rom(rom),
+    bus(bus),
+    ppu(ppu)
+{
+    if (!rom->chr_size())
+    {
+        chr_ram.resize(0x2000);
+    }
+
+    ppu->set_pattern_rom(rom->chr(), rom->chr_size(), rom->chr_tiles());
+}
+
+uint8_t emulator::Mapper::read(uint16_t /*address*/)
+{
+    return 0;
+}
+
+uint16_t emulator::Mapper::number() const
+{
+    return rom->mapper();
+}
+
+void emulator::Mapper::set_scheduler(Scheduler* scheduler)
+{
+    this->scheduler = scheduler;
+}
+
+void emulator::Mapper::set_clock(std::function<uint64_t()> const& clock)
+{
+    this->clock = clock;
+}
+
+void emulator::Mapper::set_interrupt_request_handler(std::function<void(bool asserted)> const& irq_handler)
+{
+    interrupt_request_handler = irq_handler;
+}
+
+void emulator::Mapper::set_apu(APU* apu)
+{
+    this->apu = apu;
+}
+
+uint64_t emulator::Mapper::now() const
+{
+    return clock ? clock() : 0;
+}
+
+void emulator::Mapper::save(SaveState& state) const
+{
+    state.write(prg_ram);
+    state.write(chr_ram.data(), chr_ram.size());
+}
+
+void emulator::Mapper::load(SaveState& state)
+{
+    state.read(prg_ram);
+    state.read(chr_ram.data(), chr_ram.size());
+}
+
+void emulator::Mapper::map_cartridge_space()
+{
+    bus->map_device(0x60, 0xA0, this);
+    bus->map_memory(0x60, 0x20, prg_ram.data(), prg_ram.size());
+
+    ppu->set_mirroring(rom->mirroring());
+}
+
+uint32_t emulator::Mapper::prg_banks(uint32_t size) const
+{
+    return rom->prg_size() / size ? rom->prg_size() / size : 1;
+}
+
+void emulator::Mapper::map_prg(uint16_t address, uint32_t size, uint32_t bank)
+{
+    // Fetches due under the old bank have to read it
+    if (apu && address + size > sample_space && apu->fetching_samples())
+    {
+        apu->catch_up(now());
+    }
+
+    // A 16KB ROM fills a 32KB bank by repeating
+    auto mapped = size > rom->prg_size() ? rom->prg_size() : size;
+    auto offset = bank % prg_banks(size) * mapped;
+
+    bus->map_read_only(address >> 8, size >> 8, rom->prg() + offset, mapped);
+}
+
+void emulator::Mapper::map_chr(uint16_t address, uint32_t size, uint32_t bank)
+{
+    auto first = address / pattern_bank_size;
+    auto count = size / pattern_bank_size;
+
+    if (!chr_ram.empty())
+    {
+        auto offset = bank * size % chr_ram.size();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ppu->map_pattern_ram(first + i, chr_ram.data() + offset + i * pattern_bank_size);
+        }
+        return;
+    }
+
+    auto banks  = rom->chr_size() / size ? rom->chr_size() / size : 1;
+    auto offset = bank % banks * size;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        ppu->map_pattern_bank(first + i, rom->chr() + (offset + i * pattern_bank_size) % rom->chr_size());
+    }
+}
+
+void emulator::Mapper::set_mirroring(Mirroring mirroring)
+{
+    ppu->set_mirroring(mirroring);
+}
+
+std::unique_ptr<emulator::Mapper> emulator::make_mapper(Rom const* rom, Bus* bus, PPU* ppu)
+{
+    std::unique_ptr<Mapper> mapper;
+
+    switch (rom->mapper())
+    {
+        case 0:
+            mapper.reset(new NROM(rom, bus, ppu));
+            break;
+        case 1:
+            mapper.reset(new MMC1(rom, bus, ppu));
+            break;
+        case 2:
+            mapper.reset(new UxROM(rom, bus, ppu));
+            break;
+        case 3:
+            mapper.reset(new CNROM(rom, bus, ppu));
+            break;
+        case 4:
+            mapper.reset(new MMC3(rom, bus, ppu));
+            break;
+        default:
+            throw std::runtime_error("Unsupported mapper " + std::to_string(rom->mapper()));
+    }
+
+    return mapper;
+}
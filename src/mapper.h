@@ -0,0 +1,140 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Cartridge mappers.
+
+A mapper owns cartridge space on the CPU bus, 0x6000 - 0xFFFF, and the
+pattern tables on the PPU. Reads never reach it: PRG ROM, PRG RAM and CHR
+are mapped as bus and pattern bank pointers into the ROM image. Only writes
+to ROM addresses land here, as bank select registers, and a bank switch is
+a few pointer stores.
+
+    Address range     Size     Contents
+    ------------------------------------
+    0x6000 - 0x7FFF : 0x2000 : PRG RAM
+    0x8000 - 0xFFFF : 0x8000 : PRG ROM in 8KB, 16KB or 32KB banks
+
+*/
+
+#ifndef NES_EMULATOR_MAPPER_H_
+#define NES_EMULATOR_MAPPER_H_
+
+#include "apu.h"
+#include "bus.h"
+#include "ppu.h"
+#include "rom.h"
+#include "save_state.h"
+#include "scheduler.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace emulator
+{
+
+class Mapper : public BusDevice
+{
+public:
+    // rom has to outlive the mapper, bus and ppu are where it maps itself
+    Mapper(Rom const* rom, Bus* bus, PPU* ppu);
+
+    // Maps cartridge space and the power on banks
+    virtual void reset() = 0;
+
+    // PRG RAM is mapped as memory, so only PRG ROM reads get here
+    uint8_t read(uint16_t address) override;
+
+    uint16_t number() const;
+
+    // For mappers that raise IRQs, set before reset(). They post
+    // Event::mapper_irq for when their next IRQ is due, and call the handler
+    // with true when they pull the line and false when the game acknowledges.
+    void set_scheduler(Scheduler* scheduler);
+    void set_clock(std::function<uint64_t()> const& clock);
+    void set_interrupt_request_handler(std::function<void(bool asserted)> const& irq_handler);
+
+    // DMC samples are read from 0xC000 - 0xFFFF when the APU catches up, so
+    // switching a bank there catches it up first
+    void set_apu(APU* apu);
+
+    // Forwarded from the PPU, rendering changes how scanline counters run
+    virtual void rendering_changed(bool /*rendering*/)
+    {
+    }
+
+    // PRG RAM and CHR RAM here, mappers with registers add them and map
+    // their banks again on load
+    virtual void save(SaveState& state) const;
+    virtual void load(SaveState& state);
+
+protected:
+    // Points size bytes of CPU space at address to PRG bank, the bank is
+    // counted in size units and wraps around the PRG size
+    void map_prg(uint16_t address, uint32_t size, uint32_t bank);
+
+    // Same for the PPU pattern tables
+    void map_chr(uint16_t address, uint32_t size, uint32_t bank);
+
+    void set_mirroring(Mirroring mirroring);
+
+    // Number of size banks in PRG
+    uint32_t prg_banks(uint32_t size) const;
+
+    // Maps PRG RAM and takes the ROM space writes
+    void map_cartridge_space();
+
+    // Master clock cycle, 0 until a clock is set
+    uint64_t now() const;
+
+    Rom const* rom;
+    Bus* bus;
+    PPU* ppu;
+
+    Scheduler* scheduler{nullptr};
+    std::function<uint64_t()> clock;
+    std::function<void(bool asserted)> interrupt_request_handler;
+    APU* apu{nullptr};
+
+private:
+    std::array<uint8_t, 0x2000> prg_ram{};
+
+    // For carts without CHR ROM
+    std::vector<uint8_t> chr_ram;
+};
+
+// Every supported mapper, including the uncommon ones that run through the
+// virtual fallback console and have no Console instantiation of their own.
+// The mapper is not reset, whoever owns it sets it up and then resets it.
+// Throws if the ROM's mapper isn't supported.
+std::unique_ptr<Mapper> make_mapper(Rom const* rom, Bus* bus, PPU* ppu);
+
+}
+
+#endif /* NES_EMULATOR_MAPPER_H_ */
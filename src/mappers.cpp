@@ -0,0 +1,578 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mappers.h"
+
+#include <algorithm>
+
+namespace
+{
+uint32_t const kilobyte{1024};
+
+// Where the MMC3 counter is clocked, dot 260 of each visible line and the pre
+// render line, with the usual background at 0x0000 sprites at 0x1000 setup
+uint32_t const dots_per_scanline{341};
+uint32_t const counter_dot{260};
+uint16_t const counted_visible_lines{240};
+uint16_t const pre_render_scanline{261};
+uint64_t const clocks_per_frame{counted_visible_lines + 1};
+
+// Counter clocks at or before cycle since power on, rendering or not
+uint64_t clocks_by(uint64_t cycle)
+{
+    auto dot      = cycle * emulator::ppu_dots_per_cpu_cycle;
+    auto frame    = dot / emulator::ppu_dots_per_frame;
+    auto in_frame = dot % emulator::ppu_dots_per_frame;
+
+    uint64_t clocks = 0;
+
+    if (in_frame >= pre_render_scanline * dots_per_scanline + counter_dot)
+    {
+        clocks = clocks_per_frame;
+    }
+    else if (in_frame >= counter_dot)
+    {
+        clocks = std::min<uint64_t>((in_frame - counter_dot) / dots_per_scanline + 1, counted_visible_lines);
+    }
+
+    return frame * clocks_per_frame + clocks;
+}
+
+// First cycle at or after the clock, counting from 0
+uint64_t clock_cycle(uint64_t clock)
+{
+    auto frame = clock / clocks_per_frame;
+    auto line  = clock % clocks_per_frame;
+
+    if (line == counted_visible_lines)
+    {
+        line = pre_render_scanline;
+    }
+
+    auto dot = frame * emulator::ppu_dots_per_frame + line * dots_per_scanline + counter_dot;
+    return (dot + emulator::ppu_dots_per_cpu_cycle - 1) / emulator::ppu_dots_per_cpu_cycle;
+}
+}
+
+/*
+ * NROM
+ */
+void emulator::NROM::reset()
+{
+    map_cartridge_space();
+    map_prg(0x8000, 32 * kilobyte, 0);
+    map_chr(0x0000, 8 * kilobyte, 0);
+}
+
+void emulator::NROM::write(uint16_t /*address*/, uint8_t /*value*/)
+{
+}
+
+/*
+ * MMC1
+ *
+ * Writes shift bit 0 into a 5 bit register, the fifth write copies it into
+ * the register picked by bits 13 and 14 of that write's address. A write
+ * with bit 7 set resets the shift register instead.
+ *
+ * 0x8000 Control  : CPPMM : C CHR mode (0: 8KB, 1: 4KB)
+ *                           P PRG mode (0/1: 32KB, 2: fix first, 3: fix last)
+ *                           M Mirroring (0: one low, 1: one high, 2: vertical, 3: horizontal)
+ * 0xA000 CHR 0    : 4KB bank at 0x0000, or 8KB with the low bit ignored
+ * 0xC000 CHR 1    : 4KB bank at 0x1000
+ * 0xE000 PRG      : 16KB bank, or 32KB with the low bit ignored
+ */
+void emulator::MMC1::reset()
+{
+    shift       = 0;
+    shift_count = 0;
+    control     = 0x0C;
+    chr_bank_0  = 0;
+    chr_bank_1  = 0;
+    prg_bank    = 0;
+
+    map_cartridge_space();
+    update_banks();
+}
+
+void emulator::MMC1::write(uint16_t address, uint8_t value)
+{
+    if (address < 0x8000)
+    {
+        return;
+    }
+
+    if (value & 0x80)
+    {
+        shift       = 0;
+        shift_count = 0;
+        control    |= 0x0C;
+        update_banks();
+        return;
+    }
+
+    shift |= (value & 0x01) << shift_count;
+
+    if (++shift_count == 5)
+    {
+        write_register(address, shift);
+        shift       = 0;
+        shift_count = 0;
+    }
+}
+
+void emulator::MMC1::write_register(uint16_t address, uint8_t value)
+{
+    switch (address & 0x6000)
+    {
+        case 0x0000:
+            control = value;
+            break;
+        case 0x2000:
+            chr_bank_0 = value;
+            break;
+        case 0x4000:
+            chr_bank_1 = value;
+            break;
+        case 0x6000:
+            prg_bank = value & 0x0F;
+            break;
+    }
+
+    update_banks();
+}
+
+void emulator::MMC1::save(SaveState& state) const
+{
+    Mapper::save(state);
+
+    state.write(shift);
+    state.write(shift_count);
+    state.write(control);
+    state.write(chr_bank_0);
+    state.write(chr_bank_1);
+    state.write(prg_bank);
+}
+
+void emulator::MMC1::load(SaveState& state)
+{
+    Mapper::load(state);
+
+    state.read(shift);
+    state.read(shift_count);
+    state.read(control);
+    state.read(chr_bank_0);
+    state.read(chr_bank_1);
+    state.read(prg_bank);
+
+    update_banks();
+}
+
+void emulator::MMC1::update_banks()
+{
+    static Mirroring const mirroring[] = {
+        Mirroring::single_screen_low,
+        Mirroring::single_screen_high,
+        Mirroring::vertical,
+        Mirroring::horizontal
+    };
+
+    set_mirroring(mirroring[control & 0x03]);
+
+    switch (control >> 2 & 0x03)
+    {
+        case 0:
+        case 1:
+            map_prg(0x8000, 32 * kilobyte, prg_bank >> 1);
+            break;
+        case 2:
+            map_prg(0x8000, 16 * kilobyte, 0);
+            map_prg(0xC000, 16 * kilobyte, prg_bank);
+            break;
+        case 3:
+            map_prg(0x8000, 16 * kilobyte, prg_bank);
+            map_prg(0xC000, 16 * kilobyte, prg_banks(16 * kilobyte) - 1);
+            break;
+    }
+
+    if (control & 0x10)
+    {
+        map_chr(0x0000, 4 * kilobyte, chr_bank_0);
+        map_chr(0x1000, 4 * kilobyte, chr_bank_1);
+    }
+    else
+    {
+        map_chr(0x0000, 8 * kilobyte, chr_bank_0 >> 1);
+    }
+}
+
+/*
+ * UxROM
+ *
+ * Any write to 0x8000 - 0xFFFF picks the 16KB bank at 0x8000
+ */
+void emulator::UxROM::reset()
+{
+    prg_bank = 0;
+
+    map_cartridge_space();
+    map_prg(0x8000, 16 * kilobyte, prg_bank);
+    map_prg(0xC000, 16 * kilobyte, prg_banks(16 * kilobyte) - 1);
+    map_chr(0x0000, 8 * kilobyte, 0);
+}
+
+void emulator::UxROM::write(uint16_t address, uint8_t value)
+{
+    if (address >= 0x8000)
+    {
+        prg_bank = value;
+        map_prg(0x8000, 16 * kilobyte, prg_bank);
+    }
+}
+
+void emulator::UxROM::save(SaveState& state) const
+{
+    Mapper::save(state);
+    state.write(prg_bank);
+}
+
+void emulator::UxROM::load(SaveState& state)
+{
+    Mapper::load(state);
+    state.read(prg_bank);
+
+    map_prg(0x8000, 16 * kilobyte, prg_bank);
+}
+
+/*
+ * CNROM
+ *
+ * Any write to 0x8000 - 0xFFFF picks the 8KB CHR bank
+ */
+void emulator::CNROM::reset()
+{
+    chr_bank = 0;
+
+    map_cartridge_space();
+    map_prg(0x8000, 32 * kilobyte, 0);
+    map_chr(0x0000, 8 * kilobyte, chr_bank);
+}
+
+void emulator::CNROM::write(uint16_t address, uint8_t value)
+{
+    if (address >= 0x8000)
+    {
+        chr_bank = value;
+        map_chr(0x0000, 8 * kilobyte, chr_bank);
+    }
+}
+
+void emulator::CNROM::save(SaveState& state) const
+{
+    Mapper::save(state);
+    state.write(chr_bank);
+}
+
+void emulator::CNROM::load(SaveState& state)
+{
+    Mapper::load(state);
+    state.read(chr_bank);
+
+    map_chr(0x0000, 8 * kilobyte, chr_bank);
+}
+
+/*
+ * MMC3
+ *
+ * Registers are picked by the address range and whether it is even or odd
+ *
+ * 0x8000 even : Bank select : CP-- -RRR : C CHR A12 inversion, P PRG mode, R register for the next bank data
+ * 0x8000 odd  : Bank data   : R0 - R5 CHR banks, R6 - R7 8KB PRG banks
+ * 0xA000 even : Mirroring   : 0 vertical, 1 horizontal
+ * 0xA000 odd  : PRG RAM protect, ignored
+ * 0xC000 even : IRQ latch
+ * 0xC000 odd  : IRQ reload, the next clock loads the latch into the counter
+ * 0xE000 even : IRQ disable and acknowledge
+ * 0xE000 odd  : IRQ enable
+ *
+ * Each clock reloads the counter if it is 0 or a reload is pending, and
+ * decrements it otherwise. An IRQ is raised whenever a clock leaves it at 0.
+ */
+void emulator::MMC3::reset()
+{
+    bank_select  = 0;
+    banks        = {{0, 2, 4, 5, 6, 7, 0, 1}};
+    irq_latch    = 0;
+    counter      = 0;
+    irq_reload   = false;
+    irq_enabled  = false;
+    rendering    = ppu->rendering_enabled();
+    synced_cycle = now();
+
+    raise_irq(false);
+
+    if (scheduler)
+    {
+        scheduler->set_handler(Event::mapper_irq, [this] (uint64_t when) {
+            sync(when);
+            schedule_irq(when);
+        });
+        scheduler->cancel(Event::mapper_irq);
+    }
+
+    map_cartridge_space();
+    update_prg();
+    update_chr();
+}
+
+void emulator::MMC3::write(uint16_t address, uint8_t value)
+{
+    if (address < 0x8000)
+    {
+        return;
+    }
+
+    bool odd = address & 0x01;
+
+    switch (address & 0xE000)
+    {
+        case 0x8000:
+            if (!odd)
+            {
+                bank_select = value;
+            }
+            else
+            {
+                banks[bank_select & 0x07] = value;
+            }
+
+            update_prg();
+            update_chr();
+            break;
+        case 0xA000:
+            if (!odd && rom->mirroring() != Mirroring::four_screen)
+            {
+                set_mirroring(value & 0x01 ? Mirroring::horizontal : Mirroring::vertical);
+            }
+            break;
+        case 0xC000:
+        case 0xE000:
+        {
+            auto cycle = now();
+            sync(cycle);
+
+            if (address < 0xE000)
+            {
+                if (!odd)
+                {
+                    irq_latch = value;
+                }
+                else
+                {
+                    irq_reload = true;
+                }
+            }
+            else
+            {
+                irq_enabled = odd;
+
+                // Disabling also acknowledges a raised IRQ
+                if (!odd)
+                {
+                    raise_irq(false);
+                }
+            }
+
+            schedule_irq(cycle);
+            break;
+        }
+    }
+}
+
+void emulator::MMC3::rendering_changed(bool rendering)
+{
+    auto cycle = now();
+    sync(cycle);
+
+    this->rendering = rendering;
+    schedule_irq(cycle);
+}
+
+void emulator::MMC3::save(SaveState& state) const
+{
+    Mapper::save(state);
+
+    state.write(bank_select);
+    state.write(banks);
+    state.write(irq_latch);
+    state.write(counter);
+    state.write(irq_reload);
+    state.write(irq_enabled);
+    state.write(irq_raised);
+    state.write(rendering);
+    state.write(synced_cycle);
+}
+
+void emulator::MMC3::load(SaveState& state)
+{
+    Mapper::load(state);
+
+    state.read(bank_select);
+    state.read(banks);
+    state.read(irq_latch);
+    state.read(counter);
+    state.read(irq_reload);
+    state.read(irq_enabled);
+    state.read(irq_raised);
+    state.read(rendering);
+    state.read(synced_cycle);
+
+    // Mirroring is the PPU's to put back, the next IRQ the scheduler's
+    update_prg();
+    update_chr();
+}
+
+uint8_t emulator::MMC3::irq_counter() const
+{
+    return counter;
+}
+
+void emulator::MMC3::sync(uint64_t cycle)
+{
+    if (cycle <= synced_cycle)
+    {
+        return;
+    }
+
+    if (rendering && clock_counter(clocks_by(cycle) - clocks_by(synced_cycle)) && irq_enabled)
+    {
+        raise_irq(true);
+    }
+
+    synced_cycle = cycle;
+}
+
+bool emulator::MMC3::clock_counter(uint64_t clocks)
+{
+    if (!clocks)
+    {
+        return false;
+    }
+
+    if (counter == 0 || irq_reload)
+    {
+        counter    = irq_latch;
+        irq_reload = false;
+    }
+    else
+    {
+        counter--;
+    }
+
+    bool zero = counter == 0;
+
+    if (!--clocks)
+    {
+        return zero;
+    }
+
+    // Down to 0 first, then round from the latch every latch + 1 clocks
+    if (clocks < counter)
+    {
+        counter -= clocks;
+        return zero;
+    }
+
+    clocks -= counter;
+    zero    = zero || counter != 0;
+    counter = 0;
+
+    if (!clocks)
+    {
+        return zero;
+    }
+
+    uint64_t period = irq_latch + 1;
+    uint64_t left   = clocks % period;
+
+    counter = left ? irq_latch - (left - 1) : 0;
+
+    return zero || clocks >= period || irq_latch == 0;
+}
+
+void emulator::MMC3::schedule_irq(uint64_t cycle)
+{
+    if (!scheduler)
+    {
+        return;
+    }
+
+    if (!irq_enabled || !rendering)
+    {
+        scheduler->cancel(Event::mapper_irq);
+        return;
+    }
+
+    // Clocks until one leaves the counter at 0
+    uint64_t clocks = counter == 0 || irq_reload ? irq_latch + 1 : counter;
+
+    scheduler->schedule(Event::mapper_irq, clock_cycle(clocks_by(cycle) + clocks - 1));
+}
+
+void emulator::MMC3::raise_irq(bool raised)
+{
+    if (raised != irq_raised && interrupt_request_handler)
+    {
+        interrupt_request_handler(raised);
+    }
+
+    irq_raised = raised;
+}
+
+void emulator::MMC3::update_prg()
+{
+    uint32_t second_last = prg_banks(8 * kilobyte) - 2;
+
+    // PRG mode swaps R6 and the fixed second last bank
+    map_prg(bank_select & 0x40 ? 0xC000 : 0x8000, 8 * kilobyte, banks[6]);
+    map_prg(0xA000, 8 * kilobyte, banks[7]);
+    map_prg(bank_select & 0x40 ? 0x8000 : 0xC000, 8 * kilobyte, second_last);
+    map_prg(0xE000, 8 * kilobyte, second_last + 1);
+}
+
+void emulator::MMC3::update_chr()
+{
+    // Inversion swaps the 2KB banks at 0x0000 with the 1KB banks at 0x1000
+    uint16_t two_kb = bank_select & 0x80 ? 0x1000 : 0x0000;
+    uint16_t one_kb = two_kb ^ 0x1000;
+
+    map_chr(two_kb,          2 * kilobyte, banks[0] >> 1);
+    map_chr(two_kb + 0x0800, 2 * kilobyte, banks[1] >> 1);
+
+    for (int i = 0; i < 4; i++)
+    {
+        map_chr(one_kb + i * 0x0400, kilobyte, banks[2 + i]);
+    }
+}
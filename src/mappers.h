@@ -0,0 +1,165 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+The supported mappers, by iNES number.
+
+    0 NROM  : 16KB or 32KB PRG, 8KB CHR, no registers
+    1 MMC1  : Serial 5 bit registers, 16KB/32KB PRG, 4KB/8KB CHR, mirroring
+    2 UxROM : 16KB PRG bank at 0x8000, last bank fixed at 0xC000, CHR RAM
+    3 CNROM : 8KB CHR bank
+    4 MMC3  : 8KB PRG, 1KB/2KB CHR, mirroring and a scanline IRQ
+
+*/
+
+#ifndef NES_EMULATOR_MAPPERS_H_
+#define NES_EMULATOR_MAPPERS_H_
+
+#include "mapper.h"
+
+#include <array>
+#include <cstdint>
+
+namespace emulator
+{
+
+class NROM final : public Mapper
+{
+public:
+    using Mapper::Mapper;
+
+    void reset() override;
+    void write(uint16_t address, uint8_t value) override;
+};
+
+class MMC1 final : public Mapper
+{
+public:
+    using Mapper::Mapper;
+
+    void reset() override;
+    void write(uint16_t address, uint8_t value) override;
+
+    void save(SaveState& state) const override;
+    void load(SaveState& state) override;
+
+private:
+    void write_register(uint16_t address, uint8_t value);
+    void update_banks();
+
+    uint8_t shift{0};
+    uint8_t shift_count{0};
+
+    uint8_t control{0x0C};
+    uint8_t chr_bank_0{0};
+    uint8_t chr_bank_1{0};
+    uint8_t prg_bank{0};
+};
+
+class UxROM final : public Mapper
+{
+public:
+    using Mapper::Mapper;
+
+    void reset() override;
+    void write(uint16_t address, uint8_t value) override;
+
+    void save(SaveState& state) const override;
+    void load(SaveState& state) override;
+
+private:
+    uint8_t prg_bank{0};
+};
+
+class CNROM final : public Mapper
+{
+public:
+    using Mapper::Mapper;
+
+    void reset() override;
+    void write(uint16_t address, uint8_t value) override;
+
+    void save(SaveState& state) const override;
+    void load(SaveState& state) override;
+
+private:
+    uint8_t chr_bank{0};
+};
+
+// The scanline counter is clocked once a line while rendering, at the point
+// the PPU's A12 rises for sprite fetches. Rather than watching A12, the clocks
+// are worked out from the master clock: the counter is brought up to date
+// only when its registers are written or rendering is switched on or off,
+// and the cycle it next reaches 0 is posted as Event::mapper_irq.
+class MMC3 final : public Mapper
+{
+public:
+    using Mapper::Mapper;
+
+    void reset() override;
+    void write(uint16_t address, uint8_t value) override;
+
+    void rendering_changed(bool rendering) override;
+
+    void save(SaveState& state) const override;
+    void load(SaveState& state) override;
+
+    uint8_t irq_counter() const;
+
+private:
+    void update_prg();
+    void update_chr();
+
+    // Applies the clocks since the counter was last brought up to date,
+    // raising an IRQ if any of them took it to 0
+    void sync(uint64_t cycle);
+
+    // Returns true if one of the clocks left the counter at 0
+    bool clock_counter(uint64_t clocks);
+
+    void schedule_irq(uint64_t cycle);
+
+    // Holds or lets go of the CPU's IRQ line
+    void raise_irq(bool raised);
+
+    uint8_t bank_select{0};
+
+    // R0 - R7
+    std::array<uint8_t, 8> banks{{0, 2, 4, 5, 6, 7, 0, 1}};
+
+    uint8_t irq_latch{0};
+    uint8_t counter{0};
+    bool irq_reload{false};
+    bool irq_enabled{false};
+    bool irq_raised{false};
+
+    bool rendering{false};
+    uint64_t synced_cycle{0};
+};
+
+}
+
+#endif /* NES_EMULATOR_MAPPERS_H_ */
@@ -45,6 +45,9 @@ public:
     void write8 (uint16_t address, uint8_t value);
     void write16(uint16_t address, uint16_t value);
 
+    uint8_t* data();
+    uint8_t const* data() const;
+
 private:
     std::array<uint8_t, Size> memory;
 };
@@ -83,6 +86,18 @@ void Memory<Size>::write16(uint16_t address, uint16_t value)
     write8(address + 1, value >> 8 & 0xFF);
 }
 
+template <uint64_t Size>
+uint8_t* Memory<Size>::data()
+{
+    return memory.data();
+}
+
+template <uint64_t Size>
+uint8_t const* Memory<Size>::data() const
+{
+    return memory.data();
+}
+
 }
 
 #endif /* NES_EMULATOR_MEMORY_H_ */
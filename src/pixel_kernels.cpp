@@ -0,0 +1,330 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pixel_kernels.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define NES_EMULATOR_PIXEL_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+#include <stdexcept>
+
+namespace
+{
+void decode_tile_scalar(uint8_t const* planes, uint8_t* pixels)
+{
+    for (int row = 0; row < 8; row++)
+    {
+        uint8_t low  = planes[row];
+        uint8_t high = planes[row + 8];
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            *pixels++ = (low >> (7 - bit) & 0x01) | (high >> (7 - bit) & 0x01) << 1;
+        }
+    }
+}
+
+bool compose_line_scalar(uint8_t const* background, uint8_t const* sprites,
+                         uint8_t const* palette, uint32_t const* colors,
+                         uint8_t* out, uint32_t* rgba, size_t count)
+{
+    bool sprite_zero_hit = false;
+
+    for (size_t x = 0; x < count; x++)
+    {
+        uint8_t back   = background[x];
+        uint8_t sprite = sprites[x];
+        uint8_t entry  = back;
+
+        if (sprite & 0x03)
+        {
+            if ((back & 0x03) && (sprite & emulator::sprite_zero))
+            {
+                sprite_zero_hit = true;
+            }
+
+            if (!(back & 0x03) || !(sprite & emulator::sprite_behind))
+            {
+                entry = 0x10 | (sprite & 0x0F);
+            }
+        }
+
+        auto color = palette[entry & 0x1F];
+        out[x]  = color;
+        rgba[x] = colors[color];
+    }
+
+    return sprite_zero_hit;
+}
+
+#ifdef NES_EMULATOR_PIXEL_KERNELS_X86
+
+// Pixel values for 16 plane bytes that each hold the same row byte 8 times
+__attribute__((target("sse2")))
+__m128i pixels_sse2(__m128i low, __m128i high)
+{
+    // Leftmost pixel is the highest bit
+    auto bits = _mm_set1_epi64x(0x0102040810204080);
+
+    auto low_set  = _mm_cmpeq_epi8(_mm_and_si128(low, bits), bits);
+    auto high_set = _mm_cmpeq_epi8(_mm_and_si128(high, bits), bits);
+
+    return _mm_or_si128(_mm_and_si128(low_set,  _mm_set1_epi8(1)),
+                        _mm_and_si128(high_set, _mm_set1_epi8(2)));
+}
+
+__attribute__((target("sse2")))
+void decode_tile_sse2(uint8_t const* planes, uint8_t* pixels)
+{
+    auto low  = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(planes));
+    auto high = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(planes + 8));
+
+    // Repeat every row byte 8 times, two rows per register
+    low  = _mm_unpacklo_epi8(low, low);
+    high = _mm_unpacklo_epi8(high, high);
+
+    __m128i low_rows[2]  = {_mm_unpacklo_epi16(low, low),   _mm_unpackhi_epi16(low, low)};
+    __m128i high_rows[2] = {_mm_unpacklo_epi16(high, high), _mm_unpackhi_epi16(high, high)};
+
+    auto* out = reinterpret_cast<__m128i*>(pixels);
+    for (int i = 0; i < 2; i++)
+    {
+        _mm_storeu_si128(out++, pixels_sse2(_mm_unpacklo_epi32(low_rows[i], low_rows[i]),
+                                            _mm_unpacklo_epi32(high_rows[i], high_rows[i])));
+        _mm_storeu_si128(out++, pixels_sse2(_mm_unpackhi_epi32(low_rows[i], low_rows[i]),
+                                            _mm_unpackhi_epi32(high_rows[i], high_rows[i])));
+    }
+}
+
+// 0xFF where the pixel uses the sprite's palette entry, also ORs the
+// sprite 0 hits into hits
+__attribute__((target("sse2")))
+__m128i sprite_wins_sse2(__m128i back, __m128i sprite, __m128i& hits)
+{
+    auto zero  = _mm_setzero_si128();
+    auto three = _mm_set1_epi8(0x03);
+
+    auto back_clear   = _mm_cmpeq_epi8(_mm_and_si128(back, three), zero);
+    auto sprite_clear = _mm_cmpeq_epi8(_mm_and_si128(sprite, three), zero);
+    auto behind = _mm_cmpeq_epi8(_mm_and_si128(sprite, _mm_set1_epi8(emulator::sprite_behind)), zero);
+    auto first  = _mm_cmpeq_epi8(_mm_and_si128(sprite, _mm_set1_epi8(emulator::sprite_zero)), zero);
+
+    // behind and first are inverted, 0xFF when the bit is clear
+    hits = _mm_or_si128(hits, _mm_andnot_si128(_mm_or_si128(_mm_or_si128(back_clear, sprite_clear), first),
+                                               _mm_set1_epi8(-1)));
+
+    return _mm_andnot_si128(sprite_clear, _mm_or_si128(back_clear, behind));
+}
+
+__attribute__((target("sse2")))
+bool compose_line_sse2(uint8_t const* background, uint8_t const* sprites,
+                       uint8_t const* palette, uint32_t const* colors,
+                       uint8_t* out, uint32_t* rgba, size_t count)
+{
+    auto hits = _mm_setzero_si128();
+
+    // SSE2 has no byte shuffle, the priority is done 16 pixels at a time and
+    // the palette lookups one by one
+    for (size_t x = 0; x < count; x += 16)
+    {
+        auto back   = _mm_loadu_si128(reinterpret_cast<__m128i const*>(background + x));
+        auto sprite = _mm_loadu_si128(reinterpret_cast<__m128i const*>(sprites + x));
+
+        auto sprite_entry = _mm_or_si128(_mm_and_si128(sprite, _mm_set1_epi8(0x0F)), _mm_set1_epi8(0x10));
+        auto wins  = sprite_wins_sse2(back, sprite, hits);
+        auto entry = _mm_or_si128(_mm_and_si128(wins, sprite_entry), _mm_andnot_si128(wins, back));
+
+        alignas(16) uint8_t entries[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(entries), _mm_and_si128(entry, _mm_set1_epi8(0x1F)));
+
+        for (size_t i = 0; i < 16; i++)
+        {
+            auto color = palette[entries[i]];
+            out[x + i]  = color;
+            rgba[x + i] = colors[color];
+        }
+    }
+
+    return _mm_movemask_epi8(hits) != 0;
+}
+
+__attribute__((target("avx2")))
+__m256i pixels_avx2(__m256i low, __m256i high)
+{
+    auto bits = _mm256_set1_epi64x(0x0102040810204080);
+
+    auto low_set  = _mm256_cmpeq_epi8(_mm256_and_si256(low, bits), bits);
+    auto high_set = _mm256_cmpeq_epi8(_mm256_and_si256(high, bits), bits);
+
+    return _mm256_or_si256(_mm256_and_si256(low_set,  _mm256_set1_epi8(1)),
+                           _mm256_and_si256(high_set, _mm256_set1_epi8(2)));
+}
+
+__attribute__((target("avx2")))
+void decode_tile_avx2(uint8_t const* planes, uint8_t* pixels)
+{
+    // Both planes in each 128 bit lane, low rows 0 - 7 then high rows 0 - 7
+    auto both = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const*>(planes)));
+
+    // Repeat rows 0 and 1 in the first lane and 2 and 3 in the second, then
+    // the same from the high plane
+    auto rows_low  = _mm256_set_epi64x(0x0303030303030303, 0x0202020202020202,
+                                       0x0101010101010101, 0x0000000000000000);
+    auto high_rows = _mm256_set1_epi8(8);
+    auto next_rows = _mm256_set1_epi8(4);
+
+    auto* out = reinterpret_cast<__m256i*>(pixels);
+    for (int i = 0; i < 2; i++)
+    {
+        auto low  = _mm256_shuffle_epi8(both, rows_low);
+        auto high = _mm256_shuffle_epi8(both, _mm256_add_epi8(rows_low, high_rows));
+
+        _mm256_storeu_si256(out++, pixels_avx2(low, high));
+
+        rows_low = _mm256_add_epi8(rows_low, next_rows);
+    }
+}
+
+__attribute__((target("avx2")))
+bool compose_line_avx2(uint8_t const* background, uint8_t const* sprites,
+                       uint8_t const* palette, uint32_t const* colors,
+                       uint8_t* out, uint32_t* rgba, size_t count)
+{
+    auto zero  = _mm256_setzero_si256();
+    auto three = _mm256_set1_epi8(0x03);
+    auto hits  = zero;
+
+    // The 32 entries as two 16 byte shuffle tables
+    auto background_palette = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const*>(palette)));
+    auto sprite_palette = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const*>(palette + 16)));
+
+    for (size_t x = 0; x < count; x += 32)
+    {
+        auto back   = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(background + x));
+        auto sprite = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(sprites + x));
+
+        auto back_clear   = _mm256_cmpeq_epi8(_mm256_and_si256(back, three), zero);
+        auto sprite_clear = _mm256_cmpeq_epi8(_mm256_and_si256(sprite, three), zero);
+        auto behind = _mm256_cmpeq_epi8(_mm256_and_si256(sprite, _mm256_set1_epi8(emulator::sprite_behind)), zero);
+        auto first  = _mm256_cmpeq_epi8(_mm256_and_si256(sprite, _mm256_set1_epi8(emulator::sprite_zero)), zero);
+
+        // behind and first are inverted, 0xFF when the bit is clear
+        hits = _mm256_or_si256(hits, _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(back_clear, sprite_clear), first),
+                                                         _mm256_set1_epi8(-1)));
+
+        auto wins = _mm256_andnot_si256(sprite_clear, _mm256_or_si256(back_clear, behind));
+
+        auto sprite_index = _mm256_and_si256(sprite, _mm256_set1_epi8(0x0F));
+        auto back_index   = _mm256_and_si256(back, _mm256_set1_epi8(0x0F));
+
+        auto color = _mm256_blendv_epi8(_mm256_shuffle_epi8(background_palette, back_index),
+                                        _mm256_shuffle_epi8(sprite_palette, sprite_index), wins);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), color);
+
+        // Widen 8 colors at a time and gather their RGBA values
+        alignas(32) uint8_t indices[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(indices), color);
+
+        for (size_t i = 0; i < 32; i += 8)
+        {
+            auto wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(indices + i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + x + i),
+                                _mm256_i32gather_epi32(reinterpret_cast<int const*>(colors), wide, 4));
+        }
+    }
+
+    return _mm256_movemask_epi8(hits) != 0;
+}
+
+#endif
+
+emulator::PixelKernels const scalar_kernels{decode_tile_scalar, compose_line_scalar};
+
+#ifdef NES_EMULATOR_PIXEL_KERNELS_X86
+emulator::PixelKernels const sse2_kernels{decode_tile_sse2, compose_line_sse2};
+emulator::PixelKernels const avx2_kernels{decode_tile_avx2, compose_line_avx2};
+#endif
+}
+
+bool emulator::is_supported(SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::scalar:
+            return true;
+#ifdef NES_EMULATOR_PIXEL_KERNELS_X86
+        case SimdLevel::sse2:
+            return __builtin_cpu_supports("sse2");
+        case SimdLevel::avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+emulator::SimdLevel emulator::best_simd_level()
+{
+    if (is_supported(SimdLevel::avx2))
+    {
+        return SimdLevel::avx2;
+    }
+
+    if (is_supported(SimdLevel::sse2))
+    {
+        return SimdLevel::sse2;
+    }
+
+    return SimdLevel::scalar;
+}
+
+emulator::PixelKernels const& emulator::pixel_kernels(SimdLevel level)
+{
+    if (!is_supported(level))
+    {
+        throw std::runtime_error("Pixel kernels not supported on this CPU");
+    }
+
+    switch (level)
+    {
+#ifdef NES_EMULATOR_PIXEL_KERNELS_X86
+        case SimdLevel::avx2:
+            return avx2_kernels;
+        case SimdLevel::sse2:
+            return sse2_kernels;
+#endif
+        default:
+            return scalar_kernels;
+    }
+}
+
+emulator::PixelKernels const& emulator::pixel_kernels()
+{
+    static PixelKernels const& best = pixel_kernels(best_simd_level());
+    return best;
+}
@@ -0,0 +1,87 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Data parallel pixel kernels for the PPU.
+
+decode_tile turns a tile's two bit planes into 64 pixel values, and
+compose_line merges the background and sprite line buffers by priority and
+looks the result up in the palette and the RGBA colors.
+
+Each kernel has a scalar version plus SSE2 and AVX2 versions on x86. The
+best one the host supports is picked once through CPUID, the others stay
+reachable so they can be checked against the scalar path and timed.
+
+*/
+
+#ifndef NES_EMULATOR_PIXEL_KERNELS_H_
+#define NES_EMULATOR_PIXEL_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace emulator
+{
+
+// Line buffer pixels are palette << 2 | pixel with 0 transparent, sprite
+// pixels also carry these
+uint8_t const sprite_behind{1 << 5};
+uint8_t const sprite_zero{1 << 6};
+
+enum class SimdLevel
+{
+    scalar,
+    sse2,
+    avx2
+};
+
+struct PixelKernels
+{
+    // 16 plane bytes in, 64 pixels (0 - 3) out, row by row left to right
+    void (*decode_tile)(uint8_t const* planes, uint8_t* pixels);
+
+    // palette is the 32 palette RAM entries as color indices, colors the 64
+    // RGBA colors. count has to be a multiple of 32. Returns true if an
+    // opaque sprite 0 pixel landed on an opaque background pixel.
+    bool (*compose_line)(uint8_t const* background, uint8_t const* sprites,
+                         uint8_t const* palette, uint32_t const* colors,
+                         uint8_t* out, uint32_t* rgba, size_t count);
+};
+
+bool is_supported(SimdLevel level);
+
+// Highest level the host supports
+SimdLevel best_simd_level();
+
+// Throws if the host doesn't support level
+PixelKernels const& pixel_kernels(SimdLevel level);
+
+// Kernels for best_simd_level()
+PixelKernels const& pixel_kernels();
+
+}
+
+#endif /* NES_EMULATOR_PIXEL_KERNELS_H_ */
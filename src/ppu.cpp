@@ -26,9 +26,9 @@
 /*
 
 240 lines of pixels
-10kb of memory
-  8kb ROM
-  2kb RAM
+8kb of pattern tables, CHR ROM or RAM on the cartridge
+2kb of nametable RAM
+32b of palette RAM
 
 Registers:
 
@@ -88,43 +88,220 @@ OAMDMA 0x4014 write
 
 #include "ppu.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace
 {
+uint32_t const dots_per_scanline{341};
+uint16_t const scanlines_per_frame{262};
+uint16_t const vblank_scanline{241};
+uint16_t const pre_render_scanline{261};
+
+// Vblank starts on the second dot of scanline 241
+uint32_t const vblank_dot{vblank_scanline * dots_per_scanline + 1};
+
+// 2C02 colors as 0xRRGGBB
+std::array<uint32_t, 64> const nes_colors{{
+    0x545454, 0x001E74, 0x081090, 0x300088, 0x440064, 0x5C0030, 0x540400, 0x3C1800,
+    0x202A00, 0x083A00, 0x004000, 0x003C00, 0x00323C, 0x000000, 0x000000, 0x000000,
+    0x989698, 0x084CC4, 0x3032EC, 0x5C1EE4, 0x8814B0, 0xA01464, 0x982220, 0x783C00,
+    0x545A00, 0x287200, 0x087C00, 0x007628, 0x006678, 0x000000, 0x000000, 0x000000,
+    0xECEEEC, 0x4C9AEC, 0x787CEC, 0xB062EC, 0xE454EC, 0xEC58B4, 0xEC6A64, 0xD48820,
+    0xA0AA00, 0x74C400, 0x4CD020, 0x38CC6C, 0x38B4CC, 0x3C3C3C, 0x000000, 0x000000,
+    0xECEEEC, 0xA8CCEC, 0xBCBCEC, 0xD4B2EC, 0xECAEEC, 0xECAED4, 0xECB4B0, 0xE4C490,
+    0xCCD278, 0xB4DE78, 0xA8E290, 0x98E2B4, 0xA0D6E4, 0xA0A2A0, 0x000000, 0x000000
+}};
+
+using RgbaPalette = std::array<uint32_t, 64>;
+
+// One RGBA palette per combination of the PPUMASK emphasis bits, emphasis
+// darkens the other two channels
+std::array<RgbaPalette, 8> make_rgba_palettes()
+{
+    std::array<RgbaPalette, 8> palettes;
+
+    for (uint32_t emphasis = 0; emphasis < palettes.size(); emphasis++)
+    {
+        for (size_t color = 0; color < nes_colors.size(); color++)
+        {
+            uint32_t rgba = 0xFF;
+
+            for (uint32_t channel = 0; channel < 3; channel++)
+            {
+                // Red is the highest byte, and the lowest emphasis bit
+                auto value = nes_colors[color] >> (16 - channel * 8) & 0xFF;
+                if (emphasis && !(emphasis & 1 << channel))
+                {
+                    value = value * 3 / 4;
+                }
+
+                rgba |= value << (24 - channel * 8);
+            }
+
+            palettes[emphasis][color] = rgba;
+        }
+    }
+
+    return palettes;
+}
+
+std::array<RgbaPalette, 8> const rgba_palettes{make_rgba_palettes()};
+
+// 0x3F10, 0x3F14, 0x3F18 and 0x3F1C share the background entries
+uint8_t palette_index(uint16_t address)
+{
+    address &= 0x1F;
+    if ((address & 0x13) == 0x10)
+    {
+        address &= 0x0F;
+    }
+
+    return address;
+}
+
+// Nametable slot for 0x2000, 0x2400, 0x2800 and 0x2C00
+std::array<std::array<uint8_t, 4>, 5> const mirroring_slots{{
+    {{0, 0, 1, 1}},
+    {{0, 1, 0, 1}},
+    {{0, 0, 0, 0}},
+    {{1, 1, 1, 1}},
+    {{0, 1, 2, 3}}
+}};
+
 uint8_t get_flag_value(uint8_t flag, uint8_t bits)
 {
     return flag & bits;
 }
+
+// First CPU cycle at or after the frame's vblank dot
+uint64_t vblank_cycle(uint64_t frame)
+{
+    auto dot = frame * emulator::ppu_dots_per_frame + vblank_dot;
+    return (dot + emulator::ppu_dots_per_cpu_cycle - 1) / emulator::ppu_dots_per_cpu_cycle;
+}
 }
 
-void emulator::PPU::set_non_maskable_interrupt_handler(std::function<void()> const& nmi_handler_func)
+emulator::PPU::PPU()
 {
-    non_maskable_interrupt_handler = nmi_handler_func;
+    for (uint8_t bank = 0; bank < number_of_pattern_banks; bank++)
+    {
+        map_pattern_ram(bank, chr_ram.data() + bank * pattern_bank_size);
+    }
+
+    set_mirroring(Mirroring::horizontal);
 }
 
-void emulator::PPU::write_register(uint16_t address, uint8_t value)
+void emulator::PPU::set_mirroring(Mirroring mirroring)
 {
-    last_written_value = value;
-    switch (address)
+    sync();
+
+    auto const& slots = mirroring_slots[static_cast<size_t>(mirroring)];
+    for (size_t i = 0; i < nametables.size(); i++)
     {
-        case 0x2000:
-            write_ctrl(value);
-            break;
-        default:
-            throw std::runtime_error("Invalid ppu address " +
-                std::to_string(address) + " of value " +
-                std::to_string(value));
+        nametables[i] = nametable_ram[slots[i]].data();
     }
 }
 
-uint8_t emulator::PPU::read_register(uint16_t address) const
+void emulator::PPU::set_pattern_rom(uint8_t const* chr, uint32_t size, std::shared_ptr<DecodedChr const> tiles)
+{
+    sync();
+
+    this->tiles.set_rom(chr, size, std::move(tiles));
+}
+
+void emulator::PPU::map_pattern_bank(uint8_t bank, uint8_t const* data)
 {
-    switch (address)
+    if (pattern_banks[bank] == data && !pattern_ram_banks[bank])
     {
-        case 0x2002:
-            return read_status();
-        default:
-            throw std::runtime_error("Invalid ppu address ");
+        return;
+    }
+
+    sync();
+
+    pattern_banks[bank]     = data;
+    pattern_ram_banks[bank] = nullptr;
+    tiles.remap_bank(bank);
+}
+
+void emulator::PPU::map_pattern_ram(uint8_t bank, uint8_t* data)
+{
+    if (pattern_ram_banks[bank] == data)
+    {
+        return;
     }
+
+    sync();
+
+    pattern_banks[bank]     = data;
+    pattern_ram_banks[bank] = data;
+    tiles.remap_bank(bank);
+}
+
+void emulator::PPU::set_non_maskable_interrupt_handler(std::function<void()> const& nmi_handler_func)
+{
+    non_maskable_interrupt_handler = nmi_handler_func;
+}
+
+void emulator::PPU::set_rendering_handler(std::function<void(bool rendering)> const& rendering_handler)
+{
+    this->rendering_handler = rendering_handler;
+}
+
+std::array<emulator::PPU::RegisterRead, 8> const emulator::PPU::register_reads{{
+    &PPU::read_open_bus,    // 0x2000 PPUCTRL
+    &PPU::read_open_bus,    // 0x2001 PPUMASK
+    &PPU::read_status,      // 0x2002 PPUSTATUS
+    &PPU::read_open_bus,    // 0x2003 OAMADDR
+    &PPU::read_oam_data,    // 0x2004 OAMDATA
+    &PPU::read_open_bus,    // 0x2005 PPUSCROLL
+    &PPU::read_open_bus,    // 0x2006 PPUADDR
+    &PPU::read_data         // 0x2007 PPUDATA
+}};
+
+std::array<emulator::PPU::RegisterWrite, 8> const emulator::PPU::register_writes{{
+    &PPU::write_ctrl,
+    &PPU::write_mask,
+    &PPU::write_read_only,
+    &PPU::write_oam_address,
+    &PPU::write_oam_data,
+    &PPU::write_scroll,
+    &PPU::write_address,
+    &PPU::write_data
+}};
+
+void emulator::PPU::write_register(uint16_t address, uint8_t value)
+{
+    sync();
+
+    last_written_value = value;
+    (this->*register_writes[address & 0x07])(value);
+}
+
+uint8_t emulator::PPU::read_register(uint16_t address)
+{
+    sync();
+
+    return (this->*register_reads[address & 0x07])();
+}
+
+uint8_t emulator::PPU::read(uint16_t address)
+{
+    return read_register(address);
+}
+
+void emulator::PPU::write(uint16_t address, uint8_t value)
+{
+    write_register(address, value);
+}
+
+uint8_t emulator::PPU::read_open_bus()
+{
+    return last_written_value;
+}
+
+void emulator::PPU::write_read_only(uint8_t /*value*/)
+{
 }
 
 /*
@@ -140,7 +317,24 @@ uint8_t emulator::PPU::read_register(uint16_t address) const
  */
 void emulator::PPU::write_ctrl(uint8_t value)
 {
+    auto nmi_was_enabled = nmi_on_vblank();
+
+    if ((control_flags ^ value) & ControlFlag::sprite_size)
+    {
+        sprite_lines_dirty = true;
+    }
+
     control_flags = value;
+
+    // Base nametable goes into the scroll
+    temp_vram = (temp_vram & ~0x0C00) | (value & ControlFlag::nametable) << 10;
+
+    // Turning the NMI on during vblank fires it straight away
+    if (!nmi_was_enabled && nmi_on_vblank() && vblank_started &&
+        non_maskable_interrupt_handler)
+    {
+        non_maskable_interrupt_handler();
+    }
 }
 
 uint8_t emulator::PPU::nametable() const
@@ -193,7 +387,14 @@ uint8_t emulator::PPU::nmi_on_vblank() const
  */
 void emulator::PPU::write_mask(uint8_t value)
 {
+    bool was_rendering = rendering_enabled();
+
     mask_flags = value;
+
+    if (rendering_handler && was_rendering != static_cast<bool>(rendering_enabled()))
+    {
+        rendering_handler(!was_rendering);
+    }
 }
 
 uint8_t emulator::PPU::greyscale() const
@@ -203,37 +404,37 @@ uint8_t emulator::PPU::greyscale() const
 
 uint8_t emulator::PPU::show_left_background() const
 {
-    return get_flag_value(control_flags, MaskFlag::show_left_background);
+    return get_flag_value(mask_flags, MaskFlag::show_left_background);
 }
 
 uint8_t emulator::PPU::show_left_sprite() const
 {
-    return get_flag_value(control_flags, MaskFlag::show_left_sprite);
+    return get_flag_value(mask_flags, MaskFlag::show_left_sprite);
 }
 
 uint8_t emulator::PPU::show_background() const
 {
-    return get_flag_value(control_flags, MaskFlag::show_background);
+    return get_flag_value(mask_flags, MaskFlag::show_background);
 }
 
 uint8_t emulator::PPU::show_sprite() const
 {
-    return get_flag_value(control_flags, MaskFlag::show_sprite);
+    return get_flag_value(mask_flags, MaskFlag::show_sprite);
 }
 
 uint8_t emulator::PPU::emphasize_red() const
 {
-    return get_flag_value(control_flags, MaskFlag::emphasize_red);
+    return get_flag_value(mask_flags, MaskFlag::emphasize_red);
 }
 
 uint8_t emulator::PPU::emphasize_green() const
 {
-    return get_flag_value(control_flags, MaskFlag::emphasize_green);
+    return get_flag_value(mask_flags, MaskFlag::emphasize_green);
 }
 
 uint8_t emulator::PPU::emphasize_blue() const
 {
-    return get_flag_value(control_flags, MaskFlag::emphasize_blue);
+    return get_flag_value(mask_flags, MaskFlag::emphasize_blue);
 }
 
 /*
@@ -247,26 +448,610 @@ uint8_t emulator::PPU::emphasize_blue() const
  * 1 - |
  * 0 - |
  */
-uint8_t emulator::PPU::read_status() const
+uint8_t emulator::PPU::read_status()
 {
     uint8_t status;
 
     // Least sig bits of last written value into the ppu
     status = last_written_value & 0x1F;
 
-    // TODO
-    //status |= overflow << 5;
-    //status |= zero_hit << 6;
-    //status |= vblank_started << 7;
+    status |= sprite_overflow << 5;
+    status |= sprite_zero_hit << 6;
+    status |= vblank_started << 7;
+
+    // Reading clears vblank and the PPUSCROLL/PPUADDR write toggle
+    vblank_started = false;
+    write_toggle = 0;
 
     return status;
 }
 
-void emulator::PPU::step()
+/*
+ * OAMADDR 0x2003 write, where OAMDATA and OAM DMA start
+ */
+void emulator::PPU::write_oam_address(uint8_t value)
+{
+    oam_address = value;
+}
+
+/*
+ * OAMDATA 0x2004 read/write, writes move on to the next byte
+ */
+uint8_t emulator::PPU::read_oam_data()
+{
+    return oam.read8(oam_address);
+}
+
+void emulator::PPU::write_oam_data(uint8_t value)
+{
+    write_oam(oam_address++, value);
+}
+
+/*
+ * PPUSCROLL 0x2005 write x2
+ * First write X: coarse X into temp_vram, fine X into fine_x_scroll
+ * Second write Y: coarse and fine Y into temp_vram
+ */
+void emulator::PPU::write_scroll(uint8_t value)
+{
+    if (!write_toggle)
+    {
+        temp_vram = (temp_vram & ~0x001F) | value >> 3;
+        fine_x_scroll = value & 0x07;
+    }
+    else
+    {
+        temp_vram = (temp_vram & ~0x73E0) | (value & 0x07) << 12 | (value >> 3) << 5;
+    }
+
+    write_toggle ^= 1;
+}
+
+/*
+ * PPUADDR 0x2006 write x2
+ * High 6 bits then low 8 bits into temp_vram, the second write copies it
+ * into vram
+ */
+void emulator::PPU::write_address(uint8_t value)
+{
+    if (!write_toggle)
+    {
+        temp_vram = (temp_vram & 0x00FF) | (value & 0x3F) << 8;
+    }
+    else
+    {
+        temp_vram = (temp_vram & 0xFF00) | value;
+        vram = temp_vram;
+    }
+
+    write_toggle ^= 1;
+}
+
+/*
+ * PPUDATA 0x2007 read/write at vram, which then moves on by 1 or 32
+ * Reads below the palette return the buffer and refill it, palette reads
+ * come back straight away and buffer the nametable under them
+ */
+uint8_t emulator::PPU::read_data()
 {
-    // nmi inturrupt
-    if (non_maskable_interrupt_handler)
+    uint8_t value;
+
+    if ((vram & 0x3FFF) < 0x3F00)
+    {
+        value = read_buffer;
+        read_buffer = read_vram(vram);
+    }
+    else
+    {
+        value = read_vram(vram);
+        read_buffer = read_vram(vram - 0x1000);
+    }
+
+    vram = (vram + (increment() ? 32 : 1)) & 0x7FFF;
+
+    return value;
+}
+
+void emulator::PPU::write_data(uint8_t value)
+{
+    write_vram(vram, value);
+    vram = (vram + (increment() ? 32 : 1)) & 0x7FFF;
+}
+
+void emulator::PPU::set_scheduler(Scheduler* scheduler)
+{
+    this->scheduler = scheduler;
+
+    scheduler->set_handler(Event::vblank, [this] (uint64_t when) {
+        enter_vblank(when);
+    });
+
+    scheduler->schedule(Event::vblank, vblank_cycle(frame));
+}
+
+void emulator::PPU::set_clock(std::function<uint64_t()> const& clock)
+{
+    this->clock = clock;
+}
+
+uint64_t emulator::PPU::timestamp() const
+{
+    return timestamp_;
+}
+
+void emulator::PPU::sync()
+{
+    if (clock)
+    {
+        catch_up(clock());
+    }
+}
+
+void emulator::PPU::catch_up(uint64_t cycle)
+{
+    if (cycle <= timestamp_)
+    {
+        return;
+    }
+
+    auto dot = cycle * ppu_dots_per_cpu_cycle;
+
+    while (next_scanline_dot <= dot)
+    {
+        enter_scanline(next_scanline);
+
+        next_scanline_dot += dots_per_scanline;
+        if (++next_scanline == scanlines_per_frame)
+        {
+            next_scanline = 0;
+        }
+    }
+
+    timestamp_ = cycle;
+}
+
+void emulator::PPU::enter_scanline(uint16_t scanline)
+{
+    switch (scanline)
+    {
+        case vblank_scanline:
+            vblank_started = true;
+            break;
+        case pre_render_scanline:
+            vblank_started  = false;
+            sprite_zero_hit = false;
+            sprite_overflow = false;
+
+            // Scroll is reloaded for the next frame
+            if (rendering_enabled())
+            {
+                copy_scroll_x();
+                copy_scroll_y();
+            }
+            break;
+        default:
+            if (scanline < screen_height)
+            {
+                render_scanline(scanline);
+            }
+            break;
+    }
+}
+
+void emulator::PPU::enter_vblank(uint64_t when)
+{
+    catch_up(when);
+
+    if (nmi_on_vblank() && non_maskable_interrupt_handler)
     {
         non_maskable_interrupt_handler();
     }
+
+    scheduler->schedule(Event::vblank, vblank_cycle(++frame));
+}
+
+emulator::FrameBuffer const& emulator::PPU::framebuffer() const
+{
+    return pixels;
+}
+
+emulator::RgbaFrameBuffer const& emulator::PPU::rgba_framebuffer() const
+{
+    return rgba_pixels;
+}
+
+uint8_t emulator::PPU::read_vram(uint16_t address) const
+{
+    address &= 0x3FFF;
+
+    if (address < 0x2000)
+    {
+        return pattern_banks[address >> 10][address & 0x3FF];
+    }
+
+    // 0x3000 - 0x3EFF mirrors the nametables
+    if (address < 0x3F00)
+    {
+        return nametables[address >> 10 & 0x03][address & 0x3FF];
+    }
+
+    return palette_ram[palette_index(address)];
+}
+
+void emulator::PPU::write_vram(uint16_t address, uint8_t value)
+{
+    address &= 0x3FFF;
+
+    if (address < 0x2000)
+    {
+        auto* bank = pattern_ram_banks[address >> 10];
+        if (bank)
+        {
+            bank[address & 0x3FF] = value;
+            tiles.invalidate(address);
+        }
+    }
+    else if (address < 0x3F00)
+    {
+        nametables[address >> 10 & 0x03][address & 0x3FF] = value;
+    }
+    else
+    {
+        palette_ram[palette_index(address)] = value;
+    }
+}
+
+void emulator::PPU::write_oam(uint8_t address, uint8_t value)
+{
+    oam.write8(address, value);
+    sprite_lines_dirty = true;
+}
+
+uint8_t emulator::PPU::read_oam(uint8_t address) const
+{
+    return oam.read8(address);
+}
+
+void emulator::PPU::oam_dma(uint8_t const* data)
+{
+    sync();
+
+    // Starts at OAMADDR and wraps around
+    std::copy(data, data + 256 - oam_address, oam.data() + oam_address);
+    std::copy(data + 256 - oam_address, data + 256, oam.data());
+    sprite_lines_dirty = true;
+}
+
+// Sprites are bucketed into the lines they cover once, rather than every
+// line checking all 64 of them
+void emulator::PPU::build_sprite_lines()
+{
+    for (auto& line : sprite_lines)
+    {
+        line.count    = 0;
+        line.overflow = false;
+    }
+
+    int height = sprite_size() ? 16 : 8;
+
+    for (uint8_t sprite = 0; sprite < 64; sprite++)
+    {
+        // Sprites show up a line below their Y coordinate
+        int first = oam.read8(sprite * 4) + 1;
+        int last  = std::min(first + height, static_cast<int>(screen_height));
+
+        for (int line = first; line < last; line++)
+        {
+            auto& sprite_line = sprite_lines[line];
+            if (sprite_line.count == sprite_line.sprites.size())
+            {
+                sprite_line.overflow = true;
+                continue;
+            }
+
+            sprite_line.sprites[sprite_line.count++] = sprite;
+        }
+    }
+
+    sprite_lines_dirty = false;
+}
+
+uint8_t emulator::PPU::rendering_enabled() const
+{
+    return show_background() | show_sprite();
+}
+
+void emulator::PPU::save(SaveState& state) const
+{
+    state.write(control_flags);
+    state.write(mask_flags);
+    state.write(last_written_value);
+
+    state.write(vram);
+    state.write(temp_vram);
+    state.write(fine_x_scroll);
+    state.write(write_toggle);
+    state.write(oam_address);
+    state.write(read_buffer);
+
+    state.write(vblank_started);
+    state.write(sprite_zero_hit);
+    state.write(sprite_overflow);
+
+    state.write(frame);
+    state.write(timestamp_);
+    state.write(next_scanline);
+    state.write(next_scanline_dot);
+
+    // Mirroring as the slot each nametable points at
+    std::array<uint8_t, 4> slots;
+    for (size_t i = 0; i < nametables.size(); i++)
+    {
+        slots[i] = static_cast<uint8_t>((nametables[i] - nametable_ram[0].data()) / nametable_ram[0].size());
+    }
+
+    state.write(slots);
+    state.write(nametable_ram);
+    state.write(palette_ram);
+    state.write(oam);
+}
+
+void emulator::PPU::load(SaveState& state)
+{
+    state.read(control_flags);
+    state.read(mask_flags);
+    state.read(last_written_value);
+
+    state.read(vram);
+    state.read(temp_vram);
+    state.read(fine_x_scroll);
+    state.read(write_toggle);
+    state.read(oam_address);
+    state.read(read_buffer);
+
+    state.read(vblank_started);
+    state.read(sprite_zero_hit);
+    state.read(sprite_overflow);
+
+    state.read(frame);
+    state.read(timestamp_);
+    state.read(next_scanline);
+    state.read(next_scanline_dot);
+
+    std::array<uint8_t, 4> slots;
+    state.read(slots);
+    for (size_t i = 0; i < nametables.size(); i++)
+    {
+        nametables[i] = nametable_ram[slots[i]].data();
+    }
+
+    state.read(nametable_ram);
+    state.read(palette_ram);
+    state.read(oam);
+
+    sprite_lines_dirty = true;
+
+    // CHR ROM can't have changed, CHR RAM may have
+    for (uint8_t bank = 0; bank < number_of_pattern_banks; bank++)
+    {
+        if (pattern_ram_banks[bank])
+        {
+            tiles.invalidate_bank(bank);
+        }
+    }
+}
+
+/*
+ * Loopy's scroll registers, vram and temp_vram
+ *
+ * yyy NN YYYYY XXXXX
+ * ||| || ||||| +++++-- coarse X scroll
+ * ||| || +++++-------- coarse Y scroll
+ * ||| ++-------------- nametable select
+ * +++----------------- fine Y scroll
+ */
+void emulator::PPU::increment_scroll_y()
+{
+    if ((vram & 0x7000) != 0x7000)
+    {
+        vram += 0x1000;
+        return;
+    }
+
+    vram &= ~0x7000;
+
+    uint16_t coarse_y = (vram & 0x03E0) >> 5;
+    if (coarse_y == 29)
+    {
+        coarse_y = 0;
+        vram ^= 0x0800;
+    }
+    else if (coarse_y == 31)
+    {
+        // Attribute rows wrap without switching nametable
+        coarse_y = 0;
+    }
+    else
+    {
+        coarse_y++;
+    }
+
+    vram = (vram & ~0x03E0) | coarse_y << 5;
+}
+
+void emulator::PPU::copy_scroll_x()
+{
+    vram = (vram & ~0x041F) | (temp_vram & 0x041F);
+}
+
+void emulator::PPU::copy_scroll_y()
+{
+    vram = (vram & ~0x7BE0) | (temp_vram & 0x7BE0);
+}
+
+void emulator::PPU::render_scanline(uint16_t scanline)
+{
+    auto* out  = pixels.data() + scanline * screen_width;
+    auto* rgba = rgba_pixels.data() + scanline * screen_width;
+
+    auto const& colors = rgba_palettes[mask_flags >> 5];
+    uint8_t color_mask = greyscale() ? 0x30 : 0x3F;
+
+    std::array<uint8_t, 32> palette;
+    for (uint16_t i = 0; i < palette.size(); i++)
+    {
+        palette[i] = read_vram(0x3F00 + i) & color_mask;
+    }
+
+    if (!rendering_enabled())
+    {
+        std::fill(out, out + screen_width, palette[0]);
+        std::fill(rgba, rgba + screen_width, colors[palette[0]]);
+        return;
+    }
+
+    std::array<uint8_t, screen_width> background;
+    std::array<uint8_t, screen_width> sprites;
+
+    render_background(background);
+    render_sprites(scanline, sprites);
+
+    if (!show_left_background())
+    {
+        std::fill(background.begin(), background.begin() + 8, 0);
+    }
+
+    if (!show_left_sprite())
+    {
+        std::fill(sprites.begin(), sprites.begin() + 8, 0);
+    }
+
+    // Sprite 0 can't hit on the last pixel
+    sprites[screen_width - 1] &= ~sprite_zero;
+
+    if (compose_line(background.data(), sprites.data(), palette.data(), colors.data(),
+                     out, rgba, screen_width))
+    {
+        sprite_zero_hit = true;
+    }
+
+    increment_scroll_y();
+    copy_scroll_x();
+}
+
+void emulator::PPU::render_background(std::array<uint8_t, screen_width>& line)
+{
+    line.fill(0);
+
+    if (!show_background())
+    {
+        return;
+    }
+
+    uint16_t pattern = background_pattern() ? 0x1000 : 0x0000;
+    uint16_t fine_y  = vram >> 12 & 0x07;
+    uint16_t address = vram;
+
+    // 33 tiles cover the line once fine x scroll pushes the first one left
+    int x = -fine_x_scroll;
+    for (int tile = 0; tile < 33; tile++, x += 8)
+    {
+        uint16_t index = read_vram(0x2000 | (address & 0x0FFF));
+
+        uint16_t attribute_address = 0x23C0 | (address & 0x0C00) |
+                                     (address >> 4 & 0x38) | (address >> 2 & 0x07);
+        uint8_t shift = (address >> 4 & 0x04) | (address & 0x02);
+        uint8_t attribute = (read_vram(attribute_address) >> shift & 0x03) << 2;
+
+        auto const* tile_row = tiles.row(pattern + index * 16 + fine_y);
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            int pixel_x = x + bit;
+            if (pixel_x < 0 || pixel_x >= screen_width)
+            {
+                continue;
+            }
+
+            line[pixel_x] = tile_row[bit] ? attribute | tile_row[bit] : 0;
+        }
+
+        // Coarse x wraps into the next horizontal nametable
+        if ((address & 0x1F) == 31)
+        {
+            address = (address & ~0x1F) ^ 0x0400;
+        }
+        else
+        {
+            address++;
+        }
+    }
+}
+
+void emulator::PPU::render_sprites(uint16_t scanline, std::array<uint8_t, screen_width>& line)
+{
+    line.fill(0);
+
+    if (sprite_lines_dirty)
+    {
+        build_sprite_lines();
+    }
+
+    auto const& sprite_line = sprite_lines[scanline];
+    if (sprite_line.overflow)
+    {
+        sprite_overflow = true;
+    }
+
+    if (!show_sprite())
+    {
+        return;
+    }
+
+    int height = sprite_size() ? 16 : 8;
+
+    for (uint8_t i = 0; i < sprite_line.count; i++)
+    {
+        uint8_t sprite = sprite_line.sprites[i];
+        auto const* entry = oam.data() + sprite * 4;
+
+        int row = scanline - 1 - entry[0];
+
+        uint8_t index     = entry[1];
+        uint8_t attribute = entry[2];
+        uint8_t sprite_x  = entry[3];
+
+        if (attribute & 0x80)
+        {
+            row = height - 1 - row;
+        }
+
+        uint16_t address;
+        if (height == 16)
+        {
+            // 8x16 sprites pick their pattern table with the tile's low bit
+            address = (index & 0x01) << 12 | (index & 0xFE) << 4 | (row & 0x08) << 1 | (row & 0x07);
+        }
+        else
+        {
+            address = (sprite_pattern() ? 0x1000 : 0x0000) | index << 4 | row;
+        }
+
+        auto const* tile_row = tiles.row(address);
+
+        uint8_t extra = (attribute & 0x03) << 2;
+        extra |= attribute & 0x20 ? sprite_behind : 0;
+        extra |= sprite == 0 ? sprite_zero : 0;
+
+        for (int bit = 0; bit < 8 && sprite_x + bit < screen_width; bit++)
+        {
+            uint8_t pixel = tile_row[attribute & 0x40 ? 7 - bit : bit];
+
+            // Lower OAM entries win, even when they are behind the background
+            if (pixel && !line[sprite_x + bit])
+            {
+                line[sprite_x + bit] = extra | pixel;
+            }
+        }
+    }
 }
@@ -28,20 +28,53 @@
 
 The CPU will create this with a list of 8 address pointers
 
+The PPU is not stepped with the CPU. It remembers the master clock cycle it
+has been emulated up to and only catches up, a scanline at a time, when the
+CPU touches one of its registers, when the vblank NMI is due or when the
+frame is finished.
 
+Each visible scanline is rendered whole when the PPU reaches it, background
+and sprites into a 256x240 frame of NES color indices (0 - 63) which is
+also translated to packed RGBA.
 
 */
 
 #ifndef NES_EMULATOR_PPU_H_
 #define NES_EMULATOR_PPU_H_
 
+#include "bus.h"
 #include "memory.h"
+#include "pixel_kernels.h"
+#include "save_state.h"
+#include "scheduler.h"
+#include "tile_cache.h"
 
+#include <array>
 #include <functional>
+#include <memory>
 
 namespace emulator
 {
 
+uint16_t const screen_width{256};
+uint16_t const screen_height{240};
+
+// NES color index (0 - 63) per pixel
+using FrameBuffer = std::array<uint8_t, screen_width * screen_height>;
+
+// 0xRRGGBBAA per pixel
+using RgbaFrameBuffer = std::array<uint32_t, screen_width * screen_height>;
+
+// How the four nametables 0x2000 - 0x2FFF map onto the 1KB slots
+enum class Mirroring : uint8_t
+{
+    horizontal,         // 0x2000 = 0x2400, 0x2800 = 0x2C00
+    vertical,           // 0x2000 = 0x2800, 0x2400 = 0x2C00
+    single_screen_low,  // All four are the first slot
+    single_screen_high, // All four are the second slot
+    four_screen         // The cartridge's extra 2KB fills in the last two
+};
+
 enum ControlFlag : uint8_t
 {
     nametable          = 1 << 0 | 1 << 1, // first two bits
@@ -65,18 +98,98 @@ enum MaskFlag : uint8_t
     emphasize_blue       = 1 << 7
 };
 
-class PPU
+// Sits on the CPU bus over 0x2000 - 0x3FFF, the 8 registers repeat every
+// 8 bytes
+class PPU : public BusDevice
 {
 public:
+    // Starts with 8KB of CHR RAM in the pattern tables and horizontal
+    // mirroring, until a cartridge says otherwise
+    PPU();
+
+    PPU(PPU const&) = delete;
+    PPU& operator=(PPU const&) = delete;
+
+    void set_mirroring(Mirroring mirroring);
+
+    // The cartridge's CHR ROM and its decoded tiles, both empty for CHR RAM
+    // carts and both owned by the Rom. Banks pointed into chr read the
+    // decoded tiles, so they never have to be decoded here.
+    void set_pattern_rom(uint8_t const* chr, uint32_t size, std::shared_ptr<DecodedChr const> tiles);
+
+    // Points 1KB pattern bank 0 - 7 at CHR ROM, writes to it are dropped
+    void map_pattern_bank(uint8_t bank, uint8_t const* data);
+
+    // Points a pattern bank at CHR RAM
+    void map_pattern_ram(uint8_t bank, uint8_t* data);
+
+    // Both catch up to the clock before touching the register
     void write_register(uint16_t address, uint8_t value);
+    uint8_t read_register(uint16_t address);
 
-    uint8_t read_register(uint16_t address) const;
+    uint8_t read(uint16_t address) override;
+    void write(uint16_t address, uint8_t value) override;
 
     void set_non_maskable_interrupt_handler(std::function<void()> const& nmi_handler);
 
-    void step();
+    // Called after a PPUMASK write turns background and sprite rendering both
+    // off or either back on, with the new state
+    void set_rendering_handler(std::function<void(bool rendering)> const& rendering_handler);
+
+    // Posts the start of each vblank, which is when the NMI can fire
+    void set_scheduler(Scheduler* scheduler);
+
+    // Where register accesses get the current master clock cycle from
+    void set_clock(std::function<uint64_t()> const& clock);
+
+    // Runs every scanline that starts before cycle
+    void catch_up(uint64_t cycle);
+
+    // Master clock cycle the PPU has been emulated up to
+    uint64_t timestamp() const;
+
+    // Scanlines rendered so far, the rest still hold the last frame
+    FrameBuffer const& framebuffer() const;
+    RgbaFrameBuffer const& rgba_framebuffer() const;
+
+    // PPU address space, 0x0000 - 0x3FFF with its mirrors
+    uint8_t read_vram(uint16_t address) const;
+    void write_vram(uint16_t address, uint8_t value);
+
+    uint8_t read_oam(uint8_t address) const;
+    void write_oam(uint8_t address, uint8_t value);
+
+    // All 256 bytes of OAM at once
+    void oam_dma(uint8_t const* data);
+
+    // Background or sprites shown
+    uint8_t rendering_enabled() const;
+
+    // Registers, scroll, timing, nametable and palette RAM, OAM and the
+    // mirroring. Pattern banks belong to the mapper and the frame is
+    // redrawn every frame, neither is saved. Load after the mapper so
+    // tiles in CHR RAM are decoded again from what it put back.
+    void save(SaveState& state) const;
+    void load(SaveState& state);
 
 private:
+    void sync();
+    void enter_scanline(uint16_t scanline);
+    void enter_vblank(uint64_t when);
+
+    void render_scanline(uint16_t scanline);
+
+    // Each fills a line with palette << 2 | pixel, 0 is transparent. Sprite
+    // pixels also carry their priority and whether they came from sprite 0.
+    void render_background(std::array<uint8_t, screen_width>& line);
+    void render_sprites(uint16_t scanline, std::array<uint8_t, screen_width>& line);
+
+    void build_sprite_lines();
+
+    void increment_scroll_y();
+    void copy_scroll_x();
+    void copy_scroll_y();
+
     // 0x2000 PPUCTRL
     void write_ctrl(uint8_t value);
 
@@ -84,7 +197,36 @@ private:
     void write_mask(uint8_t value);
 
     // 0x2002 PPUSTATUS
-    uint8_t read_status() const;
+    uint8_t read_status();
+
+    // 0x2003 OAMADDR
+    void write_oam_address(uint8_t value);
+
+    // 0x2004 OAMDATA
+    uint8_t read_oam_data();
+    void write_oam_data(uint8_t value);
+
+    // 0x2005 PPUSCROLL
+    void write_scroll(uint8_t value);
+
+    // 0x2006 PPUADDR
+    void write_address(uint8_t value);
+
+    // 0x2007 PPUDATA
+    uint8_t read_data();
+    void write_data(uint8_t value);
+
+    // Write only registers read back whatever was last on the data bus
+    uint8_t read_open_bus();
+    void write_read_only(uint8_t value);
+
+    using RegisterRead  = uint8_t (PPU::*)();
+    using RegisterWrite = void (PPU::*)(uint8_t value);
+
+    // Indexed by the low 3 bits of the address, so every mirror lands on a
+    // register
+    static std::array<RegisterRead, 8> const register_reads;
+    static std::array<RegisterWrite, 8> const register_writes;
 
     uint8_t nametable() const;
     uint8_t increment() const;
@@ -113,12 +255,65 @@ private:
     uint8_t fine_x_scroll{0};
     uint8_t write_toggle{0};
 
+    uint8_t oam_address{0};
+
+    // PPUDATA reads below the palette come back a read late
+    uint8_t read_buffer{0};
+
+    bool vblank_started{false};
+    bool sprite_zero_hit{false};
+    bool sprite_overflow{false};
+
     std::function<void()> non_maskable_interrupt_handler;
+    std::function<void(bool rendering)> rendering_handler;
+    std::function<uint64_t()> clock;
+
+    Scheduler* scheduler{nullptr};
+    uint64_t frame{0};
+
+    uint64_t timestamp_{0};
+
+    // Scanlines are entered on their second dot, which is when vblank
+    // starts and ends
+    uint16_t next_scanline{0};
+    uint64_t next_scanline_dot{1};
+
+    // The first 8 sprites on each line, in OAM order
+    struct SpriteLine
+    {
+        std::array<uint8_t, 8> sprites;
+        uint8_t count{0};
+        bool overflow{false};
+    };
+
+    std::array<SpriteLine, screen_height> sprite_lines;
+    bool sprite_lines_dirty{true};
 
-    // 10KB of memory
-    Memory<163840> memory;
+    FrameBuffer pixels{};
+    RgbaFrameBuffer rgba_pixels{};
+
+    // 2KB of nametable RAM in the console plus 2KB for four screen carts,
+    // the pointers pick which slot each nametable is
+    std::array<std::array<uint8_t, 0x400>, 4> nametable_ram{};
+    std::array<uint8_t*, 4> nametables;
+
+    std::array<uint8_t, 0x20> palette_ram{};
+
+    // Used when the cartridge has no CHR ROM
+    std::array<uint8_t, 0x2000> chr_ram{};
+
+    // Reads go through pattern_banks, writes through pattern_ram_banks
+    // which is nullptr for ROM
+    PatternBanks pattern_banks{};
+    std::array<uint8_t*, number_of_pattern_banks> pattern_ram_banks{};
     // 256B of Object Attribute Memory
     Memory<256> oam;
+
+    TileCache tiles{pattern_banks};
+
+    bool (*compose_line)(uint8_t const* background, uint8_t const* sprites,
+                         uint8_t const* palette, uint32_t const* colors,
+                         uint8_t* out, uint32_t* rgba, size_t count){pixel_kernels().compose_line};
 };
 
 }
@@ -0,0 +1,68 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Dynamic rate control for audio output.
+
+The emulator makes 60.0988 frames of samples a second by its own clock, the
+sound card takes them at its own, and the two never quite agree. Rather
+than let the ring between them slowly fill up or run dry, the number of
+samples made each frame is nudged up when the ring is under half full and
+down when it is over, by at most max_adjustment either way. Half a percent
+is well under what anyone hears as a pitch change.
+
+    ratio = 1 + max_adjustment * (1 - 2 * fill / capacity)
+
+*/
+
+#ifndef NES_EMULATOR_RATE_CONTROL_H_
+#define NES_EMULATOR_RATE_CONTROL_H_
+
+#include <cstddef>
+
+namespace emulator
+{
+
+double const default_max_rate_adjustment{0.005};
+
+class RateControl
+{
+public:
+    explicit RateControl(double max_adjustment = default_max_rate_adjustment);
+
+    // Output samples to make per sample the emulator would make on its own
+    double update(size_t fill, size_t capacity);
+
+    double ratio() const;
+
+private:
+    double max_adjustment;
+    double ratio_{1.0};
+};
+
+}
+
+#endif /* NES_EMULATOR_RATE_CONTROL_H_ */
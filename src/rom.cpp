@@ -0,0 +1,144 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "rom.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+uint32_t const expected_magic_nes_header{0x1a53454e};
+uint32_t const header_size{0x10};
+uint32_t const trainer_size{0x200};
+uint32_t const prg_unit{16 * 1024};
+uint32_t const chr_unit{8 * 1024};
+}
+
+emulator::Rom::Rom(std::vector<uint8_t> image) :
+    image(std::make_shared<std::vector<uint8_t> const>(std::move(image)))
+{
+    if (this->image->size() < header_size)
+    {
+        throw std::runtime_error("Invalid size, less then the expected header");
+    }
+
+    memcpy(&header_, this->image->data(), sizeof(header_));
+
+    if (header_.nes_magic != expected_magic_nes_header)
+    {
+        throw std::runtime_error("Incorrect file type, expected *.nes");
+    }
+
+    prg_offset = header_size + (trainer() ? trainer_size : 0);
+    prg_size_  = header_.prg_size * prg_unit;
+    chr_offset = prg_offset + prg_size_;
+    chr_size_  = header_.chr_size * chr_unit;
+
+    // TODO extra data like PlayChoice-10 after CHR is ignored
+    if (this->image->size() < chr_offset + chr_size_)
+    {
+        throw std::runtime_error("ROM is shorter than its header says");
+    }
+
+    if (prg_size_ == 0)
+    {
+        throw std::runtime_error("ROM has no PRG");
+    }
+
+    chr_tiles_ = decode_chr(chr(), chr_size_);
+}
+
+emulator::RomHeader const& emulator::Rom::header() const
+{
+    return header_;
+}
+
+uint8_t const* emulator::Rom::prg() const
+{
+    return image->data() + prg_offset;
+}
+
+uint32_t emulator::Rom::prg_size() const
+{
+    return prg_size_;
+}
+
+uint8_t const* emulator::Rom::chr() const
+{
+    return image->data() + chr_offset;
+}
+
+uint32_t emulator::Rom::chr_size() const
+{
+    return chr_size_;
+}
+
+std::shared_ptr<emulator::DecodedChr const> const& emulator::Rom::chr_tiles() const
+{
+    return chr_tiles_;
+}
+
+uint16_t emulator::Rom::mapper() const
+{
+    auto lower_nibble = header_.flags_six >> 4;
+    auto upper_nibble = header_.flags_seven >> 4;
+
+    return lower_nibble | upper_nibble << 4;
+}
+
+emulator::Mirroring emulator::Rom::mirroring() const
+{
+    if (header_.flags_six & 0x08)
+    {
+        return Mirroring::four_screen;
+    }
+
+    return header_.flags_six & 0x01 ? Mirroring::vertical : Mirroring::horizontal;
+}
+
+bool emulator::Rom::battery() const
+{
+    return header_.flags_six & 0x02;
+}
+
+bool emulator::Rom::trainer() const
+{
+    return header_.flags_six & 0x04;
+}
+
+emulator::Rom emulator::load_rom(std::string const& path)
+{
+    std::ifstream is(path, std::ifstream::binary);
+    if (!is)
+    {
+        throw std::runtime_error("Unable to open " + path);
+    }
+
+    is >> std::noskipws;
+    return Rom(std::vector<uint8_t>(std::istream_iterator<uint8_t>(is), {}));
+}
@@ -0,0 +1,107 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+An iNES ROM image.
+
+The whole file is kept as loaded and never modified, PRG and CHR are views
+into it. Mappers point the CPU and PPU straight at those views so switching
+banks never copies anything. CHR is also decoded to tiles once on load.
+
+Copies of a Rom share the image and the decoded tiles, so any number of
+consoles can run one ROM with a single copy of each.
+
+    Offset   Size          Contents
+    ------------------------------------
+    0x0000 : 0x10        : Header, "NES" 0x1A magic
+    0x0010 : 0x200       : Trainer, only if flags 6 bit 2 is set
+             16KB * n    : PRG ROM
+             8KB * n     : CHR ROM, none means the cartridge has CHR RAM
+
+*/
+
+#ifndef NES_EMULATOR_ROM_H_
+#define NES_EMULATOR_ROM_H_
+
+#include "ppu.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace emulator
+{
+
+struct RomHeader
+{
+    uint32_t nes_magic;
+    uint8_t  prg_size;
+    uint8_t  chr_size;
+    uint8_t  flags_six;
+    uint8_t  flags_seven;
+    uint8_t  prg_ram_size;
+    uint8_t  flags_nine;
+};
+
+class Rom
+{
+public:
+    // Throws if image is not an iNES file or is too short for its header
+    explicit Rom(std::vector<uint8_t> image);
+
+    RomHeader const& header() const;
+
+    uint8_t const* prg() const;
+    uint32_t prg_size() const;
+
+    uint8_t const* chr() const;
+    uint32_t chr_size() const;
+
+    // CHR decoded for the tile cache, empty if there's no CHR ROM
+    std::shared_ptr<DecodedChr const> const& chr_tiles() const;
+
+    uint16_t mapper() const;
+    Mirroring mirroring() const;
+    bool battery() const;
+    bool trainer() const;
+
+private:
+    std::shared_ptr<std::vector<uint8_t> const> image;
+    std::shared_ptr<DecodedChr const> chr_tiles_;
+    RomHeader header_;
+
+    uint32_t prg_offset;
+    uint32_t prg_size_;
+    uint32_t chr_offset;
+    uint32_t chr_size_;
+};
+
+Rom load_rom(std::string const& path);
+
+}
+
+#endif /* NES_EMULATOR_ROM_H_ */
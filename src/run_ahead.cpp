@@ -0,0 +1,98 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "run_ahead.h"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+}
+
+emulator::RunAhead::RunAhead(ConsoleBase* console, uint8_t frames) :
+    console(console),
+    frames_(frames)
+{
+}
+
+void emulator::RunAhead::set_frames(uint8_t frames)
+{
+    frames_ = frames;
+}
+
+uint8_t emulator::RunAhead::frames() const
+{
+    return frames_;
+}
+
+void emulator::RunAhead::set_audio_handler(std::function<void(APU& apu)> const& audio_handler)
+{
+    this->audio_handler = audio_handler;
+}
+
+uint64_t emulator::RunAhead::run_frame()
+{
+    auto cycles = console->run_frame();
+
+    if (audio_handler)
+    {
+        audio_handler(console->apu());
+    }
+
+    if (!frames_)
+    {
+        return cycles;
+    }
+
+    auto start = Clock::now();
+    console->save_state(state);
+    save_time_ = Clock::now() - start;
+
+    for (uint8_t frame = 0; frame < frames_; frame++)
+    {
+        console->run_frame();
+    }
+
+    // Leaves the last frame ahead in the PPU's frame buffer
+    start = Clock::now();
+    console->load_state(state);
+    load_time_ = Clock::now() - start;
+
+    return cycles;
+}
+
+std::chrono::nanoseconds emulator::RunAhead::save_time() const
+{
+    return save_time_;
+}
+
+std::chrono::nanoseconds emulator::RunAhead::load_time() const
+{
+    return load_time_;
+}
+
+size_t emulator::RunAhead::state_size() const
+{
+    return state.size();
+}
@@ -0,0 +1,93 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+
+Run-ahead, to hide the frames a game takes to react to input.
+
+Most games read the controller in one frame and only show the result a
+frame or two later. Each frame run-ahead runs the console for real, saves
+it, runs frames more with the same input and shows the last of those, then
+loads the save back. What is shown is that many frames ahead of the real
+console, so input shows up that much sooner, and the real console carries
+on from the save as if the frames ahead never happened.
+
+Only the real frame's audio is heard: the audio handler gets the APU after
+the real frame, and whatever the frames ahead add is dropped by the load.
+The frames ahead are still rendered in full, as sprite 0 hits depend on it.
+
+*/
+
+#ifndef NES_EMULATOR_RUN_AHEAD_H_
+#define NES_EMULATOR_RUN_AHEAD_H_
+
+#include "console.h"
+#include "save_state.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace emulator
+{
+
+class RunAhead
+{
+public:
+    // frames 0 just runs the console
+    RunAhead(ConsoleBase* console, uint8_t frames);
+
+    void set_frames(uint8_t frames);
+    uint8_t frames() const;
+
+    // Called after each real frame, take its samples from the APU here
+    void set_audio_handler(std::function<void(APU& apu)> const& audio_handler);
+
+    // One real frame. After it the console's PPU holds the frame to show,
+    // and everything else is where the real frame left it. Returns the
+    // cycles the real frame ran.
+    uint64_t run_frame();
+
+    // How long the last save and load took, and how big the state is
+    std::chrono::nanoseconds save_time() const;
+    std::chrono::nanoseconds load_time() const;
+    size_t state_size() const;
+
+private:
+    ConsoleBase* console;
+    uint8_t frames_;
+
+    std::function<void(APU& apu)> audio_handler;
+
+    SaveState state;
+
+    std::chrono::nanoseconds save_time_{0};
+    std::chrono::nanoseconds load_time_{0};
+};
+
+}
+
+#endif /* NES_EMULATOR_RUN_AHEAD_H_ */
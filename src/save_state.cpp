@@ -0,0 +1,73 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "save_state.h"
+
+#include <cstring>
+#include <stdexcept>
+
+void emulator::SaveState::clear()
+{
+    end      = 0;
+    position = 0;
+}
+
+void emulator::SaveState::rewind()
+{
+    position = 0;
+}
+
+void emulator::SaveState::write(void const* data, size_t size)
+{
+    // Only grows on the first few saves
+    if (end + size > bytes.size())
+    {
+        bytes.resize(end + size);
+    }
+
+    std::memcpy(bytes.data() + end, data, size);
+    end += size;
+}
+
+void emulator::SaveState::read(void* data, size_t size)
+{
+    if (position + size > end)
+    {
+        throw std::runtime_error("Save state is truncated");
+    }
+
+    std::memcpy(data, bytes.data() + position, size);
+    position += size;
+}
+
+uint8_t const* emulator::SaveState::data() const
+{
+    return bytes.data();
+}
+
+size_t emulator::SaveState::size() const
+{
+    return end;
+}
@@ -0,0 +1,101 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+
+A console's state as one contiguous block of bytes.
+
+Each part of the console writes its fields in order with save() and reads
+them back in the same order with load(). Fields go in raw, with no names,
+versions or padding, so a state only loads into the same build and ROM it
+came from. Structs with padding are saved a field at a time, so two
+consoles in the same state save the same bytes. Only what changes while
+running is saved: the ROM, settings, handlers and everything worked out
+from the rest (bank pointers, decoded tiles and blocks, the rendered
+frame) are rebuilt on load instead.
+
+The buffer is kept between saves, so once it has grown to size a save is a
+run of memcpys with no allocation.
+
+*/
+
+#ifndef NES_EMULATOR_SAVE_STATE_H_
+#define NES_EMULATOR_SAVE_STATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace emulator
+{
+
+class SaveState
+{
+public:
+    // Starts a new save over the old one
+    void clear();
+
+    // Back to the start, for loading
+    void rewind();
+
+    template <typename T>
+    void write(T const& value);
+    void write(void const* data, size_t size);
+
+    // Both throw std::runtime_error past the end of the save
+    template <typename T>
+    void read(T& value);
+    void read(void* data, size_t size);
+
+    // Bytes saved
+    uint8_t const* data() const;
+    size_t size() const;
+
+private:
+    std::vector<uint8_t> bytes;
+
+    size_t end{0};
+    size_t position{0};
+};
+
+template <typename T>
+void SaveState::write(T const& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be saved raw");
+    write(&value, sizeof(value));
+}
+
+template <typename T>
+void SaveState::read(T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be loaded raw");
+    read(&value, sizeof(value));
+}
+
+}
+
+#endif /* NES_EMULATOR_SAVE_STATE_H_ */
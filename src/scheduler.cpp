@@ -0,0 +1,219 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "scheduler.h"
+
+#include <utility>
+
+namespace
+{
+size_t index_of(emulator::Event event)
+{
+    return static_cast<size_t>(event);
+}
+}
+
+emulator::Scheduler::Scheduler()
+{
+    position.fill(not_scheduled);
+}
+
+void emulator::Scheduler::set_handler(Event event, Handler const& handler)
+{
+    handlers[index_of(event)] = handler;
+}
+
+void emulator::Scheduler::schedule(Event event, uint64_t when)
+{
+    auto index = position[index_of(event)];
+
+    if (index == not_scheduled)
+    {
+        index = size++;
+        heap[index]   = {when, event};
+        position[index_of(event)] = index;
+        sift_up(index);
+        return;
+    }
+
+    auto before = heap[index].when;
+    heap[index].when = when;
+
+    if (when < before)
+    {
+        sift_up(index);
+    }
+    else
+    {
+        sift_down(index);
+    }
+}
+
+void emulator::Scheduler::cancel(Event event)
+{
+    auto index = position[index_of(event)];
+
+    if (index != not_scheduled)
+    {
+        remove(index);
+    }
+}
+
+bool emulator::Scheduler::is_scheduled(Event event) const
+{
+    return position[index_of(event)] != not_scheduled;
+}
+
+uint64_t emulator::Scheduler::when(Event event) const
+{
+    auto index = position[index_of(event)];
+    return index == not_scheduled ? never : heap[index].when;
+}
+
+void emulator::Scheduler::run_due(uint64_t now)
+{
+    while (size && heap[0].when <= now)
+    {
+        auto entry = heap[0];
+        remove(0);
+
+        auto const& handler = handlers[index_of(entry.event)];
+
+        if (handler)
+        {
+            handler(entry.when);
+        }
+    }
+}
+
+void emulator::Scheduler::save(SaveState& state) const
+{
+    for (size_t event = 0; event < number_of_events; event++)
+    {
+        state.write(when(static_cast<Event>(event)));
+    }
+}
+
+void emulator::Scheduler::load(SaveState& state)
+{
+    position.fill(not_scheduled);
+    size = 0;
+
+    for (size_t event = 0; event < number_of_events; event++)
+    {
+        uint64_t when;
+        state.read(when);
+
+        if (when != never)
+        {
+            schedule(static_cast<Event>(event), when);
+        }
+    }
+}
+
+// Ties go to the lower event so the order never depends on the heap layout
+bool emulator::Scheduler::earlier(size_t a, size_t b) const
+{
+    if (heap[a].when != heap[b].when)
+    {
+        return heap[a].when < heap[b].when;
+    }
+
+    return heap[a].event < heap[b].event;
+}
+
+void emulator::Scheduler::swap_entries(size_t a, size_t b)
+{
+    std::swap(heap[a], heap[b]);
+    position[index_of(heap[a].event)] = a;
+    position[index_of(heap[b].event)] = b;
+}
+
+void emulator::Scheduler::sift_up(size_t index)
+{
+    while (index > 0)
+    {
+        auto parent = (index - 1) / 2;
+
+        if (!earlier(index, parent))
+        {
+            break;
+        }
+
+        swap_entries(index, parent);
+        index = parent;
+    }
+}
+
+void emulator::Scheduler::sift_down(size_t index)
+{
+    while (true)
+    {
+        auto smallest = index;
+        auto left     = index * 2 + 1;
+        auto right    = left + 1;
+
+        if (left < size && earlier(left, smallest))
+        {
+            smallest = left;
+        }
+
+        if (right < size && earlier(right, smallest))
+        {
+            smallest = right;
+        }
+
+        if (smallest == index)
+        {
+            break;
+        }
+
+        swap_entries(index, smallest);
+        index = smallest;
+    }
+}
+
+void emulator::Scheduler::remove(size_t index)
+{
+    auto last = --size;
+    position[index_of(heap[index].event)] = not_scheduled;
+
+    if (index == last)
+    {
+        return;
+    }
+
+    heap[index] = heap[last];
+    position[index_of(heap[index].event)] = index;
+
+    if (index > 0 && earlier(index, (index - 1) / 2))
+    {
+        sift_up(index);
+    }
+    else
+    {
+        sift_down(index);
+    }
+}
@@ -0,0 +1,124 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Timed events on the master clock.
+
+Devices post the cycle their next event is due, the CPU runs uninterrupted
+until the earliest one and then fires everything due. Each event type is
+pending at most once, scheduling it again moves it.
+
+The pending events are kept in a small binary min heap with each event's
+position tracked, so rescheduling and cancelling don't have to search.
+
+*/
+
+#ifndef NES_EMULATOR_SCHEDULER_H_
+#define NES_EMULATOR_SCHEDULER_H_
+
+#include "save_state.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+namespace emulator
+{
+
+// NTSC timing, the PPU runs three dots each CPU cycle
+uint32_t const ppu_dots_per_cpu_cycle{3};
+uint32_t const ppu_dots_per_frame{341 * 262};
+
+enum class Event : uint8_t
+{
+    interrupt,          // NMI or IRQ line raised, serviced by the CPU
+    vblank,             // PPU reaches the start of vertical blank
+    apu_frame_counter,  // APU frame counter step or IRQ
+    mapper_irq,         // Mapper scanline counter
+    number_of_events
+};
+
+size_t const number_of_events{static_cast<size_t>(Event::number_of_events)};
+
+class Scheduler
+{
+public:
+    using Handler = std::function<void(uint64_t when)>;
+
+    static constexpr uint64_t never{std::numeric_limits<uint64_t>::max()};
+
+    Scheduler();
+
+    void set_handler(Event event, Handler const& handler);
+
+    void schedule(Event event, uint64_t when);
+    void cancel(Event event);
+
+    bool is_scheduled(Event event) const;
+    uint64_t when(Event event) const;
+
+    // The earliest pending event, or never
+    uint64_t next() const;
+
+    // Fires every event due at or before now, earliest first. Handlers may
+    // schedule more, those are fired too if they are already due.
+    void run_due(uint64_t now);
+
+    // When each event is due, handlers stay as they are
+    void save(SaveState& state) const;
+    void load(SaveState& state);
+
+private:
+    struct Entry
+    {
+        uint64_t when;
+        Event event;
+    };
+
+    static constexpr size_t not_scheduled{number_of_events};
+
+    bool earlier(size_t a, size_t b) const;
+    void swap_entries(size_t a, size_t b);
+    void sift_up(size_t index);
+    void sift_down(size_t index);
+    void remove(size_t index);
+
+    std::array<Entry, number_of_events> heap;
+    size_t size{0};
+
+    std::array<size_t, number_of_events> position;
+    std::array<Handler, number_of_events> handlers;
+};
+
+inline uint64_t Scheduler::next() const
+{
+    return size ? heap[0].when : never;
+}
+
+}
+
+#endif /* NES_EMULATOR_SCHEDULER_H_ */
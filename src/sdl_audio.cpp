@@ -0,0 +1,113 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "sdl_audio.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+emulator::SDLAudio::SDLAudio(uint32_t sample_rate, size_t ring_samples) :
+    ring(ring_samples)
+{
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
+    {
+        throw std::runtime_error(std::string("Failed to init SDL audio: ") + SDL_GetError());
+    }
+
+    SDL_AudioSpec wanted{};
+    wanted.freq     = static_cast<int>(sample_rate);
+    wanted.format   = AUDIO_S16SYS;
+    wanted.channels = 1;
+    wanted.samples  = default_device_samples;
+    wanted.callback = &SDLAudio::callback;
+    wanted.userdata = this;
+
+    // Mono 16 bit at our rate or nothing, SDL converts if the device differs
+    SDL_AudioSpec obtained{};
+    device = SDL_OpenAudioDevice(nullptr, 0, &wanted, &obtained, 0);
+
+    if (!device)
+    {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        throw std::runtime_error(std::string("Failed to open audio device: ") + SDL_GetError());
+    }
+}
+
+emulator::SDLAudio::~SDLAudio()
+{
+    SDL_CloseAudioDevice(device);
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+void emulator::SDLAudio::queue_frame(APU& apu)
+{
+    frame.resize(apu.samples_available());
+    apu.read_samples(frame.data(), frame.size());
+
+    // Only drops anything if the rate control can't keep up
+    ring.push(frame.data(), frame.size());
+
+    apu.set_rate_adjustment(rate.update(ring.size(), ring.capacity()));
+
+    if (!playing && ring.size() >= ring.capacity() / 2)
+    {
+        SDL_PauseAudioDevice(device, 0);
+        playing = true;
+    }
+}
+
+size_t emulator::SDLAudio::queued() const
+{
+    return ring.size();
+}
+
+uint64_t emulator::SDLAudio::underruns() const
+{
+    return underruns_.load(std::memory_order_relaxed);
+}
+
+void emulator::SDLAudio::callback(void* user_data, Uint8* stream, int length)
+{
+    auto* audio = static_cast<SDLAudio*>(user_data);
+    audio->fill(reinterpret_cast<int16_t*>(stream), length / sizeof(int16_t));
+}
+
+void emulator::SDLAudio::fill(int16_t* out, size_t count)
+{
+    auto popped = ring.pop(out, count);
+
+    // Holding the last level is quieter than dropping to 0
+    if (popped < count)
+    {
+        std::fill(out + popped, out + count, popped ? out[popped - 1] : last_sample);
+        underruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (count)
+    {
+        last_sample = out[count - 1];
+    }
+}
@@ -0,0 +1,101 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Audio output through SDL.
+
+The emulation thread hands over each frame's samples with queue_frame, they
+go into an AudioRing and SDL's callback thread takes them out. The callback
+never locks or waits: if the ring runs dry it holds the last sample and
+counts an underrun. After each frame the APU's output rate is nudged by a
+RateControl so the ring stays around half full, which is also the latency.
+
+Playback only starts once the ring first reaches half full.
+
+*/
+
+#ifndef NES_EMULATOR_SDL_AUDIO_H_
+#define NES_EMULATOR_SDL_AUDIO_H_
+
+#include "apu.h"
+#include "audio_ring.h"
+#include "rate_control.h"
+
+#include <SDL.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace emulator
+{
+
+// About 85ms at 48kHz, the ring aims to sit half full
+size_t const default_audio_ring_samples{4096};
+uint16_t const default_device_samples{512};
+
+class SDLAudio
+{
+public:
+    // Opens the default output device, throws if SDL can't
+    explicit SDLAudio(uint32_t sample_rate = default_sample_rate,
+                      size_t ring_samples = default_audio_ring_samples);
+    ~SDLAudio();
+
+    SDLAudio(SDLAudio const&) = delete;
+    SDLAudio& operator=(SDLAudio const&) = delete;
+
+    // Emulation thread only, after the APU's frame has ended
+    void queue_frame(APU& apu);
+
+    // Samples waiting to be played
+    size_t queued() const;
+
+    uint64_t underruns() const;
+
+private:
+    static void callback(void* user_data, Uint8* stream, int length);
+
+    // Callback thread only
+    void fill(int16_t* out, size_t count);
+
+    AudioRing ring;
+    RateControl rate;
+
+    // Emulation thread side
+    std::vector<int16_t> frame;
+    bool playing{false};
+
+    // Callback thread side
+    int16_t last_sample{0};
+    std::atomic<uint64_t> underruns_{0};
+
+    SDL_AudioDeviceID device{0};
+};
+
+}
+
+#endif /* NES_EMULATOR_SDL_AUDIO_H_ */
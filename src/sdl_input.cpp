@@ -0,0 +1,92 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "sdl_input.h"
+
+#include <SDL.h>
+
+#include <array>
+#include <utility>
+
+namespace
+{
+std::array<std::pair<SDL_Scancode, emulator::Button>, 8> const key_map{{
+    {SDL_SCANCODE_X,      emulator::button_a},
+    {SDL_SCANCODE_Z,      emulator::button_b},
+    {SDL_SCANCODE_RSHIFT, emulator::button_select},
+    {SDL_SCANCODE_RETURN, emulator::button_start},
+    {SDL_SCANCODE_UP,     emulator::button_up},
+    {SDL_SCANCODE_DOWN,   emulator::button_down},
+    {SDL_SCANCODE_LEFT,   emulator::button_left},
+    {SDL_SCANCODE_RIGHT,  emulator::button_right}
+}};
+
+void handle_key(SDL_KeyboardEvent const& key, emulator::Controller& controller)
+{
+    for (auto const& mapping : key_map)
+    {
+        if (mapping.first != key.keysym.scancode)
+        {
+            continue;
+        }
+
+        if (key.type == SDL_KEYDOWN)
+        {
+            controller.press(mapping.second);
+        }
+        else
+        {
+            controller.release(mapping.second);
+        }
+    }
+}
+}
+
+bool emulator::poll_input(Controller& controller)
+{
+    SDL_Event event;
+
+    while (SDL_PollEvent(&event))
+    {
+        switch (event.type)
+        {
+            case SDL_QUIT:
+                return false;
+            case SDL_KEYDOWN:
+            case SDL_KEYUP:
+                if (event.key.keysym.scancode == SDL_SCANCODE_ESCAPE)
+                {
+                    return false;
+                }
+
+                handle_key(event.key, controller);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return true;
+}
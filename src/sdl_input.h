@@ -0,0 +1,58 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+
+Keyboard input through SDL, on the render thread.
+
+    Key          Button
+    -------------------
+    Arrows     : D-pad
+    X          : A
+    Z          : B
+    Right Shift: Select
+    Enter      : Start
+
+Buttons are pressed and released on the Controller straight away, the
+emulation thread picks them up the next time the game strobes it.
+
+*/
+
+#ifndef NES_EMULATOR_SDL_INPUT_H_
+#define NES_EMULATOR_SDL_INPUT_H_
+
+#include "controller.h"
+
+namespace emulator
+{
+
+// Handles every pending event, false once the window is closed or Escape
+// is pressed
+bool poll_input(Controller& controller);
+
+}
+
+#endif /* NES_EMULATOR_SDL_INPUT_H_ */
@@ -0,0 +1,134 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "sdl_video.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+char const* const window_title{"NES Emulator"};
+}
+
+emulator::SDLVideo::SDLVideo(int scale)
+{
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0)
+    {
+        throw std::runtime_error(std::string("Failed to init SDL video: ") + SDL_GetError());
+    }
+
+    window = SDL_CreateWindow(window_title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                              screen_width * scale, screen_height * scale, SDL_WINDOW_RESIZABLE);
+
+    if (window)
+    {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    }
+
+    if (renderer)
+    {
+        // 0xRRGGBBAA in a uint32_t, the same as the PPU's RGBA frame
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING,
+                                    screen_width, screen_height);
+    }
+
+    if (!texture)
+    {
+        std::string error = std::string("Failed to open window: ") + SDL_GetError();
+        destroy();
+        throw std::runtime_error(error);
+    }
+
+    // Scales up by whole pixels and letterboxes when resized
+    SDL_RenderSetLogicalSize(renderer, screen_width, screen_height);
+}
+
+emulator::SDLVideo::~SDLVideo()
+{
+    destroy();
+}
+
+void emulator::SDLVideo::destroy()
+{
+    if (texture)
+    {
+        SDL_DestroyTexture(texture);
+    }
+
+    if (renderer)
+    {
+        SDL_DestroyRenderer(renderer);
+    }
+
+    if (window)
+    {
+        SDL_DestroyWindow(window);
+    }
+
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+}
+
+void emulator::SDLVideo::present(TripleBuffer& frames)
+{
+    // Otherwise the texture still holds the last frame
+    if (frames.update())
+    {
+        upload(frames.front());
+        frames_shown_++;
+    }
+
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+    SDL_RenderPresent(renderer);
+}
+
+uint64_t emulator::SDLVideo::frames_shown() const
+{
+    return frames_shown_;
+}
+
+void emulator::SDLVideo::upload(RgbaFrameBuffer const& frame)
+{
+    void* pixels = nullptr;
+    int pitch    = 0;
+
+    if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) != 0)
+    {
+        return;
+    }
+
+    auto const row_bytes = screen_width * sizeof(uint32_t);
+    auto* out = static_cast<uint8_t*>(pixels);
+
+    // The texture's rows may be padded
+    for (size_t y = 0; y < screen_height; y++)
+    {
+        std::memcpy(out + y * pitch, frame.data() + y * screen_width, row_bytes);
+    }
+
+    SDL_UnlockTexture(texture);
+}
@@ -0,0 +1,82 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+
+Video output through SDL, on the render thread.
+
+Each present picks up the newest frame the emulation thread has published
+to the TripleBuffer, if there is one, copies it into a streaming texture
+and presents on vsync. Only the render thread ever waits on vsync, the
+emulation thread keeps publishing into the triple buffer meanwhile and
+frames it outruns are dropped rather than queued.
+
+*/
+
+#ifndef NES_EMULATOR_SDL_VIDEO_H_
+#define NES_EMULATOR_SDL_VIDEO_H_
+
+#include "triple_buffer.h"
+
+#include <SDL.h>
+
+#include <cstdint>
+
+namespace emulator
+{
+
+int const default_window_scale{3};
+
+class SDLVideo
+{
+public:
+    // Opens a window scale times the NES screen, throws if SDL can't
+    explicit SDLVideo(int scale = default_window_scale);
+    ~SDLVideo();
+
+    SDLVideo(SDLVideo const&) = delete;
+    SDLVideo& operator=(SDLVideo const&) = delete;
+
+    // Render thread only. Blocks until the next vsync.
+    void present(TripleBuffer& frames);
+
+    // Frames that made it to the screen, the rest were skipped
+    uint64_t frames_shown() const;
+
+private:
+    void upload(RgbaFrameBuffer const& frame);
+    void destroy();
+
+    SDL_Window* window{nullptr};
+    SDL_Renderer* renderer{nullptr};
+    SDL_Texture* texture{nullptr};
+
+    uint64_t frames_shown_{0};
+};
+
+}
+
+#endif /* NES_EMULATOR_SDL_VIDEO_H_ */
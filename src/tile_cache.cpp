@@ -0,0 +1,106 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "tile_cache.h"
+#include "pixel_kernels.h"
+
+#include <algorithm>
+#include <utility>
+
+std::shared_ptr<emulator::DecodedChr const> emulator::decode_chr(uint8_t const* chr, uint32_t size)
+{
+    auto decode_tile = pixel_kernels().decode_tile;
+    auto tiles       = std::make_shared<DecodedChr>(size / 16);
+
+    for (size_t tile = 0; tile < tiles->size(); tile++)
+    {
+        decode_tile(chr + tile * 16, (*tiles)[tile].data());
+    }
+
+    return tiles;
+}
+
+emulator::TileCache::TileCache(PatternBanks const& banks) :
+    banks(banks),
+    decode_tile(pixel_kernels().decode_tile)
+{
+    for (uint8_t bank = 0; bank < number_of_pattern_banks; bank++)
+    {
+        bank_tiles[bank] = tiles.data() + bank * tiles_per_bank;
+    }
+}
+
+void emulator::TileCache::set_rom(uint8_t const* chr, uint32_t size, std::shared_ptr<DecodedChr const> tiles)
+{
+    rom       = chr;
+    rom_size  = size;
+    rom_tiles = std::move(tiles);
+
+    invalidate_all();
+}
+
+void emulator::TileCache::invalidate(uint16_t address)
+{
+    decoded[address >> 4 & (number_of_tiles - 1)] = false;
+}
+
+void emulator::TileCache::invalidate_bank(uint8_t bank)
+{
+    auto first = decoded.begin() + bank * tiles_per_bank;
+    std::fill(first, first + tiles_per_bank, false);
+}
+
+void emulator::TileCache::invalidate_all()
+{
+    for (uint8_t bank = 0; bank < number_of_pattern_banks; bank++)
+    {
+        remap_bank(bank);
+    }
+}
+
+void emulator::TileCache::remap_bank(uint8_t bank)
+{
+    auto data  = reinterpret_cast<uintptr_t>(banks[bank]);
+    auto start = reinterpret_cast<uintptr_t>(rom);
+
+    // Anywhere in ROM on a tile boundary can use the decoded copy
+    if (rom_tiles && data >= start && data + pattern_bank_size <= start + rom_size && (data - start) % 16 == 0)
+    {
+        bank_tiles[bank] = rom_tiles->data() + (data - start) / 16;
+
+        auto first = decoded.begin() + bank * tiles_per_bank;
+        std::fill(first, first + tiles_per_bank, true);
+        return;
+    }
+
+    bank_tiles[bank] = tiles.data() + bank * tiles_per_bank;
+    invalidate_bank(bank);
+}
+
+void emulator::TileCache::decode(uint16_t tile)
+{
+    decode_tile(banks[tile / tiles_per_bank] + tile % tiles_per_bank * 16, tiles[tile].data());
+    decoded[tile] = true;
+}
@@ -0,0 +1,124 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Pattern table tiles decoded to one byte per pixel.
+
+A tile is stored as two bit planes, 8 bytes of low bits then 8 bytes of high
+bits. The renderer wants the 2 bit pixel values. CHR ROM never changes, so
+the Rom decodes it whole once and every console running that Rom shares the
+copy. A bank pointing into it reads the shared tiles, switching banks decodes
+nothing. Banks anywhere else, i.e. CHR RAM, keep a tile per pattern table
+slot, decoded the first time it is drawn and kept until something writes to
+its pattern bytes or the bank is pointed elsewhere.
+
+*/
+
+#ifndef NES_EMULATOR_TILE_CACHE_H_
+#define NES_EMULATOR_TILE_CACHE_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace emulator
+{
+
+// 0x0000 - 0x1FFF, 16 bytes a tile
+uint16_t const number_of_tiles{512};
+
+// Both pattern tables as 8 banks of 1KB, 64 tiles each
+uint16_t const pattern_bank_size{0x400};
+uint16_t const tiles_per_bank{pattern_bank_size / 16};
+uint8_t const number_of_pattern_banks{8};
+
+using PatternBanks = std::array<uint8_t const*, number_of_pattern_banks>;
+
+// One tile as 8 rows of 8 pixels
+using Tile = std::array<uint8_t, 64>;
+
+// A whole CHR ROM decoded, tile n from bytes n * 16 on
+using DecodedChr = std::vector<Tile>;
+
+std::shared_ptr<DecodedChr const> decode_chr(uint8_t const* chr, uint32_t size);
+
+class TileCache
+{
+public:
+    // Tiles are read through banks, after pointing a bank somewhere else
+    // call remap_bank for it
+    explicit TileCache(PatternBanks const& banks);
+
+    // Banks pointing into chr read tiles, its decoded copy. chr has to
+    // outlive the cache, tiles is kept alive by it.
+    void set_rom(uint8_t const* chr, uint32_t size, std::shared_ptr<DecodedChr const> tiles);
+
+    // The 8 pixels (0 - 3) of one tile row, left to right. address is the
+    // pattern table address of the row's low plane byte.
+    uint8_t const* row(uint16_t address);
+
+    // The pattern byte at address changed
+    void invalidate(uint16_t address);
+    void invalidate_bank(uint8_t bank);
+    void invalidate_all();
+
+    // The bank points somewhere else now
+    void remap_bank(uint8_t bank);
+
+private:
+    void decode(uint16_t tile);
+
+    PatternBanks const& banks;
+    void (*decode_tile)(uint8_t const* planes, uint8_t* pixels);
+
+    uint8_t const* rom{nullptr};
+    uint32_t rom_size{0};
+    std::shared_ptr<DecodedChr const> rom_tiles;
+
+    // Each bank's 64 tiles, in rom_tiles or its own slots in tiles
+    std::array<Tile const*, number_of_pattern_banks> bank_tiles;
+
+    std::array<Tile, number_of_tiles> tiles;
+    std::array<bool, number_of_tiles> decoded{};
+};
+
+inline uint8_t const* TileCache::row(uint16_t address)
+{
+    uint16_t tile = address >> 4 & (number_of_tiles - 1);
+
+    // Always true for banks in ROM
+    if (!decoded[tile])
+    {
+        decode(tile);
+    }
+
+    return bank_tiles[tile / tiles_per_bank][tile % tiles_per_bank].data() + (address & 0x07) * 8;
+}
+
+}
+
+#endif /* NES_EMULATOR_TILE_CACHE_H_ */
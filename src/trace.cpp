@@ -0,0 +1,145 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "trace.h"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+char const trace_magic[4]{'N', 'E', 'S', 'T'};
+uint32_t const trace_version{1};
+
+size_t round_up_power_of_two(size_t value)
+{
+    size_t power = 1;
+
+    while (power < value)
+    {
+        power <<= 1;
+    }
+
+    return power;
+}
+
+template <typename T>
+void write_raw(std::ostream& os, T const* data, size_t count)
+{
+    os.write(reinterpret_cast<char const*>(data), sizeof(T) * count);
+}
+
+template <typename T>
+void read_raw(std::istream& is, T* data, size_t count)
+{
+    if (!is.read(reinterpret_cast<char*>(data), sizeof(T) * count))
+    {
+        throw std::runtime_error("Trace file is truncated");
+    }
+}
+}
+
+emulator::TraceBuffer::TraceBuffer(size_t capacity) :
+    ring(round_up_power_of_two(capacity ? capacity : 1)),
+    mask(ring.size() - 1)
+{
+}
+
+size_t emulator::TraceBuffer::size() const
+{
+    return total_ < ring.size() ? total_ : ring.size();
+}
+
+size_t emulator::TraceBuffer::capacity() const
+{
+    return ring.size();
+}
+
+uint64_t emulator::TraceBuffer::total() const
+{
+    return total_;
+}
+
+void emulator::TraceBuffer::clear()
+{
+    total_ = 0;
+}
+
+std::vector<emulator::TraceRecord> emulator::TraceBuffer::records() const
+{
+    std::vector<TraceRecord> ordered;
+    ordered.reserve(size());
+
+    for (auto i = total_ - size(); i < total_; i++)
+    {
+        ordered.push_back(ring[i & mask]);
+    }
+
+    return ordered;
+}
+
+// Header is the magic, a version and the record count, then the records in
+// host byte order
+void emulator::TraceBuffer::save(std::ostream& os) const
+{
+    auto ordered  = records();
+    uint64_t size = ordered.size();
+
+    write_raw(os, trace_magic, sizeof(trace_magic));
+    write_raw(os, &trace_version, 1);
+    write_raw(os, &size, 1);
+    write_raw(os, ordered.data(), ordered.size());
+}
+
+std::vector<emulator::TraceRecord> emulator::TraceBuffer::load(std::istream& is)
+{
+    char magic[sizeof(trace_magic)];
+    uint32_t version = 0;
+    uint64_t size    = 0;
+
+    read_raw(is, magic, sizeof(magic));
+
+    if (!std::equal(magic, magic + sizeof(magic), trace_magic))
+    {
+        throw std::runtime_error("Not a trace file");
+    }
+
+    read_raw(is, &version, 1);
+
+    if (version != trace_version)
+    {
+        throw std::runtime_error("Unsupported trace version " + std::to_string(version));
+    }
+
+    read_raw(is, &size, 1);
+
+    std::vector<TraceRecord> records(size);
+    read_raw(is, records.data(), records.size());
+
+    return records;
+}
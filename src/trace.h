@@ -0,0 +1,110 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+
+Instruction tracing.
+
+CPU::step() takes a trace policy. NoTrace is the default and compiles away to
+nothing, TraceBuffer copies a small binary record of each instruction into a
+preallocated ring. Turning records into text is left to the nes-trace-dump
+tool so it never happens while emulating.
+
+*/
+
+#ifndef NES_EMULATOR_TRACE_H_
+#define NES_EMULATOR_TRACE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace emulator
+{
+
+// The CPU state just before an instruction ran
+struct TraceRecord
+{
+    uint64_t cycle;
+    uint16_t program_counter;
+    uint8_t  op_code;
+    uint8_t  accumulator;
+    uint8_t  x_register;
+    uint8_t  y_register;
+    uint8_t  status;
+    uint8_t  stack;
+};
+
+static_assert(sizeof(TraceRecord) == 16, "Trace records are written out as is");
+
+struct NoTrace
+{
+    static constexpr bool enabled{false};
+
+    void record(TraceRecord const& /*record*/)
+    {
+    }
+};
+
+// Keeps the most recent records, overwriting the oldest once full
+class TraceBuffer
+{
+public:
+    static constexpr bool enabled{true};
+
+    // Rounded up to a power of two
+    explicit TraceBuffer(size_t capacity);
+
+    void record(TraceRecord const& record);
+
+    size_t size() const;
+    size_t capacity() const;
+
+    // Every record seen, including ones since overwritten
+    uint64_t total() const;
+
+    void clear();
+
+    // Oldest first
+    std::vector<TraceRecord> records() const;
+
+    void save(std::ostream& os) const;
+    static std::vector<TraceRecord> load(std::istream& is);
+
+private:
+    std::vector<TraceRecord> ring;
+    size_t mask;
+    uint64_t total_{0};
+};
+
+inline void TraceBuffer::record(TraceRecord const& record)
+{
+    ring[total_++ & mask] = record;
+}
+
+}
+
+#endif /* NES_EMULATOR_TRACE_H_ */
@@ -0,0 +1,64 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "triple_buffer.h"
+
+emulator::RgbaFrameBuffer& emulator::TripleBuffer::back()
+{
+    return buffers[back_index];
+}
+
+void emulator::TripleBuffer::publish()
+{
+    // Release so the consumer sees the pixels once it sees the index
+    auto old_middle = middle.exchange(back_index | fresh, std::memory_order_acq_rel);
+    back_index = old_middle & index_mask;
+
+    published_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool emulator::TripleBuffer::update()
+{
+    if (!(middle.load(std::memory_order_relaxed) & fresh))
+    {
+        return false;
+    }
+
+    // Only the producer sets fresh, so it is still set here
+    auto old_middle = middle.exchange(front_index, std::memory_order_acq_rel);
+    front_index = old_middle & index_mask;
+
+    return true;
+}
+
+emulator::RgbaFrameBuffer const& emulator::TripleBuffer::front() const
+{
+    return buffers[front_index];
+}
+
+uint64_t emulator::TripleBuffer::published() const
+{
+    return published_.load(std::memory_order_relaxed);
+}
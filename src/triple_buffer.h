@@ -0,0 +1,94 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+
+Triple buffered frames between the emulation and render threads.
+
+The producer draws into its back buffer and publishes it, the consumer
+picks up the newest published buffer as its front. The third buffer sits in
+the middle holding whatever was published last. Publishing and picking up
+are each one atomic exchange of the middle index, which also carries a flag
+saying whether the middle is newer than the consumer's front, so neither
+side ever waits on the other. Frames the consumer never got to are simply
+overwritten.
+
+*/
+
+#ifndef NES_EMULATOR_TRIPLE_BUFFER_H_
+#define NES_EMULATOR_TRIPLE_BUFFER_H_
+
+#include "ppu.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace emulator
+{
+
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(TripleBuffer const&) = delete;
+    TripleBuffer& operator=(TripleBuffer const&) = delete;
+
+    // Producer only. Not seen by the consumer until published.
+    RgbaFrameBuffer& back();
+
+    // Producer only. Swaps the back buffer into the middle and takes the old
+    // middle as the next back buffer.
+    void publish();
+
+    // Consumer only. Swaps in the newest published frame as the front, false
+    // if nothing has been published since the last call.
+    bool update();
+
+    // Consumer only
+    RgbaFrameBuffer const& front() const;
+
+    // Frames published so far, from either side
+    uint64_t published() const;
+
+private:
+    // Middle buffer index in the low bits
+    static constexpr uint8_t index_mask{0x03};
+    static constexpr uint8_t fresh{0x04};
+
+    std::array<RgbaFrameBuffer, 3> buffers{};
+
+    uint8_t back_index{0};
+    uint8_t front_index{1};
+    std::atomic<uint8_t> middle{2};
+
+    std::atomic<uint64_t> published_{0};
+};
+
+}
+
+#endif /* NES_EMULATOR_TRIPLE_BUFFER_H_ */
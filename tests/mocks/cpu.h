@@ -38,7 +38,7 @@ struct MockCPU : emulator::CPU
     }
 
     // In case someone wants to override the ppu with a different mock
-    MockCPU(emulator::PPU const* ppu) :
+    MockCPU(emulator::PPU* ppu) :
         CPU(ppu)
     {
     }
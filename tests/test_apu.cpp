@@ -0,0 +1,329 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "apu.h"
+#include "scheduler.h"
+
+namespace
+{
+uint64_t const frame_cycles{29781};
+
+struct TestAPU : ::testing::Test
+{
+    TestAPU()
+    {
+        apu.set_clock([this] {
+            return cycle;
+        });
+        apu.set_interrupt_request_handler([this] (bool asserted) {
+            interrupts += asserted;
+        });
+        apu.set_memory_reader([] (uint16_t address) {
+            return static_cast<uint8_t>(address);
+        });
+        apu.set_scheduler(&scheduler);
+    }
+
+    uint8_t status_at(uint64_t at)
+    {
+        cycle = at;
+        return apu.read_status();
+    }
+
+    std::vector<int16_t> read_all()
+    {
+        std::vector<int16_t> samples(apu.samples_available());
+        apu.read_samples(samples.data(), samples.size());
+        return samples;
+    }
+
+    emulator::APU apu;
+    emulator::Scheduler scheduler;
+    uint64_t cycle{0};
+    int interrupts{0};
+};
+}
+
+TEST_F(TestAPU, test_length_counter_in_status)
+{
+    apu.write_register(0x4015, 0x01);
+    apu.write_register(0x4003, 0x08);
+
+    EXPECT_EQ(apu.read_status() & 0x1F, 0x01);
+
+    apu.write_register(0x4015, 0x00);
+
+    EXPECT_EQ(apu.read_status() & 0x1F, 0x00);
+}
+
+TEST_F(TestAPU, test_length_ignored_while_disabled)
+{
+    apu.write_register(0x400F, 0x08);
+
+    EXPECT_EQ(apu.read_status() & 0x08, 0x00);
+}
+
+TEST_F(TestAPU, test_length_counts_down_on_half_frames)
+{
+    apu.write_register(0x4017, 0x40);
+    apu.write_register(0x4015, 0x04);
+
+    // Length index 3 is 2
+    apu.write_register(0x400B, 0x18);
+
+    EXPECT_EQ(status_at(14912) & 0x04, 0x04);
+    EXPECT_EQ(status_at(14913) & 0x04, 0x04);
+    EXPECT_EQ(status_at(29829) & 0x04, 0x00);
+}
+
+TEST_F(TestAPU, test_halt_keeps_length)
+{
+    apu.write_register(0x4017, 0x40);
+    apu.write_register(0x4015, 0x01);
+    apu.write_register(0x4000, 0x20);
+    apu.write_register(0x4003, 0x18);
+
+    EXPECT_EQ(status_at(frame_cycles * 4) & 0x01, 0x01);
+}
+
+TEST_F(TestAPU, test_frame_irq_is_scheduled)
+{
+    EXPECT_EQ(scheduler.when(emulator::Event::apu_frame_counter), 29829u);
+
+    cycle = 29829;
+    scheduler.run_due(cycle);
+
+    EXPECT_EQ(interrupts, 1);
+    EXPECT_EQ(apu.read_status() & 0x40, 0x40);
+
+    // Reading acknowledged it, the next one is a sequence later
+    EXPECT_EQ(apu.read_status() & 0x40, 0x00);
+    EXPECT_EQ(scheduler.when(emulator::Event::apu_frame_counter), 29829u + 29830u);
+}
+
+TEST_F(TestAPU, test_frame_irq_inhibit)
+{
+    apu.write_register(0x4017, 0x40);
+
+    EXPECT_FALSE(scheduler.is_scheduled(emulator::Event::apu_frame_counter));
+    EXPECT_EQ(status_at(frame_cycles * 2) & 0x40, 0x00);
+}
+
+TEST_F(TestAPU, test_five_step_mode_has_no_irq)
+{
+    apu.write_register(0x4017, 0x80);
+
+    EXPECT_FALSE(scheduler.is_scheduled(emulator::Event::apu_frame_counter));
+}
+
+TEST_F(TestAPU, test_five_step_mode_clocks_half_frame_on_write)
+{
+    apu.write_register(0x4015, 0x01);
+
+    // Length index 1 is 254, index 3 is 2
+    apu.write_register(0x4003, 0x18);
+    apu.write_register(0x4017, 0xC0);
+
+    // Two half frames by the second step
+    EXPECT_EQ(status_at(14913) & 0x01, 0x00);
+}
+
+TEST_F(TestAPU, test_dmc_irq_after_last_byte)
+{
+    apu.write_register(0x4017, 0x40);
+
+    // IRQ, fastest rate, 17 bytes
+    apu.write_register(0x4010, 0x8F);
+    apu.write_register(0x4013, 0x01);
+    apu.write_register(0x4015, 0x10);
+
+    EXPECT_EQ(apu.read_status() & 0x10, 0x10);
+
+    // The first byte is fetched straight away, the other 16 every 8 bits of
+    // 54 cycles, the last one going into the buffer as the first 8 bits run out
+    uint64_t last_fetch = 54 * (8 + 15 * 8 - 1);
+    EXPECT_EQ(scheduler.when(emulator::Event::apu_frame_counter), last_fetch + 1);
+
+    EXPECT_EQ(status_at(last_fetch) & 0x80, 0x00);
+
+    cycle = last_fetch + 1;
+    scheduler.run_due(cycle);
+
+    EXPECT_EQ(interrupts, 1);
+    EXPECT_EQ(apu.read_status() & 0x90, 0x80);
+}
+
+TEST_F(TestAPU, test_dmc_loop_has_no_irq)
+{
+    apu.write_register(0x4017, 0x40);
+    apu.write_register(0x4010, 0xCF);
+    apu.write_register(0x4015, 0x10);
+
+    EXPECT_FALSE(scheduler.is_scheduled(emulator::Event::apu_frame_counter));
+    EXPECT_EQ(status_at(frame_cycles) & 0x10, 0x10);
+}
+
+TEST_F(TestAPU, test_settles_to_silence)
+{
+    std::vector<int16_t> samples;
+
+    // The triangle sits at 15 from power on, the high pass takes that away
+    for (int frame = 0; frame < 10; frame++)
+    {
+        apu.end_frame(frame_cycles * (frame + 1));
+        samples = read_all();
+    }
+
+    EXPECT_GE(samples.size(), 798u);
+    for (auto sample : samples)
+    {
+        ASSERT_LE(std::abs(sample), 1);
+    }
+}
+
+TEST_F(TestAPU, test_pulse_tone)
+{
+    apu.write_register(0x4017, 0x40);
+    apu.write_register(0x4015, 0x01);
+
+    // 50% duty, constant volume 15, about 440Hz
+    apu.write_register(0x4000, 0xBF);
+    apu.write_register(0x4002, 0xFD);
+    apu.write_register(0x4003, 0x08);
+
+    std::vector<int16_t> samples;
+    for (int frame = 0; frame < 10; frame++)
+    {
+        apu.end_frame(frame_cycles * (frame + 1));
+        auto frame_samples = read_all();
+        samples.insert(samples.end(), frame_samples.begin(), frame_samples.end());
+    }
+
+    // Count rising edges over the last half, the high pass has settled there
+    int rising = 0;
+    for (size_t i = samples.size() / 2 + 1; i < samples.size(); i++)
+    {
+        if (samples[i - 1] < 0 && samples[i] >= 0)
+        {
+            rising++;
+        }
+    }
+
+    // 1789773 / (16 * 254) Hz over 5 frames
+    double expected = 1789773.0 / (16 * 254) * (samples.size() / 2) / 48000.0;
+    EXPECT_NEAR(rising, expected, 2);
+}
+
+TEST_F(TestAPU, test_dmc_output_level)
+{
+    apu.write_register(0x4011, 0x40);
+    apu.end_frame(frame_cycles);
+
+    auto samples = read_all();
+
+    // A jump to 64, leaking away through the high pass
+    EXPECT_GT(samples[emulator::BlipBuffer::latency + 2], 64 * 100);
+}
+
+TEST_F(TestAPU, test_channel_writes_wait_for_a_sync)
+{
+    apu.write_register(0x4015, 0x01);
+
+    cycle = 100;
+    apu.write_register(0x4000, 0xBF);
+    apu.write_register(0x4003, 0x08);
+
+    EXPECT_EQ(apu.queued_writes(), 2u);
+    EXPECT_EQ(apu.timestamp(), 0u);
+
+    EXPECT_EQ(status_at(200) & 0x01, 0x01);
+    EXPECT_EQ(apu.queued_writes(), 0u);
+    EXPECT_EQ(apu.timestamp(), 200u);
+}
+
+TEST_F(TestAPU, test_status_writes_apply_straight_away)
+{
+    cycle = 100;
+    apu.write_register(0x4015, 0x01);
+
+    EXPECT_EQ(apu.queued_writes(), 0u);
+    EXPECT_EQ(apu.timestamp(), 100u);
+}
+
+TEST_F(TestAPU, test_queued_writes_land_on_their_cycle)
+{
+    apu.write_register(0x4017, 0x40);
+    apu.write_register(0x4015, 0x01);
+
+    // Length 2 loaded after the first half frame, so it takes two more
+    cycle = 20000;
+    apu.write_register(0x4003, 0x18);
+
+    EXPECT_EQ(status_at(29829) & 0x01, 0x01);
+    EXPECT_EQ(status_at(29830 + 14913) & 0x01, 0x00);
+}
+
+TEST_F(TestAPU, test_irq_deadline_leaves_later_writes_queued)
+{
+    apu.write_register(0x4015, 0x01);
+
+    cycle = 29900;
+    apu.write_register(0x4003, 0x08);
+    scheduler.run_due(cycle);
+
+    EXPECT_EQ(interrupts, 1);
+    EXPECT_EQ(apu.timestamp(), 29829u);
+    EXPECT_EQ(apu.queued_writes(), 1u);
+}
+
+TEST_F(TestAPU, test_full_queue_is_caught_up)
+{
+    for (int i = 0; i < 1000; i++)
+    {
+        cycle = i;
+        apu.write_register(0x4002, i);
+    }
+
+    EXPECT_LE(apu.queued_writes(), 256u);
+    EXPECT_GT(apu.timestamp(), 0u);
+}
+
+TEST_F(TestAPU, test_end_frame_applies_queued_writes)
+{
+    apu.write_register(0x4017, 0x40);
+    apu.write_register(0x4011, 0x40);
+    apu.end_frame(frame_cycles);
+
+    auto samples = read_all();
+
+    EXPECT_EQ(apu.queued_writes(), 0u);
+    EXPECT_GT(samples[emulator::BlipBuffer::latency + 2], 64 * 100);
+}
@@ -0,0 +1,148 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "audio_ring.h"
+
+TEST(TestAudioRing, test_capacity_is_a_power_of_two)
+{
+    emulator::AudioRing ring(3000);
+
+    EXPECT_EQ(ring.capacity(), 4096u);
+}
+
+TEST(TestAudioRing, test_pops_what_was_pushed)
+{
+    emulator::AudioRing ring(16);
+    int16_t in[] = {1, 2, 3, 4, 5};
+    int16_t out[5]{};
+
+    EXPECT_EQ(ring.push(in, 5), 5u);
+    EXPECT_EQ(ring.size(), 5u);
+    EXPECT_EQ(ring.pop(out, 5), 5u);
+
+    EXPECT_EQ(out[0], 1);
+    EXPECT_EQ(out[4], 5);
+    EXPECT_EQ(ring.size(), 0u);
+}
+
+TEST(TestAudioRing, test_push_stops_when_full)
+{
+    emulator::AudioRing ring(8);
+    std::vector<int16_t> in(10, 7);
+
+    EXPECT_EQ(ring.push(in.data(), in.size()), 8u);
+    EXPECT_EQ(ring.push(in.data(), 1), 0u);
+}
+
+TEST(TestAudioRing, test_pop_stops_when_empty)
+{
+    emulator::AudioRing ring(8);
+    int16_t in[] = {1, 2};
+    int16_t out[4]{};
+
+    ring.push(in, 2);
+
+    EXPECT_EQ(ring.pop(out, 4), 2u);
+    EXPECT_EQ(ring.pop(out, 4), 0u);
+}
+
+TEST(TestAudioRing, test_wraps_around_the_end)
+{
+    emulator::AudioRing ring(8);
+    int16_t in[] = {1, 2, 3, 4, 5, 6};
+    int16_t out[6]{};
+
+    ring.push(in, 6);
+    ring.pop(out, 6);
+
+    // Starts at 6, so this runs over the end
+    ring.push(in, 6);
+
+    EXPECT_EQ(ring.pop(out, 6), 6u);
+    for (int i = 0; i < 6; i++)
+    {
+        EXPECT_EQ(out[i], in[i]);
+    }
+}
+
+TEST(TestAudioRing, test_producer_and_consumer_threads)
+{
+    emulator::AudioRing ring(256);
+    int const total{200000};
+
+    std::thread producer([&ring] {
+        int16_t next = 0;
+
+        for (int pushed = 0; pushed < total;)
+        {
+            int16_t chunk[37];
+            size_t count = std::min(37, total - pushed);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                chunk[i] = static_cast<int16_t>(next + i);
+            }
+
+            // Spins while the consumer catches up
+            for (size_t done = 0; done < count;)
+            {
+                done += ring.push(chunk + done, count - done);
+            }
+
+            next    = static_cast<int16_t>(next + count);
+            pushed += count;
+        }
+    });
+
+    int16_t expected = 0;
+    int popped       = 0;
+    bool in_order    = true;
+
+    while (popped < total)
+    {
+        int16_t out[53];
+        auto count = ring.pop(out, 53);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            in_order = in_order && out[i] == expected++;
+        }
+
+        popped += count;
+    }
+
+    producer.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(ring.size(), 0u);
+}
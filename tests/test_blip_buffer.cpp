@@ -0,0 +1,132 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "blip_buffer.h"
+
+namespace
+{
+double const clock_rate{1789773.0};
+uint32_t const sample_rate{48000};
+uint32_t const frame_cycles{29781};
+
+struct TestBlipBuffer : ::testing::Test
+{
+    std::vector<int16_t> read_all()
+    {
+        std::vector<int16_t> samples(blip.samples_available());
+        blip.read_samples(samples.data(), samples.size());
+        return samples;
+    }
+
+    emulator::BlipBuffer blip{clock_rate, sample_rate, 4096};
+};
+}
+
+TEST_F(TestBlipBuffer, test_frame_length_in_samples)
+{
+    blip.end_frame(frame_cycles);
+
+    // 29781 * 48000 / 1789773
+    EXPECT_GE(blip.samples_available(), 798u);
+    EXPECT_LE(blip.samples_available(), 799u);
+}
+
+TEST_F(TestBlipBuffer, test_fractional_samples_carry_over)
+{
+    size_t total = 0;
+
+    for (int frame = 0; frame < 60; frame++)
+    {
+        blip.end_frame(frame_cycles);
+        total += read_all().size();
+    }
+
+    // 60 frames is a little over 0.998 seconds
+    EXPECT_NEAR(total, 60.0 * frame_cycles * sample_rate / clock_rate, 1.0);
+}
+
+TEST_F(TestBlipBuffer, test_step_settles_at_its_height)
+{
+    blip.add_delta(0, 1000);
+    blip.end_frame(2000);
+
+    auto samples = read_all();
+
+    // Half the kernel late, then only the slow high pass leak
+    EXPECT_LT(std::abs(samples[0]), 50);
+    EXPECT_NEAR(samples[emulator::BlipBuffer::latency + 2], 1000, 30);
+}
+
+TEST_F(TestBlipBuffer, test_step_between_samples_lands_between)
+{
+    emulator::BlipBuffer early{clock_rate, sample_rate, 4096};
+    emulator::BlipBuffer late{clock_rate, sample_rate, 4096};
+
+    early.add_delta(0, 10000);
+    late.add_delta(18, 10000);
+    early.end_frame(2000);
+    late.end_frame(2000);
+
+    std::vector<int16_t> a(early.samples_available());
+    std::vector<int16_t> b(late.samples_available());
+    early.read_samples(a.data(), a.size());
+    late.read_samples(b.data(), b.size());
+
+    // Half a sample later is still on its way up where the first has
+    // already reached the top
+    auto middle = emulator::BlipBuffer::latency - 1;
+    EXPECT_GT(a[middle], b[middle]);
+    EXPECT_GT(b[middle], 0);
+}
+
+TEST_F(TestBlipBuffer, test_clamps_to_16_bits)
+{
+    blip.add_delta(0, 100000);
+    blip.end_frame(2000);
+
+    auto samples = read_all();
+
+    EXPECT_EQ(samples[emulator::BlipBuffer::latency + 2], 32767);
+}
+
+TEST_F(TestBlipBuffer, test_partial_read_keeps_the_rest)
+{
+    blip.add_delta(0, 1000);
+    blip.end_frame(frame_cycles);
+
+    int16_t first[16];
+    EXPECT_EQ(blip.read_samples(first, 16), 16u);
+
+    auto rest = read_all();
+
+    EXPECT_GE(rest.size(), 782u);
+    EXPECT_NEAR(rest[0], 1000, 30);
+}
@@ -0,0 +1,192 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+#include <vector>
+
+#include "block_cache.h"
+#include "cpu.h"
+#include "mocks/ppu.h"
+
+namespace
+{
+struct TestBlockCache : ::testing::Test
+{
+    TestBlockCache() :
+        cache(&bus)
+    {
+        bus.map_memory(0x00, 0x08, ram.data(), ram.size());
+    }
+
+    std::array<uint8_t, 0x0800> ram{};
+    emulator::Bus bus;
+    emulator::BlockCache cache;
+};
+
+struct TestBlockCacheCPU : ::testing::Test
+{
+    TestBlockCacheCPU() :
+        cpu(&ppu),
+        other(&other_ppu)
+    {
+        cpu.set_core(emulator::CPUCore::cached_blocks);
+    }
+
+    void load(uint16_t address, std::vector<uint8_t> const& program)
+    {
+        for (auto i = 0u; i < program.size(); i++)
+        {
+            cpu.write8(address + i, program[i]);
+            other.write8(address + i, program[i]);
+        }
+
+        cpu.set_program_counter(address);
+        other.set_program_counter(address);
+    }
+
+    // Each block step has to land on the same state the interpreter reaches
+    // after running the same number of cycles
+    void run_in_lockstep(int steps)
+    {
+        uint64_t cycles = 0;
+        uint64_t other_cycles = 0;
+
+        for (auto i = 0; i < steps; i++)
+        {
+            cycles += cpu.step();
+
+            while (other_cycles < cycles)
+            {
+                other_cycles += other.step();
+            }
+
+            ASSERT_EQ(cycles, other_cycles);
+            EXPECT_EQ(cpu.program_counter(), other.program_counter());
+            EXPECT_EQ(cpu.accumulator(), other.accumulator());
+            EXPECT_EQ(cpu.x_register(), other.x_register());
+            EXPECT_EQ(cpu.y_register(), other.y_register());
+            EXPECT_EQ(cpu.status(), other.status());
+        }
+    }
+
+    MockPPU ppu;
+    MockPPU other_ppu;
+    emulator::CPU cpu;
+    emulator::CPU other;
+};
+}
+
+TEST_F(TestBlockCache, test_block_ends_on_branch)
+{
+    // LDX #$02, DEX, CPX #$00, BNE, LDA #$42
+    std::array<uint8_t, 9> program{{0xA2, 0x02, 0xCA, 0xE0, 0x00, 0xD0, 0xFB, 0xA9, 0x42}};
+    std::copy(program.begin(), program.end(), ram.begin());
+
+    auto block = cache.find(0x0000);
+
+    ASSERT_NE(block, nullptr);
+    ASSERT_EQ(block->ops.size(), 4u);
+    EXPECT_EQ(block->ops[0].operand, 0x02);
+    EXPECT_EQ(block->ops[3].number_bytes, 2);
+    EXPECT_EQ(block->ops[3].operand, 0xFB);
+}
+
+TEST_F(TestBlockCache, test_block_is_found_through_mirror)
+{
+    ram[0] = 0xE8;
+    ram[1] = 0x60;
+
+    EXPECT_EQ(cache.find(0x0000), cache.find(0x0000));
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST_F(TestBlockCache, test_unmapped_address_is_not_cached)
+{
+    EXPECT_EQ(cache.find(0x1000), nullptr);
+}
+
+TEST_F(TestBlockCache, test_kil_is_not_cached)
+{
+    ram[0] = 0x02;
+    EXPECT_EQ(cache.find(0x0000), nullptr);
+}
+
+TEST_F(TestBlockCache, test_write_to_cached_page_invalidates)
+{
+    // LDA #$01, RTS
+    ram[0] = 0xA9;
+    ram[1] = 0x01;
+    ram[2] = 0x60;
+
+    ASSERT_NE(cache.find(0x0000), nullptr);
+    EXPECT_EQ(bus.write_page(0x00), nullptr);
+
+    auto generation = cache.generation();
+    bus.write8(0x0001, 0x05);
+
+    EXPECT_EQ(ram[1], 0x05);
+    EXPECT_NE(cache.generation(), generation);
+    EXPECT_EQ(bus.write_page(0x00), ram.data());
+
+    auto block = cache.find(0x0000);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(block->ops[0].operand, 0x05);
+}
+
+TEST_F(TestBlockCache, test_write_to_other_page_keeps_blocks)
+{
+    ram[0] = 0xE8;
+    ram[1] = 0x60;
+
+    cache.find(0x0000);
+    auto generation = cache.generation();
+    bus.write8(0x0100, 0x01);
+
+    EXPECT_EQ(cache.generation(), generation);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST_F(TestBlockCacheCPU, test_cached_blocks_match_interpreter)
+{
+    // LDX #$00, loop: LDA $0200,X, ADC $10, STA $10, INX, CPX #$10, BNE loop, JMP $0600
+    load(0x0600, {0xA2, 0x00, 0xBD, 0x00, 0x02, 0x65, 0x10, 0x85, 0x10,
+                  0xE8, 0xE0, 0x10, 0xD0, 0xF4, 0x4C, 0x00, 0x06});
+
+    run_in_lockstep(100);
+}
+
+TEST_F(TestBlockCacheCPU, test_self_modifying_code)
+{
+    // loop: CLC, LDA #$01, ADC #$01, STA $0302, JMP loop
+    load(0x0300, {0x18, 0xA9, 0x01, 0x69, 0x01, 0x8D, 0x02, 0x03, 0x4C, 0x00, 0x03});
+
+    run_in_lockstep(20);
+
+    EXPECT_GT(cpu.accumulator(), 2);
+    EXPECT_EQ(cpu.read8(0x0302), other.read8(0x0302));
+}
@@ -0,0 +1,95 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "bus.h"
+#include "memory.h"
+#include "mocks/bus_device.h"
+
+namespace
+{
+struct TestBus : ::testing::Test
+{
+    emulator::Bus bus;
+    emulator::Memory<0x0800> ram;
+    MockBusDevice device;
+};
+}
+
+TEST_F(TestBus, test_unmapped_reads_zero)
+{
+    bus.write8(0x1234, 0x56);
+    EXPECT_EQ(bus.read8(0x1234), 0x0);
+}
+
+TEST_F(TestBus, test_memory_is_mirrored)
+{
+    bus.map_memory(0x00, 0x20, ram.data(), 0x0800);
+
+    bus.write8(0x0801, 0x42);
+
+    EXPECT_EQ(ram.read8(0x0001), 0x42);
+    EXPECT_EQ(bus.read8(0x0001), 0x42);
+    EXPECT_EQ(bus.read8(0x1801), 0x42);
+}
+
+TEST_F(TestBus, test_read_only_writes_go_to_device)
+{
+    using namespace ::testing;
+
+    ram.write8(0x0010, 0x42);
+
+    bus.map_device(0x80, 0x80, &device);
+    bus.map_read_only(0x80, 0x80, ram.data(), 0x0800);
+
+    EXPECT_CALL(device, read(_)).Times(0);
+    EXPECT_CALL(device, write(0x8010, 0x01)).Times(1);
+
+    EXPECT_EQ(bus.read8(0x8010), 0x42);
+    bus.write8(0x8010, 0x01);
+
+    EXPECT_EQ(ram.read8(0x0010), 0x42);
+}
+
+TEST_F(TestBus, test_device_pages)
+{
+    using namespace ::testing;
+
+    bus.map_device(0x40, 0x01, &device);
+
+    EXPECT_CALL(device, read(0x4015)).WillOnce(Return(0x1F));
+    EXPECT_CALL(device, write(0x4014, 0x02)).Times(1);
+
+    EXPECT_EQ(bus.read8(0x4015), 0x1F);
+    bus.write8(0x4014, 0x02);
+}
+
+TEST_F(TestBus, test_invalid_mappings_throw)
+{
+    EXPECT_THROW(bus.map_memory(0xF0, 0x20, ram.data(), 0x0800), std::runtime_error);
+    EXPECT_THROW(bus.map_memory(0x00, 0x01, ram.data(), 0x0080), std::runtime_error);
+}
@@ -0,0 +1,199 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "console.h"
+#include "mappers.h"
+
+namespace
+{
+// One 16KB PRG bank spinning on JMP $8000, and 8KB of CHR
+std::vector<uint8_t> make_image(uint8_t mapper)
+{
+    std::vector<uint8_t> image{'N', 'E', 'S', 0x1A, 1, 1,
+                               static_cast<uint8_t>(mapper << 4),
+                               static_cast<uint8_t>(mapper & 0xF0),
+                               0, 0, 0, 0, 0, 0, 0, 0};
+
+    std::vector<uint8_t> prg(0x4000);
+    prg[0x0000] = 0x4C;
+    prg[0x0001] = 0x00;
+    prg[0x0002] = 0x80;
+
+    // Reset vector, 0xFFFC
+    prg[0x3FFC] = 0x00;
+    prg[0x3FFD] = 0x80;
+
+    image.insert(image.end(), prg.begin(), prg.end());
+    image.resize(image.size() + 0x2000);
+
+    return image;
+}
+}
+
+TEST(TestConsole, test_known_mapper_gets_its_own_console)
+{
+    auto console = emulator::make_console(emulator::Rom(make_image(4)));
+
+    EXPECT_NE(dynamic_cast<emulator::Console<emulator::MMC3>*>(console.get()), nullptr);
+}
+
+TEST(TestConsole, test_virtual_fallback)
+{
+    emulator::Console<emulator::Mapper> console(emulator::Rom(make_image(2)));
+
+    EXPECT_NE(dynamic_cast<emulator::UxROM*>(&console.mapper()), nullptr);
+
+    console.reset();
+    EXPECT_EQ(console.cpu().program_counter(), 0x8000);
+
+    console.run_frame();
+
+    emulator::SaveState saved;
+    console.save_state(saved);
+    auto cycles = console.cpu().cycles();
+
+    console.run_frame();
+    console.load_state(saved);
+    EXPECT_EQ(console.cpu().cycles(), cycles);
+
+    // Saving straight after the load gives back the same bytes
+    emulator::SaveState again;
+    console.save_state(again);
+    ASSERT_EQ(again.size(), saved.size());
+    EXPECT_TRUE(std::equal(saved.data(), saved.data() + saved.size(), again.data()));
+}
+
+TEST(TestConsole, test_unsupported_mapper_throws)
+{
+    EXPECT_THROW(emulator::make_console(emulator::Rom(make_image(99))), std::runtime_error);
+}
+
+TEST(TestConsole, test_reset_jumps_through_cartridge_vector)
+{
+    auto console = emulator::make_console(emulator::Rom(make_image(0)));
+
+    console->reset();
+
+    EXPECT_EQ(console->cpu().program_counter(), 0x8000);
+}
+
+TEST(TestConsole, test_masked_frame_irq_is_not_taken)
+{
+    auto image = make_image(0);
+
+    // SEI, JMP $8001 with the IRQ handler doing INC $10, RTI
+    auto prg = image.begin() + 16;
+    prg[0x0000] = 0x78;
+    prg[0x0001] = 0x4C;
+    prg[0x0002] = 0x01;
+    prg[0x0003] = 0x80;
+    prg[0x0100] = 0xE6;
+    prg[0x0101] = 0x10;
+    prg[0x0102] = 0x40;
+    prg[0x3FFE] = 0x00;
+    prg[0x3FFF] = 0x81;
+
+    auto console = emulator::make_console(emulator::Rom(image));
+    console->reset();
+
+    // The APU powers on with the frame IRQ enabled, so it is raised in the
+    // first frame and held from then on
+    for (auto i = 0; i < 10; i++)
+    {
+        console->run_frame();
+    }
+
+    EXPECT_TRUE(console->cpu().interrupt_request());
+    EXPECT_EQ(console->cpu().read8(0x10), 0);
+    EXPECT_EQ(console->cpu().program_counter(), 0x8001);
+}
+
+TEST(TestConsole, test_acknowledged_mapper_irq_is_not_taken)
+{
+    auto run = [] (bool acknowledge) {
+        auto image = make_image(4);
+
+        // With I set: frame IRQ off, rendering on, MMC3 IRQ every 3 lines,
+        // wait most of a frame, maybe acknowledge, then CLI and spin. The
+        // IRQ handler does INC $10, RTI.
+        std::vector<uint8_t> const program{
+            0x78,                         // SEI
+            0xA9, 0x40, 0x8D, 0x17, 0x40, // LDA #$40, STA $4017
+            0xA9, 0x18, 0x8D, 0x01, 0x20, // LDA #$18, STA $2001
+            0xA9, 0x02, 0x8D, 0x00, 0xC0, // LDA #$02, STA $C000
+            0x8D, 0x01, 0xC0,             // STA $C001
+            0x8D, 0x01, 0xE0,             // STA $E001
+            0xA0, 0x10,                   // LDY #$10
+            0xA2, 0x00,                   // LDX #$00
+            0xCA,                         // DEX
+            0xD0, 0xFD,                   // BNE $801A
+            0x88,                         // DEY
+            0xD0, 0xFA,                   // BNE $801A
+            0x8D, 0x00, 0xE0,             // STA $E000
+            0x58,                         // CLI
+            0x4C, 0x24, 0x80              // JMP $8024
+        };
+
+        auto prg = image.begin() + 16;
+        std::copy(program.begin(), program.end(), prg);
+
+        if (!acknowledge)
+        {
+            std::fill(prg + 0x20, prg + 0x23, 0xEA);
+        }
+
+        prg[0x0100] = 0xE6;
+        prg[0x0101] = 0x10;
+        prg[0x0102] = 0x40;
+        prg[0x3FFE] = 0x00;
+        prg[0x3FFF] = 0x81;
+
+        auto console = emulator::make_console(emulator::Rom(image));
+        console->reset();
+        console->run_frame();
+
+        return console->cpu().read8(0x10);
+    };
+
+    EXPECT_EQ(run(true), 0);
+    EXPECT_GT(run(false), 0);
+}
+
+TEST(TestConsole, test_run_frame_catches_the_ppu_up)
+{
+    auto console = emulator::make_console(emulator::Rom(make_image(0)));
+    console->reset();
+
+    console->run_frame();
+
+    EXPECT_EQ(console->ppu().timestamp(), console->cpu().cycles());
+}
@@ -0,0 +1,140 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "controller.h"
+#include "io_registers.h"
+
+namespace
+{
+
+class TestController : public ::testing::Test
+{
+public:
+    TestController()
+    {
+        io.set_controller(0, &one);
+        io.set_controller(1, &two);
+    }
+
+    void strobe()
+    {
+        io.write(0x4016, 1);
+        io.write(0x4016, 0);
+    }
+
+    uint8_t read_buttons(uint16_t address)
+    {
+        uint8_t buttons = 0;
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            buttons |= (io.read(address) & 0x01) << bit;
+        }
+
+        return buttons;
+    }
+
+    emulator::Controller one;
+    emulator::Controller two;
+    emulator::IORegisters io;
+};
+
+}
+
+TEST_F(TestController, test_reads_buttons_in_order)
+{
+    one.set_buttons(emulator::button_a | emulator::button_start | emulator::button_right);
+
+    strobe();
+
+    EXPECT_EQ(read_buttons(0x4016), 0x89);
+}
+
+TEST_F(TestController, test_reads_ones_after_eight)
+{
+    strobe();
+    read_buttons(0x4016);
+
+    EXPECT_EQ(io.read(0x4016) & 0x01, 1);
+    EXPECT_EQ(io.read(0x4016) & 0x01, 1);
+}
+
+TEST_F(TestController, test_strobe_high_keeps_reading_a)
+{
+    one.press(emulator::button_a);
+
+    io.write(0x4016, 1);
+
+    EXPECT_EQ(io.read(0x4016) & 0x01, 1);
+    EXPECT_EQ(io.read(0x4016) & 0x01, 1);
+
+    one.release(emulator::button_a);
+
+    EXPECT_EQ(io.read(0x4016) & 0x01, 0);
+}
+
+TEST_F(TestController, test_latched_until_next_strobe)
+{
+    one.press(emulator::button_b);
+    strobe();
+
+    one.release(emulator::button_b);
+
+    EXPECT_EQ(read_buttons(0x4016), emulator::button_b);
+
+    strobe();
+
+    EXPECT_EQ(read_buttons(0x4016), 0);
+}
+
+TEST_F(TestController, test_second_port_reads_at_4017)
+{
+    one.press(emulator::button_up);
+    two.press(emulator::button_down);
+
+    strobe();
+
+    EXPECT_EQ(read_buttons(0x4016), emulator::button_up);
+    EXPECT_EQ(read_buttons(0x4017), emulator::button_down);
+}
+
+TEST_F(TestController, test_upper_bits_are_open_bus)
+{
+    strobe();
+
+    EXPECT_EQ(io.read(0x4016), 0x40);
+}
+
+TEST_F(TestController, test_empty_port_reads_zero)
+{
+    io.set_controller(1, nullptr);
+
+    strobe();
+
+    EXPECT_EQ(read_buttons(0x4017), 0);
+}
@@ -23,6 +23,8 @@
  * SOFTWARE.
  */
 
+#include <array>
+
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
@@ -152,6 +154,47 @@ TEST_F(TestCPU, test_step)
     EXPECT_EQ(cpu.step(), op.number_cycles);
 }
 
+TEST_F(TestCPU, test_step_function_table_core)
+{
+    cpu.set_core(emulator::CPUCore::function_table);
+
+    // op code ADC - immediate
+    auto op = emulator::instruction[0x69];
+    cpu.write8(0x0, 0x69);
+    cpu.write8(0x1, 0x05);
+
+    EXPECT_EQ(cpu.step(), op.number_cycles);
+    EXPECT_EQ(cpu.accumulator(), 0x05);
+    EXPECT_EQ(cpu.program_counter(), op.number_bytes);
+}
+
+TEST_F(TestCPU, test_cores_match)
+{
+    // LDX #$02, loop: DEX, CPX #$00, BNE loop, LDA #$42
+    std::array<uint8_t, 9> program{{0xA2, 0x02, 0xCA, 0xE0, 0x00, 0xD0, 0xFB, 0xA9, 0x42}};
+
+    MockPPU other_ppu;
+    emulator::CPU other(&other_ppu);
+    other.set_core(emulator::CPUCore::function_table);
+
+    for (auto i = 0u; i < program.size(); i++)
+    {
+        cpu.write8(i, program[i]);
+        other.write8(i, program[i]);
+    }
+
+    for (auto i = 0; i < 8; i++)
+    {
+        EXPECT_EQ(cpu.step(), other.step());
+        EXPECT_EQ(cpu.program_counter(), other.program_counter());
+        EXPECT_EQ(cpu.accumulator(), other.accumulator());
+        EXPECT_EQ(cpu.x_register(), other.x_register());
+        EXPECT_EQ(cpu.status(), other.status());
+    }
+
+    EXPECT_EQ(cpu.accumulator(), 0x42);
+}
+
 TEST_F(TestCPU, test_step_with_interrupt)
 {
     cpu.handle_non_maskable_interrupt();
@@ -165,3 +208,201 @@ TEST_F(TestCPU, test_step_with_interrupt)
     EXPECT_EQ(cpu.step(), op.number_cycles + 7);
     EXPECT_TRUE(cpu.status() & emulator::interrupt);
 }
+
+TEST_F(TestCPU, test_interrupt_request_masked)
+{
+    // SEI, NOP, CLI, NOP, JMP $0001 with a NOP for the IRQ handler at $0200
+    cpu.write8(0x0, 0x78);
+    cpu.write8(0x1, 0xEA);
+    cpu.write8(0x2, 0x58);
+    cpu.write8(0x3, 0xEA);
+    cpu.write8(0x4, 0x4C);
+    cpu.write8(0x5, 0x01);
+    cpu.write8(0x6, 0x00);
+    cpu.write8(0x200, 0xEA);
+
+    std::array<uint8_t, emulator::page_size> vectors{};
+    cpu.bus.map_memory(0xFF, 1, vectors.data(), emulator::page_size);
+    cpu.write8(0xFFFE, 0x00);
+    cpu.write8(0xFFFF, 0x02);
+
+    cpu.step();
+    cpu.set_interrupt_request(emulator::irq_apu, true);
+
+    // The line is held but I is set, so the NOP runs
+    cpu.step();
+    EXPECT_EQ(cpu.program_counter(), 0x2);
+
+    // CLI lets it through in place of the next instruction
+    cpu.step();
+    cpu.step();
+    EXPECT_EQ(cpu.program_counter(), 0x201);
+    EXPECT_TRUE(cpu.status() & emulator::interrupt);
+}
+
+TEST_F(TestCPU, test_interrupt_request_survives_nmi)
+{
+    // CLI, NOP with the NMI handler at $0100 running NOP, RTI and the IRQ
+    // handler at $0200 a NOP
+    cpu.write8(0x0, 0x58);
+    cpu.write8(0x1, 0xEA);
+    cpu.write8(0x100, 0xEA);
+    cpu.write8(0x101, 0x40);
+    cpu.write8(0x200, 0xEA);
+
+    std::array<uint8_t, emulator::page_size> vectors{};
+    cpu.bus.map_memory(0xFF, 1, vectors.data(), emulator::page_size);
+    cpu.write8(0xFFFA, 0x00);
+    cpu.write8(0xFFFB, 0x01);
+    cpu.write8(0xFFFE, 0x00);
+    cpu.write8(0xFFFF, 0x02);
+
+    cpu.step();
+    cpu.set_interrupt_request(emulator::irq_mapper, true);
+    cpu.handle_non_maskable_interrupt();
+
+    // NMI wins, RTI restores I clear and the held IRQ is taken next
+    cpu.step();
+    EXPECT_EQ(cpu.program_counter(), 0x101);
+    cpu.step();
+    EXPECT_EQ(cpu.program_counter(), 0x1);
+    cpu.step();
+    EXPECT_EQ(cpu.program_counter(), 0x201);
+
+    // Once released it stays quiet
+    cpu.set_interrupt_request(emulator::irq_mapper, false);
+    EXPECT_FALSE(cpu.interrupt_request());
+}
+
+TEST_F(TestCPU, test_cycles_do_not_wrap)
+{
+    // NOP, JMP $0000
+    cpu.write8(0x0, 0xEA);
+    cpu.write8(0x1, 0x4C);
+    cpu.write8(0x2, 0x00);
+    cpu.write8(0x3, 0x00);
+
+    for (auto i = 0; i < 200; i++)
+    {
+        cpu.step();
+    }
+
+    EXPECT_EQ(cpu.cycles(), 500u);
+}
+
+TEST_F(TestCPU, test_run_until)
+{
+    // NOP, JMP $0000
+    cpu.write8(0x0, 0xEA);
+    cpu.write8(0x1, 0x4C);
+    cpu.write8(0x2, 0x00);
+    cpu.write8(0x3, 0x00);
+
+    EXPECT_EQ(cpu.run_until(1000), 1000u);
+    EXPECT_EQ(cpu.run_until(500), 0u);
+
+    // The JMP crossing 1004 is finished
+    EXPECT_EQ(cpu.run_for(4), 5u);
+    EXPECT_EQ(cpu.cycles(), 1005u);
+}
+
+TEST_F(TestCPU, test_run_frame)
+{
+    // NOP, JMP $0000
+    cpu.write8(0x0, 0xEA);
+    cpu.write8(0x1, 0x4C);
+    cpu.write8(0x2, 0x00);
+    cpu.write8(0x3, 0x00);
+
+    cpu.set_core(emulator::CPUCore::cached_blocks);
+
+    // 341 * 262 / 3 is 29780.67 cycles
+    cpu.run_frame();
+    EXPECT_GE(cpu.cycles(), 29781u);
+    EXPECT_LT(cpu.cycles(), 29781u + 5);
+
+    // Frames don't drift, the second ends two thirds of a cycle later
+    cpu.run_frame();
+    EXPECT_GE(cpu.cycles(), 59562u);
+    EXPECT_LT(cpu.cycles(), 59562u + 5);
+}
+
+TEST_F(TestCPU, test_run_until_services_interrupt_at_deadline)
+{
+    // NOP, JMP $0000, the NMI vector points at $0000 too
+    cpu.write8(0x0, 0xEA);
+    cpu.write8(0x1, 0x4C);
+    cpu.write8(0x2, 0x00);
+    cpu.write8(0x3, 0x00);
+
+    int raised = 0;
+
+    cpu.scheduler.set_handler(emulator::Event::vblank, [&] (uint64_t /*when*/) {
+        raised++;
+        cpu.handle_non_maskable_interrupt();
+    });
+
+    cpu.scheduler.schedule(emulator::Event::vblank, 100);
+    cpu.set_stack(0xFF);
+    cpu.run_until(200);
+
+    EXPECT_EQ(raised, 1);
+
+    // Serviced once, pushing the two program counter bytes and status
+    EXPECT_EQ(cpu.stack(), 0xFC);
+    EXPECT_TRUE(cpu.interrupt());
+}
+
+TEST_F(TestCPU, test_oam_dma_copies_page)
+{
+    for (uint16_t i = 0; i < 0x100; i++)
+    {
+        cpu.write8(0x0200 + i, i ^ 0x5A);
+    }
+
+    cpu.write8(0x4014, 0x02);
+
+    EXPECT_EQ(ppu.read_oam(0x00), 0x5A);
+    EXPECT_EQ(ppu.read_oam(0xFF), 0xFF ^ 0x5A);
+}
+
+TEST_F(TestCPU, test_oam_dma_stalls_cpu)
+{
+    cpu.write8(0x0600, 0xA9); // LDA #$02
+    cpu.write8(0x0601, 0x02);
+    cpu.write8(0x0602, 0x8D); // STA $4014
+    cpu.write8(0x0603, 0x14);
+    cpu.write8(0x0604, 0x40);
+    cpu.set_program_counter(0x0600);
+
+    auto start = cpu.cycles();
+    cpu.step();
+
+    EXPECT_EQ(cpu.step(), 4 + 513 + ((start + 2) & 1));
+}
+
+TEST_F(TestCPU, test_oam_dma_alignment_cycle)
+{
+    // A 3 cycle load starts the DMA on the other parity to the test above
+    cpu.write8(0x0000, 0x02);
+    cpu.write8(0x0600, 0xA5); // LDA $00
+    cpu.write8(0x0601, 0x00);
+    cpu.write8(0x0602, 0x8D); // STA $4014
+    cpu.write8(0x0603, 0x14);
+    cpu.write8(0x0604, 0x40);
+    cpu.set_program_counter(0x0600);
+
+    auto start = cpu.cycles();
+    cpu.step();
+
+    EXPECT_EQ(cpu.step(), 4 + 513 + ((start + 3) & 1));
+}
+
+TEST_F(TestCPU, test_ppu_register_writes_reach_ppu)
+{
+    cpu.write8(0x3456, 0x10);
+    cpu.write8(0x2006, 0x00);
+    cpu.write8(0x2007, 0x77);
+
+    EXPECT_EQ(ppu.read_vram(0x1000), 0x77);
+}
@@ -26,7 +26,11 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <cstring>
+#include <random>
+
 #include "cpu.h"
+#include "cpu_operations.h"
 #include "mocks/cpu.h"
 
 namespace
@@ -98,6 +102,16 @@ TEST_F(TestCPUInstructions, test_adc_with_carry)
     EXPECT_EQ(cpu.accumulator(), 0x5 + default_acc + 1);
 }
 
+TEST_F(TestCPUInstructions, test_adc_specialized)
+{
+    // No op code in memory, the mode comes from the template argument
+    cpu.write8(default_pc + 1, 0x05);
+
+    emulator::ops::adc<emulator::immediate>(&cpu);
+
+    EXPECT_EQ(cpu.accumulator(), 0x5 + default_acc);
+}
+
 TEST_F(TestCPUInstructions, test_and)
 {
     // op code AND - immediate
@@ -133,6 +147,20 @@ TEST_F(TestCPUInstructions, test_asl_acc)
     EXPECT_EQ(cpu.accumulator(), default_acc << 1);
 }
 
+TEST_F(TestCPUInstructions, test_asl_specialized)
+{
+    cpu.write8(default_pc + 1, default_pc + 3);
+    cpu.write8(default_pc + 3, default_acc);
+
+    emulator::ops::asl<emulator::accumulator>(&cpu);
+    EXPECT_EQ(cpu.accumulator(), default_acc << 1);
+    EXPECT_EQ(cpu.read8(default_pc + 3), default_acc);
+
+    cpu.decode_operand<emulator::absolute>();
+    emulator::ops::asl<emulator::absolute>(&cpu);
+    EXPECT_EQ(cpu.read8(default_pc + 3), default_acc << 1);
+}
+
 TEST_F(TestCPUInstructions, test_rol)
 {
     // op code ROL - absolute
@@ -685,6 +713,63 @@ TEST_F(TestCPUInstructions, test_cpu_step_adc_immediate)
     EXPECT_EQ(cpu.accumulator(), 0x5 + default_acc);
 }
 
+TEST(TestCPULazyFlags, test_lazy_flags_match_eager_flags_on_every_op_code)
+{
+    std::mt19937 random(0x6502);
+    uint16_t const pc{0x0400};
+
+    for (auto op = 0u; op < 0x100; op++)
+    {
+        for (auto trial = 0; trial < 8; trial++)
+        {
+            // PPU registers have state of their own, so one each
+            MockPPU eager_ppu;
+            MockPPU lazy_ppu;
+            emulator::CPU eager(&eager_ppu);
+            emulator::CPU lazy(&lazy_ppu);
+            lazy.set_lazy_flags(true);
+
+            for (auto address = 0u; address < 0x0800; address++)
+            {
+                auto value = random();
+                eager.write8(address, value);
+                lazy.write8(address, value);
+            }
+
+            eager.write8(pc, op);
+            lazy.write8(pc, op);
+
+            uint8_t a = random(), x = random(), y = random(), sp = random(), status = random();
+            for (auto cpu : {&eager, &lazy})
+            {
+                cpu->set_program_counter(pc);
+                cpu->set_accumulator(a);
+                cpu->set_x_register(x);
+                cpu->set_y_register(y);
+                cpu->set_stack(sp);
+                cpu->remove_flags(0xFF);
+                cpu->add_flags(status);
+            }
+
+            ASSERT_EQ(eager.step(), lazy.step()) << "op 0x" << std::hex << op;
+
+            ASSERT_EQ(eager.status(), lazy.status()) << "op 0x" << std::hex << op;
+            ASSERT_EQ(eager.carry(), lazy.carry());
+            ASSERT_EQ(eager.zero(), lazy.zero());
+            ASSERT_EQ(eager.overflow(), lazy.overflow());
+            ASSERT_EQ(eager.sign(), lazy.sign());
+            ASSERT_EQ(eager.program_counter(), lazy.program_counter()) << "op 0x" << std::hex << op;
+            ASSERT_EQ(eager.accumulator(), lazy.accumulator()) << "op 0x" << std::hex << op;
+            ASSERT_EQ(eager.x_register(), lazy.x_register());
+            ASSERT_EQ(eager.y_register(), lazy.y_register());
+            ASSERT_EQ(eager.stack(), lazy.stack());
+
+            ASSERT_EQ(memcmp(&eager.memory, &lazy.memory, sizeof(eager.memory)), 0)
+                << "op 0x" << std::hex << op;
+        }
+    }
+}
+
 TEST_F(TestMockedCPUInstructions, test_bcc)
 {
     using namespace ::testing;
@@ -0,0 +1,222 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <random>
+#include <vector>
+
+#include "cpu.h"
+#include "mocks/ppu.h"
+
+namespace
+{
+struct TestJIT : ::testing::Test
+{
+    TestJIT() :
+        cpu(&ppu),
+        other(&other_ppu)
+    {
+        cpu.set_core(emulator::CPUCore::jit);
+        cpu.set_lazy_flags(true);
+        other.set_lazy_flags(true);
+    }
+
+    void load(uint16_t address, std::vector<uint8_t> const& program)
+    {
+        for (auto i = 0u; i < program.size(); i++)
+        {
+            cpu.write8(address + i, program[i]);
+            other.write8(address + i, program[i]);
+        }
+
+        cpu.set_program_counter(address);
+        other.set_program_counter(address);
+    }
+
+    // The interpreter is stepped until it has run as many cycles as each
+    // JIT step, at which point both have to agree on everything
+    void run_in_lockstep(int steps)
+    {
+        uint64_t cycles = 0;
+        uint64_t other_cycles = 0;
+
+        for (auto i = 0; i < steps; i++)
+        {
+            cycles += cpu.step();
+
+            while (other_cycles < cycles)
+            {
+                other_cycles += other.step();
+            }
+
+            ASSERT_EQ(cycles, other_cycles);
+            ASSERT_EQ(cpu.program_counter(), other.program_counter());
+            ASSERT_EQ(cpu.accumulator(), other.accumulator());
+            ASSERT_EQ(cpu.x_register(), other.x_register());
+            ASSERT_EQ(cpu.y_register(), other.y_register());
+            ASSERT_EQ(cpu.stack(), other.stack());
+            ASSERT_EQ(cpu.status(), other.status());
+        }
+
+        for (auto address = 0u; address < 0x0800; address++)
+        {
+            ASSERT_EQ(cpu.read8(address), other.read8(address)) << "at " << address;
+        }
+    }
+
+    void expect_translated()
+    {
+        if (cpu.jit().available())
+        {
+            EXPECT_GT(cpu.jit().translated_blocks(), 0u);
+        }
+    }
+
+    MockPPU ppu;
+    MockPPU other_ppu;
+    emulator::CPU cpu;
+    emulator::CPU other;
+};
+}
+
+TEST_F(TestJIT, test_hot_loop_matches_interpreter)
+{
+    // LDX #$00, loop: LDA $0200,X, ADC $10, STA $10, INX, CPX #$10, BNE loop, JMP $0600
+    load(0x0600, {0xA2, 0x00, 0xBD, 0x00, 0x02, 0x65, 0x10, 0x85, 0x10,
+                  0xE8, 0xE0, 0x10, 0xD0, 0xF4, 0x4C, 0x00, 0x06});
+
+    for (auto i = 0u; i < 0x10; i++)
+    {
+        cpu.write8(0x0200 + i, i * 37);
+        other.write8(0x0200 + i, i * 37);
+    }
+
+    run_in_lockstep(500);
+    expect_translated();
+}
+
+TEST_F(TestJIT, test_native_ops_match_interpreter)
+{
+    // loop: CLC, LDA #$F0, ADC #$20, STA $20, LDY $20, SEC, TYA, TAX, DEX,
+    //       DEY, INY, TXA, AND #$3C, ORA $20, EOR #$FF, STX $0421, STY $22,
+    //       CMP $0421, CPY #$10, NOP, JMP loop
+    load(0x0300, {0x18, 0xA9, 0xF0, 0x69, 0x20, 0x85, 0x20, 0xA4, 0x20, 0x38,
+                  0x98, 0xAA, 0xCA, 0x88, 0xC8, 0x8A, 0x29, 0x3C, 0x05, 0x20,
+                  0x49, 0xFF, 0x8E, 0x21, 0x04, 0x84, 0x22, 0xCD, 0x21, 0x04,
+                  0xC0, 0x10, 0xEA, 0x4C, 0x00, 0x03});
+
+    run_in_lockstep(200);
+    expect_translated();
+}
+
+TEST_F(TestJIT, test_io_page_goes_through_bus)
+{
+    // loop: LDA #$80, STA $2000, LDA $2000, STA $10, JMP loop
+    load(0x0300, {0xA9, 0x80, 0x8D, 0x00, 0x20, 0xAD, 0x00, 0x20, 0x85, 0x10,
+                  0x4C, 0x00, 0x03});
+
+    run_in_lockstep(100);
+    expect_translated();
+
+    EXPECT_EQ(cpu.read8(0x2008), 0x80);
+    EXPECT_EQ(cpu.read8(0x0010), 0x80);
+}
+
+TEST_F(TestJIT, test_self_modifying_code)
+{
+    // loop: CLC, LDA #$01, ADC #$01, STA $0302, LDX #$00, JMP loop
+    load(0x0300, {0x18, 0xA9, 0x01, 0x69, 0x01, 0x8D, 0x02, 0x03, 0xA2, 0x00,
+                  0x4C, 0x00, 0x03});
+
+    run_in_lockstep(200);
+
+    EXPECT_GT(cpu.accumulator(), 0x10);
+}
+
+TEST_F(TestJIT, test_eager_flags_are_interpreted)
+{
+    cpu.set_lazy_flags(false);
+    other.set_lazy_flags(false);
+
+    // loop: INX, CPX #$00, BNE loop, JMP loop
+    load(0x0300, {0xE8, 0xE0, 0x00, 0xD0, 0xFB, 0x4C, 0x00, 0x03});
+
+    run_in_lockstep(100);
+
+    EXPECT_EQ(cpu.jit().translated_blocks(), 0u);
+}
+
+TEST_F(TestJIT, test_random_blocks_match_interpreter)
+{
+    // Official op codes with the operand modes the JIT generates inline,
+    // plus a few it has to call out for
+    std::vector<uint8_t> const op_codes{
+        0xA9, 0xA5, 0xAD, 0xA2, 0xA6, 0xAE, 0xA0, 0xA4, 0xAC,
+        0x85, 0x8D, 0x86, 0x8E, 0x84, 0x8C,
+        0xAA, 0xA8, 0x8A, 0x98, 0xE8, 0xC8, 0xCA, 0x88,
+        0x29, 0x25, 0x2D, 0x09, 0x05, 0x0D, 0x49, 0x4D,
+        0x69, 0x65, 0x6D, 0xC9, 0xC5, 0xCD, 0xE0, 0xE4, 0xEC, 0xC0, 0xC4, 0xCC,
+        0xB5, 0xBD, 0xB9, 0xB6, 0xBE, 0xB4, 0xBC, 0x95, 0x9D, 0x99, 0x96, 0x94,
+        0x7D, 0x79, 0xDD, 0x3D, 0x1D, 0x5D,
+        0x18, 0x38, 0xEA, 0xF8, 0xD8,
+        0xF0, 0xD0, 0x90, 0xB0, 0x30, 0x10, 0x70,
+        0xE9, 0x0A, 0x4A, 0x2A, 0x6A, 0xE6, 0xC6, 0x24
+    };
+
+    std::mt19937 random(0x6502);
+
+    for (auto trial = 0; trial < 50; trial++)
+    {
+        std::vector<uint8_t> program;
+
+        for (auto i = 0; i < 40; i++)
+        {
+            auto op = op_codes[random() % op_codes.size()];
+            program.push_back(op);
+
+            auto const& info = emulator::instruction[op];
+
+            if (info.number_bytes >= 2)
+            {
+                program.push_back(random());
+            }
+
+            if (info.number_bytes == 3)
+            {
+                // RAM, including the code itself, or the PPU registers
+                program.push_back(random() % 2 ? 0x03 : random() % 2 ? 0x00 : 0x20);
+            }
+        }
+
+        program.insert(program.end(), {0x4C, 0x00, 0x03});
+        load(0x0300, program);
+
+        run_in_lockstep(100);
+    }
+
+    expect_translated();
+}
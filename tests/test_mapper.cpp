@@ -0,0 +1,546 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "apu.h"
+#include "bus.h"
+#include "mapper.h"
+#include "mappers.h"
+#include "ppu.h"
+#include "rom.h"
+#include "scheduler.h"
+
+namespace
+{
+uint32_t const kilobyte{1024};
+
+// An iNES image with every 8KB PRG bank and 1KB CHR bank filled with its
+// own bank number
+std::vector<uint8_t> make_image(uint8_t mapper, uint8_t prg_16kb, uint8_t chr_8kb, uint8_t flags_six = 0)
+{
+    std::vector<uint8_t> image{'N', 'E', 'S', 0x1A, prg_16kb, chr_8kb,
+                               static_cast<uint8_t>(flags_six | mapper << 4),
+                               static_cast<uint8_t>(mapper & 0xF0),
+                               0, 0, 0, 0, 0, 0, 0, 0};
+
+    for (uint32_t i = 0; i < prg_16kb * 16u * kilobyte; i++)
+    {
+        image.push_back(i / (8 * kilobyte));
+    }
+
+    for (uint32_t i = 0; i < chr_8kb * 8u * kilobyte; i++)
+    {
+        image.push_back(i / kilobyte);
+    }
+
+    return image;
+}
+
+struct TestMapper : ::testing::Test
+{
+    void load(uint8_t mapper, uint8_t prg_16kb, uint8_t chr_8kb, uint8_t flags_six = 0)
+    {
+        rom.reset(new emulator::Rom(make_image(mapper, prg_16kb, chr_8kb, flags_six)));
+        cartridge = emulator::make_mapper(rom.get(), &bus, &ppu);
+        cartridge->reset();
+    }
+
+    // MMC1 registers are written a bit at a time
+    void write_serial(uint16_t address, uint8_t value)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            bus.write8(address, value >> i & 0x01);
+        }
+    }
+
+    emulator::Bus bus;
+    emulator::PPU ppu;
+    std::unique_ptr<emulator::Rom> rom;
+    std::unique_ptr<emulator::Mapper> cartridge;
+};
+}
+
+TEST(TestRom, test_rejects_bad_magic)
+{
+    auto image = make_image(0, 1, 1);
+    image[0] = 'X';
+
+    EXPECT_THROW(emulator::Rom{image}, std::runtime_error);
+}
+
+TEST(TestRom, test_rejects_truncated_image)
+{
+    auto image = make_image(0, 2, 1);
+    image.resize(image.size() - 1);
+
+    EXPECT_THROW(emulator::Rom{image}, std::runtime_error);
+}
+
+TEST(TestRom, test_header_fields)
+{
+    emulator::Rom rom(make_image(0x42, 2, 1, 0x01));
+
+    EXPECT_EQ(rom.mapper(), 0x42);
+    EXPECT_EQ(rom.prg_size(), 32 * kilobyte);
+    EXPECT_EQ(rom.chr_size(), 8 * kilobyte);
+    EXPECT_EQ(rom.mirroring(), emulator::Mirroring::vertical);
+}
+
+TEST(TestRom, test_copies_share_image_and_decoded_chr)
+{
+    emulator::Rom rom(make_image(4, 2, 2));
+    auto copy = rom;
+
+    EXPECT_EQ(copy.chr(), rom.chr());
+    EXPECT_EQ(copy.chr_tiles(), rom.chr_tiles());
+    EXPECT_EQ(rom.chr_tiles()->size(), 16 * kilobyte / 16);
+
+    // Tile 64 starts CHR's second 1KB bank, both planes 0x01 so the last
+    // pixel of each row is 3
+    EXPECT_EQ((*rom.chr_tiles())[64][0], 0);
+    EXPECT_EQ((*rom.chr_tiles())[64][7], 3);
+}
+
+TEST_F(TestMapper, test_unsupported_mapper_throws)
+{
+    rom.reset(new emulator::Rom(make_image(99, 1, 1)));
+
+    EXPECT_THROW(emulator::make_mapper(rom.get(), &bus, &ppu), std::runtime_error);
+}
+
+TEST_F(TestMapper, test_nrom_16kb_is_mirrored)
+{
+    load(0, 1, 1);
+
+    EXPECT_EQ(bus.read8(0x8000), 0);
+    EXPECT_EQ(bus.read8(0xA000), 1);
+    EXPECT_EQ(bus.read8(0xC000), 0);
+    EXPECT_EQ(bus.read8(0xE000), 1);
+    EXPECT_EQ(ppu.read_vram(0x1C00), 7);
+}
+
+TEST_F(TestMapper, test_prg_ram)
+{
+    load(0, 2, 1);
+
+    bus.write8(0x6123, 0x55);
+
+    EXPECT_EQ(bus.read8(0x6123), 0x55);
+}
+
+TEST_F(TestMapper, test_rom_writes_are_ignored)
+{
+    load(0, 2, 1);
+
+    bus.write8(0x8000, 0x55);
+
+    EXPECT_EQ(bus.read8(0x8000), 0);
+}
+
+TEST_F(TestMapper, test_uxrom_switches_low_bank)
+{
+    // 8 16KB banks
+    load(2, 8, 0);
+
+    EXPECT_EQ(bus.read8(0x8000), 0);
+    EXPECT_EQ(bus.read8(0xC000), 14);
+
+    bus.write8(0x8000, 3);
+
+    EXPECT_EQ(bus.read8(0x8000), 6);
+    EXPECT_EQ(bus.read8(0xA000), 7);
+    EXPECT_EQ(bus.read8(0xC000), 14);
+}
+
+TEST_F(TestMapper, test_uxrom_chr_ram)
+{
+    load(2, 2, 0);
+
+    ppu.write_vram(0x0123, 0x42);
+
+    EXPECT_EQ(ppu.read_vram(0x0123), 0x42);
+}
+
+TEST_F(TestMapper, test_cnrom_switches_chr)
+{
+    load(3, 2, 4);
+
+    bus.write8(0x8000, 2);
+
+    EXPECT_EQ(ppu.read_vram(0x0000), 16);
+    EXPECT_EQ(ppu.read_vram(0x1C00), 23);
+}
+
+TEST_F(TestMapper, test_mmc1_defaults_to_last_bank_fixed)
+{
+    load(1, 8, 2);
+
+    EXPECT_EQ(bus.read8(0x8000), 0);
+    EXPECT_EQ(bus.read8(0xC000), 14);
+}
+
+TEST_F(TestMapper, test_mmc1_prg_bank)
+{
+    load(1, 8, 2);
+
+    write_serial(0xE000, 5);
+
+    EXPECT_EQ(bus.read8(0x8000), 10);
+    EXPECT_EQ(bus.read8(0xC000), 14);
+}
+
+TEST_F(TestMapper, test_mmc1_32kb_mode)
+{
+    load(1, 8, 2);
+
+    write_serial(0x8000, 0x00);
+    write_serial(0xE000, 3);
+
+    EXPECT_EQ(bus.read8(0x8000), 4);
+    EXPECT_EQ(bus.read8(0xC000), 6);
+}
+
+TEST_F(TestMapper, test_mmc1_4kb_chr)
+{
+    load(1, 2, 2);
+
+    write_serial(0x8000, 0x1C);
+    write_serial(0xA000, 3);
+    write_serial(0xC000, 0);
+
+    EXPECT_EQ(ppu.read_vram(0x0000), 12);
+    EXPECT_EQ(ppu.read_vram(0x1000), 0);
+}
+
+TEST_F(TestMapper, test_mmc1_reset_bit_drops_partial_write)
+{
+    load(1, 8, 2);
+
+    bus.write8(0xE000, 1);
+    bus.write8(0xE000, 0x80);
+    write_serial(0xE000, 2);
+
+    EXPECT_EQ(bus.read8(0x8000), 4);
+}
+
+TEST_F(TestMapper, test_mmc1_mirroring)
+{
+    load(1, 2, 2);
+
+    write_serial(0x8000, 0x0E);
+    ppu.write_vram(0x2000, 0x11);
+
+    // Vertical, 0x2800 is 0x2000
+    EXPECT_EQ(ppu.read_vram(0x2800), 0x11);
+}
+
+TEST_F(TestMapper, test_mmc3_fixed_banks)
+{
+    // 16 8KB banks
+    load(4, 8, 8);
+
+    EXPECT_EQ(bus.read8(0xC000), 14);
+    EXPECT_EQ(bus.read8(0xE000), 15);
+}
+
+TEST_F(TestMapper, test_mmc3_prg_modes)
+{
+    load(4, 8, 8);
+
+    bus.write8(0x8000, 6);
+    bus.write8(0x8001, 3);
+    bus.write8(0x8000, 7);
+    bus.write8(0x8001, 4);
+
+    EXPECT_EQ(bus.read8(0x8000), 3);
+    EXPECT_EQ(bus.read8(0xA000), 4);
+    EXPECT_EQ(bus.read8(0xC000), 14);
+
+    bus.write8(0x8000, 0x40 | 7);
+
+    EXPECT_EQ(bus.read8(0x8000), 14);
+    EXPECT_EQ(bus.read8(0xC000), 3);
+}
+
+TEST_F(TestMapper, test_dmc_fetches_before_bank_switch)
+{
+    load(4, 8, 8);
+
+    uint64_t cycle = 0;
+    std::vector<uint8_t> fetched;
+
+    emulator::APU apu;
+    apu.set_clock([&] {
+        return cycle;
+    });
+    apu.set_memory_reader([&] (uint16_t address) {
+        fetched.push_back(bus.read8(address));
+        return fetched.back();
+    });
+    cartridge->set_clock([&] {
+        return cycle;
+    });
+    cartridge->set_apu(&apu);
+
+    // Bank 3 at 0xC000, then a 17 byte sample from there at the fastest rate,
+    // a byte every 432 cycles
+    bus.write8(0x8000, 0x40 | 6);
+    bus.write8(0x8001, 3);
+    apu.write_register(0x4010, 0x0F);
+    apu.write_register(0x4012, 0x00);
+    apu.write_register(0x4013, 0x01);
+    apu.write_register(0x4015, 0x10);
+
+    // The writes are still queued when bank 5 goes in partway through
+    cycle = 2000;
+    bus.write8(0x8001, 5);
+
+    cycle = 10000;
+    apu.catch_up(cycle);
+
+    ASSERT_EQ(fetched.size(), 17u);
+    EXPECT_EQ(fetched.front(), 3);
+    EXPECT_EQ(fetched.back(), 5);
+    EXPECT_EQ(std::count(fetched.begin(), fetched.end(), 3), 5);
+}
+
+TEST_F(TestMapper, test_mmc3_chr_banks)
+{
+    load(4, 8, 8);
+
+    bus.write8(0x8000, 0);
+    bus.write8(0x8001, 10);
+    bus.write8(0x8000, 2);
+    bus.write8(0x8001, 33);
+
+    EXPECT_EQ(ppu.read_vram(0x0000), 10);
+    EXPECT_EQ(ppu.read_vram(0x0400), 11);
+    EXPECT_EQ(ppu.read_vram(0x1000), 33);
+
+    // Inverted, the 2KB banks move up
+    bus.write8(0x8000, 0x80);
+
+    EXPECT_EQ(ppu.read_vram(0x1000), 10);
+    EXPECT_EQ(ppu.read_vram(0x0000), 33);
+}
+
+TEST_F(TestMapper, test_mmc3_mirroring)
+{
+    load(4, 8, 8);
+
+    bus.write8(0xA000, 1);
+    ppu.write_vram(0x2000, 0x22);
+
+    // Horizontal, 0x2400 is 0x2000
+    EXPECT_EQ(ppu.read_vram(0x2400), 0x22);
+}
+
+namespace
+{
+struct TestMMC3Interrupt : TestMapper
+{
+    TestMMC3Interrupt()
+    {
+        load(4, 8, 8);
+
+        mmc3 = static_cast<emulator::MMC3*>(cartridge.get());
+        mmc3->set_scheduler(&scheduler);
+        mmc3->set_clock([this] {
+            return cycle;
+        });
+        mmc3->set_interrupt_request_handler([this] (bool asserted) {
+            interrupts += asserted;
+            line = asserted;
+        });
+        ppu.set_rendering_handler([this] (bool rendering) {
+            mmc3->rendering_changed(rendering);
+        });
+        mmc3->reset();
+    }
+
+    void start(uint8_t latch)
+    {
+        ppu.write_register(0x2001, 0x18);
+        bus.write8(0xC000, latch);
+        bus.write8(0xC001, 0);
+        bus.write8(0xE001, 0);
+    }
+
+    // Brings the counter up to the cycle without changing it
+    uint8_t counter_at(uint64_t at, uint8_t latch)
+    {
+        cycle = at;
+        bus.write8(0xC000, latch);
+        return mmc3->irq_counter();
+    }
+
+    // Clocks happen on dot 260 of lines 0 - 239 and 261
+    static uint64_t clock_cycle(uint64_t frame, uint64_t line)
+    {
+        return (frame * emulator::ppu_dots_per_frame + line * 341 + 260 + 2) / 3;
+    }
+
+    emulator::MMC3* mmc3;
+    emulator::Scheduler scheduler;
+    uint64_t cycle{0};
+    int interrupts{0};
+    bool line{false};
+};
+}
+
+TEST_F(TestMMC3Interrupt, test_schedules_irq_for_the_line_it_hits_zero)
+{
+    start(2);
+
+    // Reload to 2, then 1, then 0 on line 2
+    EXPECT_EQ(scheduler.when(emulator::Event::mapper_irq), clock_cycle(0, 2));
+}
+
+TEST_F(TestMMC3Interrupt, test_fires_and_reschedules)
+{
+    start(2);
+
+    cycle = clock_cycle(0, 2);
+    scheduler.run_due(cycle);
+
+    EXPECT_EQ(interrupts, 1);
+    EXPECT_EQ(scheduler.when(emulator::Event::mapper_irq), clock_cycle(0, 5));
+}
+
+TEST_F(TestMMC3Interrupt, test_pre_render_line_is_clocked)
+{
+    start(239);
+
+    // Lines 0 - 239 take it from the reload to 0 on line 239
+    EXPECT_EQ(scheduler.when(emulator::Event::mapper_irq), clock_cycle(0, 239));
+
+    cycle = clock_cycle(0, 239);
+    scheduler.run_due(cycle);
+
+    bus.write8(0xC000, 0);
+    bus.write8(0xC001, 0);
+
+    EXPECT_EQ(scheduler.when(emulator::Event::mapper_irq), clock_cycle(0, 261));
+}
+
+TEST_F(TestMMC3Interrupt, test_acknowledge_releases_the_line)
+{
+    start(2);
+
+    cycle = clock_cycle(0, 2);
+    scheduler.run_due(cycle);
+    EXPECT_TRUE(line);
+
+    // Held until acknowledged, enabling again does not raise it
+    bus.write8(0xE000, 0);
+    EXPECT_FALSE(line);
+
+    bus.write8(0xE001, 0);
+    EXPECT_FALSE(line);
+    EXPECT_EQ(interrupts, 1);
+}
+
+TEST_F(TestMMC3Interrupt, test_disable_cancels)
+{
+    start(2);
+
+    bus.write8(0xE000, 0);
+
+    EXPECT_FALSE(scheduler.is_scheduled(emulator::Event::mapper_irq));
+}
+
+TEST_F(TestMMC3Interrupt, test_not_clocked_while_rendering_is_off)
+{
+    start(10);
+
+    cycle = clock_cycle(0, 3);
+    ppu.write_register(0x2001, 0x00);
+
+    EXPECT_FALSE(scheduler.is_scheduled(emulator::Event::mapper_irq));
+    EXPECT_EQ(counter_at(clock_cycle(2, 0), 10), 7);
+
+    // Picks up from where it stopped
+    ppu.write_register(0x2001, 0x08);
+
+    EXPECT_EQ(scheduler.when(emulator::Event::mapper_irq), clock_cycle(2, 7));
+}
+
+TEST_F(TestMMC3Interrupt, test_counter_matches_clocking_every_line)
+{
+    uint8_t const latch{7};
+    start(latch);
+
+    uint8_t expected = 0;
+    bool reload      = true;
+
+    for (uint64_t frame = 0; frame < 2; frame++)
+    {
+        for (uint64_t line = 0; line < 262; line++)
+        {
+            if (line >= 240 && line != 261)
+            {
+                continue;
+            }
+
+            if (expected == 0 || reload)
+            {
+                expected = latch;
+                reload   = false;
+            }
+            else
+            {
+                expected--;
+            }
+
+            ASSERT_EQ(counter_at(clock_cycle(frame, line), latch), expected) << frame << " " << line;
+        }
+    }
+}
+
+TEST_F(TestMMC3Interrupt, test_closed_form_matches_clocking_every_line)
+{
+    uint8_t const latch{5};
+    start(latch);
+
+    // One jump over a frame and a bit lands where clocking line by line would
+    uint64_t clocks = 241 + 9;
+    uint8_t expected = 0;
+    bool reload      = true;
+
+    for (uint64_t i = 0; i < clocks; i++)
+    {
+        expected = expected == 0 || reload ? latch : expected - 1;
+        reload   = false;
+    }
+
+    EXPECT_EQ(counter_at(clock_cycle(1, 8), latch), expected);
+}
@@ -0,0 +1,203 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+#include <random>
+
+#include "pixel_kernels.h"
+
+namespace
+{
+std::array<emulator::SimdLevel, 3> const levels{{
+    emulator::SimdLevel::scalar,
+    emulator::SimdLevel::sse2,
+    emulator::SimdLevel::avx2
+}};
+
+struct TestPixelKernels : ::testing::Test
+{
+    TestPixelKernels()
+    {
+        for (uint32_t i = 0; i < colors.size(); i++)
+        {
+            colors[i] = i * 0x01010100 | 0xFF;
+        }
+
+        for (uint32_t i = 0; i < palette.size(); i++)
+        {
+            palette[i] = (i * 7 + 3) & 0x3F;
+        }
+    }
+
+    std::mt19937 random{1234};
+    std::array<uint32_t, 64> colors;
+    std::array<uint8_t, 32> palette;
+};
+}
+
+TEST_F(TestPixelKernels, test_scalar_always_supported)
+{
+    EXPECT_TRUE(emulator::is_supported(emulator::SimdLevel::scalar));
+    EXPECT_TRUE(emulator::is_supported(emulator::best_simd_level()));
+}
+
+TEST_F(TestPixelKernels, test_scalar_decode_tile)
+{
+    std::array<uint8_t, 16> planes{};
+    std::array<uint8_t, 64> pixels;
+
+    planes[2]  = 0xA0;
+    planes[10] = 0x60;
+
+    emulator::pixel_kernels(emulator::SimdLevel::scalar).decode_tile(planes.data(), pixels.data());
+
+    EXPECT_EQ(pixels[16], 1);
+    EXPECT_EQ(pixels[17], 2);
+    EXPECT_EQ(pixels[18], 3);
+    EXPECT_EQ(pixels[19], 0);
+}
+
+TEST_F(TestPixelKernels, test_scalar_compose_priority)
+{
+    std::array<uint8_t, 32> background{};
+    std::array<uint8_t, 32> sprites{};
+    std::array<uint8_t, 32> out;
+    std::array<uint32_t, 32> rgba;
+
+    // Opaque sprite over transparent background
+    sprites[0] = 0x05;
+    // Sprite behind opaque background
+    background[1] = 0x0A;
+    sprites[1]    = 0x07 | emulator::sprite_behind;
+    // Sprite in front of opaque background
+    background[2] = 0x0A;
+    sprites[2]    = 0x07;
+
+    auto hit = emulator::pixel_kernels(emulator::SimdLevel::scalar).compose_line(
+        background.data(), sprites.data(), palette.data(), colors.data(),
+        out.data(), rgba.data(), out.size());
+
+    EXPECT_FALSE(hit);
+    EXPECT_EQ(out[0], palette[0x15]);
+    EXPECT_EQ(out[1], palette[0x0A]);
+    EXPECT_EQ(out[2], palette[0x17]);
+    EXPECT_EQ(out[3], palette[0x00]);
+    EXPECT_EQ(rgba[0], colors[palette[0x15]]);
+}
+
+TEST_F(TestPixelKernels, test_scalar_compose_sprite_zero_hit)
+{
+    std::array<uint8_t, 32> background{};
+    std::array<uint8_t, 32> sprites{};
+    std::array<uint8_t, 32> out;
+    std::array<uint32_t, 32> rgba;
+
+    background[5] = 0x01;
+    sprites[5]    = 0x01 | emulator::sprite_zero | emulator::sprite_behind;
+
+    EXPECT_TRUE(emulator::pixel_kernels(emulator::SimdLevel::scalar).compose_line(
+        background.data(), sprites.data(), palette.data(), colors.data(),
+        out.data(), rgba.data(), out.size()));
+}
+
+TEST_F(TestPixelKernels, test_simd_decode_matches_scalar)
+{
+    auto const& scalar = emulator::pixel_kernels(emulator::SimdLevel::scalar);
+
+    for (auto level : levels)
+    {
+        if (!emulator::is_supported(level))
+        {
+            continue;
+        }
+
+        auto const& kernels = emulator::pixel_kernels(level);
+
+        for (int tile = 0; tile < 64; tile++)
+        {
+            std::array<uint8_t, 16> planes;
+            for (auto& plane : planes)
+            {
+                plane = random();
+            }
+
+            std::array<uint8_t, 64> expected;
+            std::array<uint8_t, 64> pixels;
+            scalar.decode_tile(planes.data(), expected.data());
+            kernels.decode_tile(planes.data(), pixels.data());
+
+            EXPECT_EQ(pixels, expected) << static_cast<int>(level);
+        }
+    }
+}
+
+TEST_F(TestPixelKernels, test_simd_compose_matches_scalar)
+{
+    auto const& scalar = emulator::pixel_kernels(emulator::SimdLevel::scalar);
+
+    for (auto level : levels)
+    {
+        if (!emulator::is_supported(level))
+        {
+            continue;
+        }
+
+        auto const& kernels = emulator::pixel_kernels(level);
+
+        for (int line = 0; line < 64; line++)
+        {
+            std::array<uint8_t, 256> background;
+            std::array<uint8_t, 256> sprites;
+            for (size_t x = 0; x < background.size(); x++)
+            {
+                background[x] = random() & 0x0F;
+                sprites[x]    = random() & (0x0F | emulator::sprite_behind);
+            }
+
+            // Only some lines get a sprite 0 pixel
+            if (line & 1)
+            {
+                sprites[random() & 0xFF] |= emulator::sprite_zero | 0x01;
+            }
+
+            std::array<uint8_t, 256> expected;
+            std::array<uint8_t, 256> out;
+            std::array<uint32_t, 256> expected_rgba;
+            std::array<uint32_t, 256> rgba;
+
+            auto expected_hit = scalar.compose_line(background.data(), sprites.data(), palette.data(),
+                                                    colors.data(), expected.data(), expected_rgba.data(), 256);
+            auto hit = kernels.compose_line(background.data(), sprites.data(), palette.data(),
+                                            colors.data(), out.data(), rgba.data(), 256);
+
+            EXPECT_EQ(hit, expected_hit) << static_cast<int>(level);
+            EXPECT_EQ(out, expected) << static_cast<int>(level);
+            EXPECT_EQ(rgba, expected_rgba) << static_cast<int>(level);
+        }
+    }
+}
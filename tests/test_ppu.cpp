@@ -0,0 +1,460 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+
+#include "ppu.h"
+#include "scheduler.h"
+
+namespace
+{
+struct TestPPU : ::testing::Test
+{
+    TestPPU()
+    {
+        ppu.set_non_maskable_interrupt_handler([this] {
+            nmi_count++;
+        });
+
+        ppu.set_scheduler(&scheduler);
+    }
+
+    emulator::Scheduler scheduler;
+    emulator::PPU ppu;
+    int nmi_count{0};
+    uint64_t clock{0};
+};
+}
+
+TEST_F(TestPPU, test_vblank_scheduled_on_scanline_241)
+{
+    // (241 * 341 + 1) / 3 rounded up
+    EXPECT_EQ(scheduler.when(emulator::Event::vblank), 27394u);
+}
+
+TEST_F(TestPPU, test_no_nmi_when_disabled)
+{
+    scheduler.run_due(100000);
+    EXPECT_EQ(nmi_count, 0);
+}
+
+TEST_F(TestPPU, test_nmi_once_per_frame)
+{
+    ppu.write_register(0x2000, emulator::nmi_on_vblank);
+
+    scheduler.run_due(27393);
+    EXPECT_EQ(nmi_count, 0);
+
+    scheduler.run_due(27394);
+    EXPECT_EQ(nmi_count, 1);
+
+    // Three more frames
+    scheduler.run_due(27394 + 3 * 29781);
+    EXPECT_EQ(nmi_count, 4);
+}
+
+TEST_F(TestPPU, test_catch_up_only_on_register_access)
+{
+    ppu.set_clock([this] {
+        return clock;
+    });
+
+    clock = 50000;
+    EXPECT_EQ(ppu.timestamp(), 0u);
+
+    ppu.read_register(0x2002);
+    EXPECT_EQ(ppu.timestamp(), 50000u);
+}
+
+TEST_F(TestPPU, test_vblank_flag_set_by_catch_up)
+{
+    ppu.set_clock([this] {
+        return clock;
+    });
+
+    clock = 27393;
+    EXPECT_EQ(ppu.read_register(0x2002) & 0x80, 0);
+
+    clock = 27394;
+    EXPECT_EQ(ppu.read_register(0x2002) & 0x80, 0x80);
+
+    // Reading cleared it
+    EXPECT_EQ(ppu.read_register(0x2002) & 0x80, 0);
+}
+
+TEST_F(TestPPU, test_vblank_flag_cleared_on_pre_render_line)
+{
+    ppu.catch_up(27394);
+    ppu.catch_up(261 * 341 / 3 + 1);
+
+    EXPECT_EQ(ppu.read_register(0x2002) & 0x80, 0);
+}
+
+TEST_F(TestPPU, test_nmi_enabled_during_vblank_fires)
+{
+    ppu.catch_up(27394);
+    ppu.write_register(0x2000, emulator::nmi_on_vblank);
+
+    EXPECT_EQ(nmi_count, 1);
+}
+
+TEST_F(TestPPU, test_vblank_event_catches_up)
+{
+    scheduler.run_due(27394);
+
+    EXPECT_EQ(ppu.timestamp(), 27394u);
+}
+
+namespace
+{
+// Solid tile of pixel value 3 at pattern index 1
+void write_solid_tile(emulator::PPU& ppu, uint16_t pattern)
+{
+    for (uint16_t row = 0; row < 16; row++)
+    {
+        ppu.write_vram(pattern + 16 + row, 0xFF);
+    }
+}
+
+// Renders up to the start of vblank
+void render_frame(emulator::PPU& ppu)
+{
+    ppu.catch_up(27394);
+}
+}
+
+TEST_F(TestPPU, test_palette_mirrors_background_entries)
+{
+    ppu.write_vram(0x3F10, 0x21);
+
+    EXPECT_EQ(ppu.read_vram(0x3F00), 0x21);
+    EXPECT_EQ(ppu.read_vram(0x3F20), 0x21);
+}
+
+TEST_F(TestPPU, test_rendering_disabled_shows_backdrop)
+{
+    ppu.write_vram(0x3F00, 0x0F);
+    render_frame(ppu);
+
+    EXPECT_EQ(ppu.framebuffer()[0], 0x0F);
+    EXPECT_EQ(ppu.framebuffer()[256 * 240 - 1], 0x0F);
+    EXPECT_EQ(ppu.rgba_framebuffer()[0], 0x000000FFu);
+}
+
+TEST_F(TestPPU, test_background_tile_uses_attribute_palette)
+{
+    write_solid_tile(ppu, 0x0000);
+
+    // Top left tile, attribute quadrant 0 uses palette 2
+    ppu.write_vram(0x2000, 0x01);
+    ppu.write_vram(0x23C0, 0x02);
+    ppu.write_vram(0x3F0B, 0x16);
+
+    ppu.write_register(0x2001, emulator::show_background | emulator::show_left_background);
+    render_frame(ppu);
+
+    EXPECT_EQ(ppu.framebuffer()[0], 0x16);
+    EXPECT_EQ(ppu.framebuffer()[7 * 256 + 7], 0x16);
+    EXPECT_EQ(ppu.framebuffer()[8], 0x00);
+    EXPECT_EQ(ppu.rgba_framebuffer()[0], 0x982220FFu);
+}
+
+TEST_F(TestPPU, test_left_column_hidden)
+{
+    write_solid_tile(ppu, 0x0000);
+    ppu.write_vram(0x2000, 0x01);
+    ppu.write_vram(0x3F03, 0x16);
+
+    ppu.write_register(0x2001, emulator::show_background);
+    render_frame(ppu);
+
+    EXPECT_EQ(ppu.framebuffer()[0], 0x00);
+}
+
+TEST_F(TestPPU, test_sprite_drawn_below_its_y)
+{
+    write_solid_tile(ppu, 0x0000);
+    ppu.write_vram(0x3F13, 0x2A);
+
+    ppu.write_oam(0, 9);
+    ppu.write_oam(1, 1);
+    ppu.write_oam(2, 0);
+    ppu.write_oam(3, 20);
+
+    ppu.write_register(0x2001, emulator::show_sprite);
+    render_frame(ppu);
+
+    EXPECT_EQ(ppu.framebuffer()[9 * 256 + 20], 0x00);
+    EXPECT_EQ(ppu.framebuffer()[10 * 256 + 20], 0x2A);
+    EXPECT_EQ(ppu.framebuffer()[17 * 256 + 27], 0x2A);
+    EXPECT_EQ(ppu.framebuffer()[18 * 256 + 20], 0x00);
+}
+
+TEST_F(TestPPU, test_sprite_zero_hit_and_overflow)
+{
+    write_solid_tile(ppu, 0x0000);
+    ppu.write_vram(0x2000, 0x01);
+
+    // Nine sprites on the same lines over the first tile
+    for (uint8_t sprite = 0; sprite < 9; sprite++)
+    {
+        ppu.write_oam(sprite * 4, 0);
+        ppu.write_oam(sprite * 4 + 1, 1);
+        ppu.write_oam(sprite * 4 + 3, 0);
+    }
+
+    ppu.write_register(0x2001, emulator::show_background | emulator::show_sprite |
+                               emulator::show_left_background | emulator::show_left_sprite);
+    render_frame(ppu);
+
+    EXPECT_EQ(ppu.read_register(0x2002) & 0x60, 0x60);
+}
+
+TEST_F(TestPPU, test_pattern_write_redraws_tile)
+{
+    write_solid_tile(ppu, 0x0000);
+    ppu.write_vram(0x2000, 0x01);
+    ppu.write_vram(0x3F03, 0x16);
+    ppu.write_vram(0x3F01, 0x2A);
+
+    ppu.write_register(0x2001, emulator::show_background | emulator::show_left_background);
+    render_frame(ppu);
+    EXPECT_EQ(ppu.framebuffer()[0], 0x16);
+
+    // Clear the high plane of the first row
+    ppu.write_vram(0x0018, 0x00);
+    ppu.catch_up(27394 + 29781);
+
+    EXPECT_EQ(ppu.framebuffer()[0], 0x2A);
+}
+
+TEST_F(TestPPU, test_nine_sprites_on_different_lines_dont_overflow)
+{
+    for (uint8_t sprite = 0; sprite < 64; sprite++)
+    {
+        ppu.write_oam(sprite * 4, sprite < 9 ? sprite * 8 : 0xF0);
+    }
+
+    ppu.write_register(0x2001, emulator::show_sprite);
+    render_frame(ppu);
+
+    EXPECT_EQ(ppu.read_register(0x2002) & 0x20, 0);
+}
+
+TEST_F(TestPPU, test_oam_write_moves_sprite_next_frame)
+{
+    write_solid_tile(ppu, 0x0000);
+    ppu.write_vram(0x3F13, 0x2A);
+
+    for (uint8_t sprite = 0; sprite < 64; sprite++)
+    {
+        ppu.write_oam(sprite * 4, 0xF0);
+    }
+    ppu.write_oam(1, 1);
+
+    ppu.write_register(0x2001, emulator::show_sprite | emulator::show_left_sprite);
+    render_frame(ppu);
+    EXPECT_EQ(ppu.framebuffer()[100 * 256], 0x00);
+
+    ppu.write_oam(0, 99);
+    ppu.catch_up(27394 + 29781);
+
+    EXPECT_EQ(ppu.framebuffer()[100 * 256], 0x2A);
+}
+
+TEST_F(TestPPU, test_tall_sprites_rebuild_lines)
+{
+    write_solid_tile(ppu, 0x0000);
+    ppu.write_vram(0x3F13, 0x2A);
+
+    for (uint8_t sprite = 0; sprite < 64; sprite++)
+    {
+        ppu.write_oam(sprite * 4, 0xF0);
+    }
+    ppu.write_oam(0, 9);
+    ppu.write_oam(1, 0);
+
+    ppu.write_register(0x2001, emulator::show_sprite | emulator::show_left_sprite);
+    render_frame(ppu);
+    EXPECT_EQ(ppu.framebuffer()[18 * 256], 0x00);
+
+    // 8x16 draws tiles 0 and 1, the solid half is on the second 8 lines
+    ppu.write_register(0x2000, emulator::sprite_size);
+    ppu.catch_up(27394 + 29781);
+
+    EXPECT_EQ(ppu.framebuffer()[18 * 256], 0x2A);
+}
+
+TEST_F(TestPPU, test_registers_mirrored_every_8_bytes)
+{
+    ppu.write_register(0x3FF8, emulator::increment);
+    ppu.write_register(0x2006, 0x21);
+    ppu.write_register(0x200E, 0x00);
+    ppu.write_register(0x3007, 0x11);
+    ppu.write_register(0x2007, 0x22);
+
+    EXPECT_EQ(ppu.read_vram(0x2100), 0x11);
+    EXPECT_EQ(ppu.read_vram(0x2120), 0x22);
+}
+
+TEST_F(TestPPU, test_write_only_registers_read_last_write)
+{
+    ppu.write_register(0x2005, 0x37);
+
+    EXPECT_EQ(ppu.read_register(0x2000), 0x37);
+    EXPECT_EQ(ppu.read_register(0x2006), 0x37);
+}
+
+TEST_F(TestPPU, test_data_reads_are_buffered)
+{
+    ppu.write_vram(0x2000, 0xAB);
+    ppu.write_vram(0x2001, 0xCD);
+
+    ppu.write_register(0x2006, 0x20);
+    ppu.write_register(0x2006, 0x00);
+
+    ppu.read_register(0x2007);
+    EXPECT_EQ(ppu.read_register(0x2007), 0xAB);
+    EXPECT_EQ(ppu.read_register(0x2007), 0xCD);
+}
+
+TEST_F(TestPPU, test_palette_reads_are_immediate)
+{
+    ppu.write_vram(0x3F01, 0x2C);
+
+    ppu.write_register(0x2006, 0x3F);
+    ppu.write_register(0x2006, 0x01);
+
+    EXPECT_EQ(ppu.read_register(0x2007), 0x2C);
+}
+
+TEST_F(TestPPU, test_status_read_resets_address_toggle)
+{
+    ppu.write_register(0x2006, 0x3F);
+    ppu.read_register(0x2002);
+
+    ppu.write_register(0x2006, 0x23);
+    ppu.write_register(0x2006, 0x45);
+    ppu.write_register(0x2007, 0x99);
+
+    EXPECT_EQ(ppu.read_vram(0x2345), 0x99);
+}
+
+TEST_F(TestPPU, test_oam_data_increments_address)
+{
+    ppu.write_register(0x2003, 0x10);
+    ppu.write_register(0x2004, 0x01);
+    ppu.write_register(0x2004, 0x02);
+
+    EXPECT_EQ(ppu.read_oam(0x10), 0x01);
+    EXPECT_EQ(ppu.read_oam(0x11), 0x02);
+
+    ppu.write_register(0x2003, 0x11);
+    EXPECT_EQ(ppu.read_register(0x2004), 0x02);
+}
+
+TEST_F(TestPPU, test_oam_dma_starts_at_oam_address)
+{
+    std::array<uint8_t, 256> page;
+    for (uint16_t i = 0; i < page.size(); i++)
+    {
+        page[i] = i;
+    }
+
+    ppu.write_register(0x2003, 0x04);
+    ppu.oam_dma(page.data());
+
+    EXPECT_EQ(ppu.read_oam(0x04), 0x00);
+    EXPECT_EQ(ppu.read_oam(0x03), 0xFF);
+}
+
+TEST_F(TestPPU, test_scroll_moves_background)
+{
+    write_solid_tile(ppu, 0x0000);
+    ppu.write_vram(0x2001, 0x01);
+    ppu.write_vram(0x3F03, 0x16);
+
+    // Scroll right by 8 and down by 0, the second tile moves to the left edge
+    ppu.write_register(0x2005, 0x08);
+    ppu.write_register(0x2005, 0x00);
+
+    ppu.write_register(0x2001, emulator::show_background | emulator::show_left_background);
+
+    // The scroll is picked up on the pre-render line
+    ppu.catch_up(27394 + 29781);
+
+    EXPECT_EQ(ppu.framebuffer()[0], 0x16);
+    EXPECT_EQ(ppu.framebuffer()[8], 0x00);
+}
+
+TEST_F(TestPPU, test_horizontal_mirroring)
+{
+    ppu.set_mirroring(emulator::Mirroring::horizontal);
+    ppu.write_vram(0x2001, 0x11);
+    ppu.write_vram(0x2802, 0x22);
+
+    EXPECT_EQ(ppu.read_vram(0x2401), 0x11);
+    EXPECT_EQ(ppu.read_vram(0x2C02), 0x22);
+    EXPECT_EQ(ppu.read_vram(0x2801), 0x00);
+}
+
+TEST_F(TestPPU, test_vertical_mirroring)
+{
+    ppu.set_mirroring(emulator::Mirroring::vertical);
+    ppu.write_vram(0x2001, 0x11);
+    ppu.write_vram(0x2402, 0x22);
+
+    EXPECT_EQ(ppu.read_vram(0x2801), 0x11);
+    EXPECT_EQ(ppu.read_vram(0x2C02), 0x22);
+    EXPECT_EQ(ppu.read_vram(0x2401), 0x00);
+}
+
+TEST_F(TestPPU, test_single_screen_and_four_screen_mirroring)
+{
+    ppu.set_mirroring(emulator::Mirroring::single_screen_high);
+    ppu.write_vram(0x2001, 0x11);
+    EXPECT_EQ(ppu.read_vram(0x2C01), 0x11);
+
+    ppu.set_mirroring(emulator::Mirroring::single_screen_low);
+    EXPECT_EQ(ppu.read_vram(0x2C01), 0x00);
+
+    ppu.set_mirroring(emulator::Mirroring::four_screen);
+    EXPECT_EQ(ppu.read_vram(0x2401), 0x11);
+    EXPECT_EQ(ppu.read_vram(0x3001), 0x00);
+}
+
+TEST_F(TestPPU, test_pattern_rom_is_read_in_place)
+{
+    std::array<uint8_t, 0x400> rom{};
+    rom[0x10] = 0xAB;
+
+    ppu.map_pattern_bank(5, rom.data());
+    ppu.write_vram(0x1410, 0x00);
+
+    EXPECT_EQ(ppu.read_vram(0x1410), 0xAB);
+}
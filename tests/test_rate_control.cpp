@@ -0,0 +1,85 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "apu.h"
+#include "rate_control.h"
+
+TEST(TestRateControl, test_half_full_is_unchanged)
+{
+    emulator::RateControl rate;
+
+    EXPECT_DOUBLE_EQ(rate.update(2048, 4096), 1.0);
+}
+
+TEST(TestRateControl, test_empty_makes_more)
+{
+    emulator::RateControl rate;
+
+    EXPECT_DOUBLE_EQ(rate.update(0, 4096), 1.005);
+}
+
+TEST(TestRateControl, test_full_makes_fewer)
+{
+    emulator::RateControl rate;
+
+    EXPECT_DOUBLE_EQ(rate.update(4096, 4096), 0.995);
+}
+
+TEST(TestRateControl, test_in_between_is_proportional)
+{
+    emulator::RateControl rate(0.01);
+
+    EXPECT_DOUBLE_EQ(rate.update(1024, 4096), 1.005);
+    EXPECT_DOUBLE_EQ(rate.ratio(), 1.005);
+}
+
+TEST(TestRateControl, test_adjusts_samples_per_frame)
+{
+    emulator::APU apu;
+    uint64_t const frame_cycles{29781};
+
+    // Applies from the frame after
+    apu.set_rate_adjustment(1.005);
+    apu.end_frame(frame_cycles);
+
+    std::vector<int16_t> samples(2048);
+    apu.read_samples(samples.data(), apu.samples_available());
+
+    size_t total = 0;
+    for (int frame = 2; frame < 102; frame++)
+    {
+        apu.end_frame(frame_cycles * frame);
+        total += apu.read_samples(samples.data(), std::min(samples.size(), apu.samples_available()));
+    }
+
+    auto const expected = 100.0 * frame_cycles * emulator::default_sample_rate / emulator::cpu_clock_rate;
+    EXPECT_NEAR(total, expected * 1.005, 2.0);
+}
@@ -0,0 +1,200 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <vector>
+
+#include "console.h"
+#include "run_ahead.h"
+
+namespace
+{
+uint8_t const red{0x16};
+
+// Plays a square wave and shows input two frames after the NMI reads it:
+// each NMI first writes the colour picked two frames ago to the backdrop,
+// moves last frame's pick up, then turns it red if A is held
+std::vector<uint8_t> const program{
+    // Reset, 0x8000
+    0xA9, 0x01, 0x8D, 0x15, 0x40, // LDA #$01, STA $4015
+    0xA9, 0xBF, 0x8D, 0x00, 0x40, // LDA #$BF, STA $4000
+    0xA9, 0xFD, 0x8D, 0x02, 0x40, // LDA #$FD, STA $4002
+    0xA9, 0x00, 0x8D, 0x03, 0x40, // LDA #$00, STA $4003
+    0xA9, 0x80, 0x8D, 0x00, 0x20, // LDA #$80, STA $2000
+    0x4C, 0x19, 0x80,             // JMP $8019
+    0xEA, 0xEA, 0xEA, 0xEA,       // NOPs up to 0x8020
+
+    // NMI, 0x8020
+    0xA9, 0x3F, 0x8D, 0x06, 0x20, // LDA #$3F, STA $2006
+    0xA9, 0x00, 0x8D, 0x06, 0x20, // LDA #$00, STA $2006
+    0xA5, 0x02,                   // LDA $02
+    0x8D, 0x07, 0x20,             // STA $2007
+    0xA5, 0x00, 0x85, 0x02,       // LDA $00, STA $02
+    0xA9, 0x01, 0x8D, 0x16, 0x40, // LDA #$01, STA $4016
+    0xA9, 0x00, 0x8D, 0x16, 0x40, // LDA #$00, STA $4016
+    0xAD, 0x16, 0x40,             // LDA $4016
+    0x29, 0x01,                   // AND #$01
+    0xF0, 0x04,                   // BEQ $8048
+    0xA9, red,                    // LDA #red
+    0x85, 0x00,                   // STA $00
+    0xE6, 0x01,                   // INC $01
+    0x40                          // RTI
+};
+
+std::vector<uint8_t> make_image()
+{
+    std::vector<uint8_t> image{'N', 'E', 'S', 0x1A, 1, 1, 0, 0,
+                               0, 0, 0, 0, 0, 0, 0, 0};
+
+    std::vector<uint8_t> prg(0x4000);
+    std::copy(program.begin(), program.end(), prg.begin());
+
+    // NMI and reset vectors
+    prg[0x3FFA] = 0x20;
+    prg[0x3FFB] = 0x80;
+    prg[0x3FFC] = 0x00;
+    prg[0x3FFD] = 0x80;
+
+    image.insert(image.end(), prg.begin(), prg.end());
+    image.resize(image.size() + 0x2000);
+
+    return image;
+}
+
+class TestRunAhead : public ::testing::Test
+{
+public:
+    std::unique_ptr<emulator::ConsoleBase> make()
+    {
+        auto console = emulator::make_console(emulator::Rom(make_image()));
+        console->reset();
+        return console;
+    }
+
+    // Frames shown from pressing A to the backdrop turning red
+    int frames_until_red(uint8_t frames_ahead)
+    {
+        auto console = make();
+        emulator::RunAhead run_ahead(console.get(), frames_ahead);
+
+        for (int frame = 0; frame < 4; frame++)
+        {
+            run_ahead.run_frame();
+        }
+
+        console->controller(0).press(emulator::button_a);
+
+        for (int frame = 1; frame <= 10; frame++)
+        {
+            run_ahead.run_frame();
+
+            if (console->ppu().framebuffer()[0] == red)
+            {
+                return frame;
+            }
+        }
+
+        return -1;
+    }
+};
+}
+
+TEST_F(TestRunAhead, test_each_frame_ahead_is_a_frame_less_latency)
+{
+    auto latency = frames_until_red(0);
+
+    ASSERT_GT(latency, 2);
+    EXPECT_EQ(frames_until_red(1), latency - 1);
+    EXPECT_EQ(frames_until_red(2), latency - 2);
+}
+
+TEST_F(TestRunAhead, test_real_console_is_unchanged)
+{
+    auto plain   = make();
+    auto running = make();
+
+    emulator::RunAhead plain_frames(plain.get(), 0);
+    emulator::RunAhead ahead_frames(running.get(), 2);
+
+    std::vector<int16_t> plain_audio;
+    std::vector<int16_t> ahead_audio;
+
+    auto collect = [] (std::vector<int16_t>& out) {
+        return [&out] (emulator::APU& apu) {
+            auto start = out.size();
+            out.resize(start + apu.samples_available());
+            apu.read_samples(out.data() + start, out.size() - start);
+        };
+    };
+
+    plain_frames.set_audio_handler(collect(plain_audio));
+    ahead_frames.set_audio_handler(collect(ahead_audio));
+
+    for (int frame = 0; frame < 20; frame++)
+    {
+        if (frame == 8)
+        {
+            plain->controller(0).press(emulator::button_a);
+            running->controller(0).press(emulator::button_a);
+        }
+
+        plain_frames.run_frame();
+        ahead_frames.run_frame();
+    }
+
+    emulator::SaveState plain_state;
+    emulator::SaveState ahead_state;
+    plain->save_state(plain_state);
+    running->save_state(ahead_state);
+
+    ASSERT_EQ(plain_state.size(), ahead_state.size());
+    EXPECT_EQ(std::memcmp(plain_state.data(), ahead_state.data(), plain_state.size()), 0);
+
+    ASSERT_FALSE(plain_audio.empty());
+    EXPECT_EQ(plain_audio, ahead_audio);
+}
+
+TEST_F(TestRunAhead, test_no_frames_ahead_saves_nothing)
+{
+    auto console = make();
+    emulator::RunAhead run_ahead(console.get(), 0);
+
+    run_ahead.run_frame();
+
+    EXPECT_EQ(run_ahead.state_size(), 0u);
+}
+
+TEST_F(TestRunAhead, test_frames_ahead_save_the_console)
+{
+    auto console = make();
+    emulator::RunAhead run_ahead(console.get(), 1);
+
+    run_ahead.run_frame();
+
+    EXPECT_GT(run_ahead.state_size(), 0u);
+}
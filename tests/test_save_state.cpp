@@ -0,0 +1,261 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "console.h"
+#include "save_state.h"
+
+namespace
+{
+// prg_8kb banks of PRG, each starting with its own number, spinning in the
+// last one. No CHR means 8KB of CHR RAM.
+std::vector<uint8_t> make_image(uint8_t mapper, uint8_t prg_8kb, uint8_t chr_8kb)
+{
+    std::vector<uint8_t> image{'N', 'E', 'S', 0x1A,
+                               static_cast<uint8_t>(prg_8kb / 2), chr_8kb,
+                               static_cast<uint8_t>(mapper << 4),
+                               static_cast<uint8_t>(mapper & 0xF0),
+                               0, 0, 0, 0, 0, 0, 0, 0};
+
+    std::vector<uint8_t> prg(prg_8kb * 0x2000);
+    for (uint8_t bank = 0; bank < prg_8kb; bank++)
+    {
+        prg[bank * 0x2000] = bank;
+    }
+
+    // JMP $E004, with the reset vector pointing at it
+    auto last = prg.size() - 0x2000;
+    prg[last + 0x0004] = 0x4C;
+    prg[last + 0x0005] = 0x04;
+    prg[last + 0x0006] = 0xE0;
+    prg[last + 0x1FFC] = 0x04;
+    prg[last + 0x1FFD] = 0xE0;
+
+    image.insert(image.end(), prg.begin(), prg.end());
+    image.resize(image.size() + chr_8kb * 0x2000);
+
+    return image;
+}
+
+class TestConsoleState : public ::testing::Test
+{
+public:
+    std::unique_ptr<emulator::ConsoleBase> make(uint8_t mapper, uint8_t prg_8kb = 8, uint8_t chr_8kb = 1)
+    {
+        auto console = emulator::make_console(emulator::Rom(make_image(mapper, prg_8kb, chr_8kb)));
+        console->reset();
+        console->run_frame();
+        return console;
+    }
+
+    emulator::SaveState state;
+};
+}
+
+TEST(TestSaveState, test_reads_back_what_was_written)
+{
+    emulator::SaveState state;
+    uint16_t value{0x1234};
+    uint8_t bytes[] = {1, 2, 3};
+
+    state.write(value);
+    state.write(bytes, sizeof(bytes));
+    state.rewind();
+
+    uint16_t read_value{0};
+    uint8_t read_bytes[3]{};
+
+    state.read(read_value);
+    state.read(read_bytes, sizeof(read_bytes));
+
+    EXPECT_EQ(read_value, 0x1234);
+    EXPECT_EQ(read_bytes[2], 3);
+    EXPECT_EQ(state.size(), 5u);
+}
+
+TEST(TestSaveState, test_read_past_the_end_throws)
+{
+    emulator::SaveState state;
+    uint32_t value{0};
+
+    state.write(uint16_t{1});
+    state.rewind();
+
+    EXPECT_THROW(state.read(value), std::runtime_error);
+}
+
+TEST(TestSaveState, test_clear_starts_over)
+{
+    emulator::SaveState state;
+
+    state.write(uint32_t{1});
+    state.clear();
+    state.write(uint8_t{2});
+
+    EXPECT_EQ(state.size(), 1u);
+}
+
+TEST_F(TestConsoleState, test_load_restores_ram_and_registers)
+{
+    auto console = make(0, 2);
+    auto& cpu    = console->cpu();
+
+    cpu.write8(0x0010, 0xAA);
+    cpu.set_accumulator(0x42);
+    auto cycles = cpu.cycles();
+    console->save_state(state);
+
+    cpu.write8(0x0010, 0x55);
+    cpu.set_accumulator(0x00);
+    console->run_frame();
+
+    console->load_state(state);
+
+    EXPECT_EQ(cpu.read8(0x0010), 0xAA);
+    EXPECT_EQ(cpu.accumulator(), 0x42);
+    EXPECT_EQ(cpu.cycles(), cycles);
+    EXPECT_EQ(console->ppu().timestamp(), cycles);
+}
+
+TEST_F(TestConsoleState, test_load_restores_scheduled_events)
+{
+    auto console = make(0, 2);
+    auto vblank  = console->cpu().scheduler.when(emulator::Event::vblank);
+
+    console->save_state(state);
+    console->run_frame();
+
+    ASSERT_NE(console->cpu().scheduler.when(emulator::Event::vblank), vblank);
+
+    console->load_state(state);
+
+    EXPECT_EQ(console->cpu().scheduler.when(emulator::Event::vblank), vblank);
+}
+
+TEST_F(TestConsoleState, test_load_maps_uxrom_bank_again)
+{
+    auto console = make(2);
+    auto& cpu    = console->cpu();
+
+    console->save_state(state);
+
+    cpu.write8(0x8000, 2);
+    ASSERT_EQ(cpu.read8(0x8000), 4);
+
+    console->load_state(state);
+
+    EXPECT_EQ(cpu.read8(0x8000), 0);
+}
+
+TEST_F(TestConsoleState, test_load_maps_mmc1_bank_again)
+{
+    auto console = make(1);
+    auto& cpu    = console->cpu();
+
+    console->save_state(state);
+
+    // PRG bank 1, a bit at a time
+    for (auto bit : {1, 0, 0, 0, 0})
+    {
+        cpu.write8(0xE000, bit);
+    }
+    ASSERT_EQ(cpu.read8(0x8000), 2);
+
+    console->load_state(state);
+
+    EXPECT_EQ(cpu.read8(0x8000), 0);
+}
+
+TEST_F(TestConsoleState, test_load_maps_mmc3_bank_again)
+{
+    auto console = make(4);
+    auto& cpu    = console->cpu();
+
+    console->save_state(state);
+
+    // R6 at 0x8000
+    cpu.write8(0x8000, 6);
+    cpu.write8(0x8001, 5);
+    ASSERT_EQ(cpu.read8(0x8000), 5);
+
+    console->load_state(state);
+
+    EXPECT_EQ(cpu.read8(0x8000), 0);
+}
+
+TEST_F(TestConsoleState, test_load_restores_chr_ram)
+{
+    auto console = make(0, 2, 0);
+    auto& ppu    = console->ppu();
+
+    ppu.write_vram(0x0000, 0x12);
+    console->save_state(state);
+
+    ppu.write_vram(0x0000, 0x34);
+    console->load_state(state);
+
+    EXPECT_EQ(ppu.read_vram(0x0000), 0x12);
+}
+
+TEST_F(TestConsoleState, test_load_restores_nametables_and_palette)
+{
+    auto console = make(0, 2);
+    auto& ppu    = console->ppu();
+
+    ppu.write_vram(0x2000, 0x01);
+    ppu.write_vram(0x3F00, 0x0F);
+    console->save_state(state);
+
+    ppu.write_vram(0x2000, 0x02);
+    ppu.write_vram(0x3F00, 0x16);
+    console->load_state(state);
+
+    EXPECT_EQ(ppu.read_vram(0x2000), 0x01);
+    EXPECT_EQ(ppu.read_vram(0x3F00), 0x0F);
+}
+
+TEST_F(TestConsoleState, test_save_after_load_is_the_same)
+{
+    auto console = make(4);
+
+    console->save_state(state);
+    std::vector<uint8_t> saved(state.data(), state.data() + state.size());
+
+    console->run_frame();
+    console->run_frame();
+    console->load_state(state);
+
+    emulator::SaveState again;
+    console->save_state(again);
+
+    ASSERT_EQ(again.size(), saved.size());
+    EXPECT_EQ(std::memcmp(again.data(), saved.data(), saved.size()), 0);
+}
@@ -0,0 +1,144 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <vector>
+
+#include "scheduler.h"
+
+namespace
+{
+struct TestScheduler : ::testing::Test
+{
+    TestScheduler()
+    {
+        for (auto i = 0u; i < emulator::number_of_events; i++)
+        {
+            auto event = static_cast<emulator::Event>(i);
+
+            scheduler.set_handler(event, [this, event] (uint64_t when) {
+                fired.push_back({event, when});
+            });
+        }
+    }
+
+    struct Fired
+    {
+        emulator::Event event;
+        uint64_t when;
+    };
+
+    emulator::Scheduler scheduler;
+    std::vector<Fired> fired;
+};
+}
+
+TEST_F(TestScheduler, test_empty_is_never)
+{
+    EXPECT_EQ(scheduler.next(), emulator::Scheduler::never);
+    EXPECT_FALSE(scheduler.is_scheduled(emulator::Event::vblank));
+}
+
+TEST_F(TestScheduler, test_next_is_earliest)
+{
+    scheduler.schedule(emulator::Event::vblank, 300);
+    scheduler.schedule(emulator::Event::mapper_irq, 100);
+    scheduler.schedule(emulator::Event::apu_frame_counter, 200);
+
+    EXPECT_EQ(scheduler.next(), 100u);
+    EXPECT_EQ(scheduler.when(emulator::Event::vblank), 300u);
+}
+
+TEST_F(TestScheduler, test_schedule_again_moves_event)
+{
+    scheduler.schedule(emulator::Event::vblank, 100);
+    scheduler.schedule(emulator::Event::mapper_irq, 200);
+    scheduler.schedule(emulator::Event::vblank, 300);
+
+    EXPECT_EQ(scheduler.next(), 200u);
+
+    scheduler.schedule(emulator::Event::vblank, 50);
+    EXPECT_EQ(scheduler.next(), 50u);
+}
+
+TEST_F(TestScheduler, test_cancel)
+{
+    scheduler.schedule(emulator::Event::vblank, 100);
+    scheduler.schedule(emulator::Event::mapper_irq, 200);
+    scheduler.cancel(emulator::Event::vblank);
+
+    EXPECT_FALSE(scheduler.is_scheduled(emulator::Event::vblank));
+    EXPECT_EQ(scheduler.next(), 200u);
+
+    scheduler.run_due(1000);
+    ASSERT_EQ(fired.size(), 1u);
+    EXPECT_EQ(fired[0].event, emulator::Event::mapper_irq);
+}
+
+TEST_F(TestScheduler, test_run_due_fires_in_order)
+{
+    scheduler.schedule(emulator::Event::mapper_irq, 30);
+    scheduler.schedule(emulator::Event::vblank, 10);
+    scheduler.schedule(emulator::Event::apu_frame_counter, 20);
+    scheduler.schedule(emulator::Event::interrupt, 40);
+
+    scheduler.run_due(30);
+
+    ASSERT_EQ(fired.size(), 3u);
+    EXPECT_EQ(fired[0].event, emulator::Event::vblank);
+    EXPECT_EQ(fired[1].event, emulator::Event::apu_frame_counter);
+    EXPECT_EQ(fired[2].event, emulator::Event::mapper_irq);
+    EXPECT_EQ(fired[2].when, 30u);
+    EXPECT_EQ(scheduler.next(), 40u);
+}
+
+TEST_F(TestScheduler, test_ties_fire_in_event_order)
+{
+    scheduler.schedule(emulator::Event::mapper_irq, 10);
+    scheduler.schedule(emulator::Event::interrupt, 10);
+
+    scheduler.run_due(10);
+
+    ASSERT_EQ(fired.size(), 2u);
+    EXPECT_EQ(fired[0].event, emulator::Event::interrupt);
+}
+
+TEST_F(TestScheduler, test_handler_can_reschedule)
+{
+    int count = 0;
+
+    scheduler.set_handler(emulator::Event::vblank, [&] (uint64_t when) {
+        count++;
+        scheduler.schedule(emulator::Event::vblank, when + 10);
+    });
+
+    scheduler.schedule(emulator::Event::vblank, 0);
+    scheduler.run_due(35);
+
+    EXPECT_EQ(count, 4);
+    EXPECT_EQ(scheduler.next(), 40u);
+}
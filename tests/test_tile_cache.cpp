@@ -0,0 +1,164 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+
+#include "tile_cache.h"
+
+namespace
+{
+struct TestTileCache : ::testing::Test
+{
+    TestTileCache() :
+        cache(banks)
+    {
+        for (uint8_t bank = 0; bank < banks.size(); bank++)
+        {
+            banks[bank] = patterns.data() + bank * emulator::pattern_bank_size;
+        }
+    }
+
+    std::array<uint8_t, 0x2000> patterns{};
+    emulator::PatternBanks banks{};
+    emulator::TileCache cache;
+};
+}
+
+TEST_F(TestTileCache, test_decodes_both_planes)
+{
+    // Tile 1, row 2: low 1010 0000 high 0110 0000
+    patterns[0x0012] = 0xA0;
+    patterns[0x001A] = 0x60;
+
+    auto const* row = cache.row(0x0012);
+
+    EXPECT_EQ(row[0], 1);
+    EXPECT_EQ(row[1], 2);
+    EXPECT_EQ(row[2], 3);
+    EXPECT_EQ(row[3], 0);
+}
+
+TEST_F(TestTileCache, test_second_pattern_table)
+{
+    patterns[0x1FF7] = 0x01;
+
+    EXPECT_EQ(cache.row(0x1FF7)[7], 1);
+}
+
+TEST_F(TestTileCache, test_keeps_decoded_tile_until_invalidated)
+{
+    cache.row(0x0010);
+    patterns[0x0010] = 0xFF;
+
+    EXPECT_EQ(cache.row(0x0010)[0], 0);
+
+    // Writing the high plane drops the tile too
+    cache.invalidate(0x0018);
+
+    EXPECT_EQ(cache.row(0x0010)[0], 1);
+}
+
+TEST_F(TestTileCache, test_invalidate_only_affects_one_tile)
+{
+    cache.row(0x0000);
+    cache.row(0x0010);
+    patterns[0x0000] = 0xFF;
+    patterns[0x0010] = 0xFF;
+
+    cache.invalidate(0x0010);
+
+    EXPECT_EQ(cache.row(0x0000)[0], 0);
+    EXPECT_EQ(cache.row(0x0010)[0], 1);
+}
+
+TEST_F(TestTileCache, test_invalidate_all)
+{
+    cache.row(0x0000);
+    patterns[0x0000] = 0xFF;
+
+    cache.invalidate_all();
+
+    EXPECT_EQ(cache.row(0x0000)[0], 1);
+}
+
+TEST_F(TestTileCache, test_remapped_bank)
+{
+    std::array<uint8_t, 0x400> other{};
+    other[0x0010] = 0xFF;
+
+    cache.row(0x0410);
+
+    banks[1] = other.data();
+    cache.remap_bank(1);
+
+    EXPECT_EQ(cache.row(0x0410)[0], 1);
+}
+
+TEST_F(TestTileCache, test_rom_banks_read_the_decoded_copy)
+{
+    std::array<uint8_t, 0x800> rom{};
+    rom[0x0410] = 0xFF;
+
+    cache.set_rom(rom.data(), rom.size(), emulator::decode_chr(rom.data(), rom.size()));
+
+    banks[0] = rom.data() + 0x400;
+    cache.remap_bank(0);
+    EXPECT_EQ(cache.row(0x0010)[0], 1);
+
+    // Switching away and back decodes nothing, the copy made up front is used
+    rom[0x0410] = 0x00;
+
+    banks[0] = rom.data();
+    cache.remap_bank(0);
+    EXPECT_EQ(cache.row(0x0010)[0], 0);
+
+    banks[0] = rom.data() + 0x400;
+    cache.remap_bank(0);
+    EXPECT_EQ(cache.row(0x0010)[0], 1);
+}
+
+TEST_F(TestTileCache, test_ram_bank_after_rom_bank)
+{
+    std::array<uint8_t, 0x400> rom{};
+    rom[0x0010] = 0xFF;
+
+    cache.set_rom(rom.data(), rom.size(), emulator::decode_chr(rom.data(), rom.size()));
+
+    banks[0] = rom.data();
+    cache.remap_bank(0);
+    cache.row(0x0010);
+
+    // Back to the slot's own tiles, decoded from the RAM
+    banks[0] = patterns.data();
+    cache.remap_bank(0);
+    EXPECT_EQ(cache.row(0x0010)[0], 0);
+
+    patterns[0x0010] = 0xFF;
+    cache.invalidate(0x0010);
+    EXPECT_EQ(cache.row(0x0010)[0], 1);
+}
@@ -0,0 +1,135 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "cpu.h"
+#include "mocks/ppu.h"
+#include "trace.h"
+
+namespace
+{
+emulator::TraceRecord record_at(uint16_t pc)
+{
+    return {pc * 2u, pc, 0xEA, 1, 2, 3, 0x24, 0xFD};
+}
+}
+
+TEST(TestTrace, test_capacity_rounds_up_to_power_of_two)
+{
+    emulator::TraceBuffer trace(100);
+    EXPECT_EQ(trace.capacity(), 128u);
+    EXPECT_EQ(trace.size(), 0u);
+}
+
+TEST(TestTrace, test_records_are_oldest_first)
+{
+    emulator::TraceBuffer trace(4);
+
+    for (uint16_t pc = 0; pc < 3; pc++)
+    {
+        trace.record(record_at(pc));
+    }
+
+    auto records = trace.records();
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].program_counter, 0);
+    EXPECT_EQ(records[2].program_counter, 2);
+}
+
+TEST(TestTrace, test_ring_overwrites_oldest)
+{
+    emulator::TraceBuffer trace(4);
+
+    for (uint16_t pc = 0; pc < 10; pc++)
+    {
+        trace.record(record_at(pc));
+    }
+
+    auto records = trace.records();
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(trace.total(), 10u);
+    EXPECT_EQ(records[0].program_counter, 6);
+    EXPECT_EQ(records[3].program_counter, 9);
+}
+
+TEST(TestTrace, test_save_load_round_trip)
+{
+    emulator::TraceBuffer trace(8);
+
+    for (uint16_t pc = 0; pc < 5; pc++)
+    {
+        trace.record(record_at(pc));
+    }
+
+    std::stringstream stream;
+    trace.save(stream);
+
+    auto records = emulator::TraceBuffer::load(stream);
+    ASSERT_EQ(records.size(), 5u);
+    EXPECT_EQ(records[4].program_counter, 4);
+    EXPECT_EQ(records[4].cycle, 8u);
+    EXPECT_EQ(records[4].stack, 0xFD);
+}
+
+TEST(TestTrace, test_load_rejects_other_files)
+{
+    std::stringstream stream("not a trace file at all");
+    EXPECT_THROW(emulator::TraceBuffer::load(stream), std::runtime_error);
+}
+
+TEST(TestTrace, test_step_records_state_before_each_op)
+{
+    MockPPU ppu;
+    emulator::CPU cpu(&ppu);
+    emulator::TraceBuffer trace(16);
+
+    // Blocks would run all three in one step, tracing still records each
+    cpu.set_core(emulator::CPUCore::cached_blocks);
+
+    // LDA #$42, TAX, INX
+    cpu.write8(0x0, 0xA9);
+    cpu.write8(0x1, 0x42);
+    cpu.write8(0x2, 0xAA);
+    cpu.write8(0x3, 0xE8);
+
+    cpu.step(trace);
+    cpu.step(trace);
+    cpu.step(trace);
+
+    auto records = trace.records();
+    ASSERT_EQ(records.size(), 3u);
+
+    EXPECT_EQ(records[0].program_counter, 0x0);
+    EXPECT_EQ(records[0].op_code, 0xA9);
+    EXPECT_EQ(records[1].program_counter, 0x2);
+    EXPECT_EQ(records[1].accumulator, 0x42);
+    EXPECT_EQ(records[2].x_register, 0x42);
+    EXPECT_EQ(records[2].cycle, records[1].cycle + 2);
+}
@@ -0,0 +1,128 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <thread>
+
+#include "triple_buffer.h"
+
+TEST(TestTripleBuffer, test_nothing_to_update_at_first)
+{
+    emulator::TripleBuffer frames;
+
+    EXPECT_FALSE(frames.update());
+}
+
+TEST(TestTripleBuffer, test_update_picks_up_published_frame)
+{
+    emulator::TripleBuffer frames;
+
+    frames.back()[0] = 0x11223344;
+    frames.publish();
+
+    EXPECT_TRUE(frames.update());
+    EXPECT_EQ(frames.front()[0], 0x11223344u);
+    EXPECT_FALSE(frames.update());
+}
+
+TEST(TestTripleBuffer, test_update_skips_to_newest_frame)
+{
+    emulator::TripleBuffer frames;
+
+    for (uint32_t frame = 1; frame <= 5; frame++)
+    {
+        frames.back()[0] = frame;
+        frames.publish();
+    }
+
+    EXPECT_TRUE(frames.update());
+    EXPECT_EQ(frames.front()[0], 5u);
+    EXPECT_EQ(frames.published(), 5u);
+}
+
+TEST(TestTripleBuffer, test_back_never_aliases_front)
+{
+    emulator::TripleBuffer frames;
+
+    for (int frame = 0; frame < 10; frame++)
+    {
+        frames.publish();
+        EXPECT_NE(&frames.back(), &frames.front());
+
+        frames.update();
+        EXPECT_NE(&frames.back(), &frames.front());
+    }
+}
+
+TEST(TestTripleBuffer, test_frames_arrive_whole_and_in_order)
+{
+    emulator::TripleBuffer frames;
+    uint32_t const total{2000};
+    std::atomic<bool> done{false};
+
+    std::thread producer([&] {
+        for (uint32_t frame = 1; frame <= total; frame++)
+        {
+            frames.back().fill(frame);
+            frames.publish();
+        }
+
+        done = true;
+    });
+
+    uint32_t last = 0;
+    bool torn = false;
+    bool backwards = false;
+
+    for (;;)
+    {
+        // Read first, so the last frame is published before done is seen
+        bool finished = done;
+
+        if (!frames.update())
+        {
+            if (finished)
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        auto const& front = frames.front();
+        torn      |= front.front() != front.back();
+        backwards |= front.front() <= last;
+        last       = front.front();
+    }
+
+    producer.join();
+
+    EXPECT_FALSE(torn);
+    EXPECT_FALSE(backwards);
+    EXPECT_EQ(last, total);
+}
@@ -0,0 +1,97 @@
+//-*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Brandon Schaefer
+ *                    brandontschaefer@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Renders a binary trace written by TraceBuffer::save as text, one line per
+// instruction
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include "cpu_instructions.h"
+#include "trace.h"
+
+namespace
+{
+struct Hex
+{
+    unsigned value;
+    int width;
+};
+
+std::ostream& operator<<(std::ostream& os, Hex const& hex)
+{
+    return os << std::hex << std::setfill('0') << std::setw(hex.width) << hex.value << std::dec;
+}
+
+void print_record(std::ostream& os, emulator::TraceRecord const& record)
+{
+    auto const& info = emulator::instruction[record.op_code];
+
+    os << Hex{record.program_counter, 4} << "  "
+       << Hex{record.op_code, 2} << " "
+       << std::setfill(' ') << std::left << std::setw(4) << info.name
+       << std::setw(12) << emulator::mode_name(static_cast<emulator::OpMode>(info.mode)) << std::right
+       << " A:"  << Hex{record.accumulator, 2}
+       << " X:"  << Hex{record.x_register, 2}
+       << " Y:"  << Hex{record.y_register, 2}
+       << " P:"  << Hex{record.status, 2}
+       << " SP:" << Hex{record.stack, 2}
+       << " CYC:" << record.cycle << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <trace file>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream is(argv[1], std::ifstream::binary);
+
+    if (!is)
+    {
+        std::cerr << "Unable to open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        for (auto const& record : emulator::TraceBuffer::load(is))
+        {
+            print_record(std::cout, record);
+        }
+    }
+    catch (std::runtime_error const& error)
+    {
+        std::cerr << argv[1] << ": " << error.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}